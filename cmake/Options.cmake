@@ -2,3 +2,4 @@
 
 option(BUILD_TESTING "Build & run automated tests." OFF)
 option(BUILD_DOCUMENTATION "Build doxygen documentation." OFF)
+option(ENABLE_AVX2 "Compile with AVX2 instructions, used for 8-wide BVH traversal." OFF)
@@ -0,0 +1,293 @@
+#pragma once
+
+/// \file raytrace/aovImage.h
+///
+/// Auxiliary per-pixel buffers of a render, written alongside its color.
+
+#include <raytrace/exrImageWriter.h>
+#include <raytrace/imageBuffer.h>
+#include <raytrace/pixelStatistics.h>
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec2i.h>
+#include <gm/types/vec2iRange.h>
+#include <gm/types/vec3f.h>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class AOVImage
+///
+/// AOVImage holds the arbitrary output variables (AOVs) of a render: auxiliary per-pixel buffers consumed by
+/// denoisers, compositors and sampling experiments.  Only the requested channels are allocated.
+///
+/// The AOVs are written as a single multi-channel, 32-bit floating point OpenEXR image, see \ref WriteEXRImage.
+class AOVImage
+{
+public:
+    /// \enum Channel
+    ///
+    /// The AOVs which may be requested, as bit flags.
+    enum Channel
+    {
+        Albedo      = 1 << 0, ///< Mean albedo at the first non-specular hit.  Layer "albedo", channels R, G, B.
+        Normal      = 1 << 1, ///< Mean normal at the first non-specular hit.  Layer "normal", channels X, Y, Z.
+        Depth       = 1 << 2, ///< Mean path length to the first non-specular hit.  Channel "Z".
+        ObjectID    = 1 << 3, ///< ID of the object seen through the first sample.  Channel "objectId".
+        SampleCount = 1 << 4, ///< The number of samples taken by the render.  Channel "sampleCount".
+        Variance    = 1 << 5  ///< Variance of the mean luminance of the render.  Channel "variance".
+    };
+
+    /// Explicit constructor with the requested channels, and the dimensions of the image.
+    ///
+    /// \param i_channels The requested channels, as a combination of \ref Channel flags.
+    /// \param i_width The width of the image.
+    /// \param i_height The height of the image.
+    inline explicit AOVImage( int i_channels, int i_width, int i_height )
+        : m_channels( i_channels )
+        , m_width( i_width )
+        , m_height( i_height )
+        , m_albedo( _ChannelWidth( Albedo ), _ChannelHeight( Albedo ) )
+        , m_normal( _ChannelWidth( Normal ), _ChannelHeight( Normal ) )
+        , m_depth( _ChannelWidth( Depth ), _ChannelHeight( Depth ) )
+        , m_objectId( _ChannelWidth( ObjectID ), _ChannelHeight( ObjectID ) )
+        , m_sampleCount( _ChannelWidth( SampleCount ), _ChannelHeight( SampleCount ) )
+        , m_variance( _ChannelWidth( Variance ), _ChannelHeight( Variance ) )
+    {
+    }
+
+    /// Check if the channel \p i_channel was requested.
+    ///
+    /// \param i_channel The channel.
+    ///
+    /// \return Whether the channel was requested.
+    inline bool HasChannel( Channel i_channel ) const
+    {
+        return ( m_channels & i_channel ) != 0;
+    }
+
+    /// Get the extent of the image.
+    ///
+    /// \return The extent.
+    inline gm::Vec2iRange Extent() const
+    {
+        return gm::Vec2iRange( gm::Vec2i( 0, 0 ), gm::Vec2i( m_width, m_height ) );
+    }
+
+    /// Set the AOVs gathered by the samples of the pixel \p i_pixelCoord.  Values of channels which were not
+    /// requested are discarded.
+    ///
+    /// \param i_pixelCoord The pixel coordinate.
+    /// \param i_albedo The mean albedo.
+    /// \param i_normal The mean normal.
+    /// \param i_depth The mean depth.
+    /// \param i_objectId The object ID.
+    inline void SetPixel( const gm::Vec2i& i_pixelCoord,
+                          const gm::Vec3f& i_albedo,
+                          const gm::Vec3f& i_normal,
+                          float            i_depth,
+                          int              i_objectId )
+    {
+        if ( HasChannel( Albedo ) )
+        {
+            m_albedo( i_pixelCoord.X(), i_pixelCoord.Y() ) = i_albedo;
+        }
+
+        if ( HasChannel( Normal ) )
+        {
+            m_normal( i_pixelCoord.X(), i_pixelCoord.Y() ) = i_normal;
+        }
+
+        if ( HasChannel( Depth ) )
+        {
+            m_depth( i_pixelCoord.X(), i_pixelCoord.Y() ) = i_depth;
+        }
+
+        if ( HasChannel( ObjectID ) )
+        {
+            m_objectId( i_pixelCoord.X(), i_pixelCoord.Y() ) = ( float ) i_objectId;
+        }
+    }
+
+    /// Set the sample count and variance AOVs from the statistics of the samples taken by the render for the
+    /// pixel \p i_pixelCoord.
+    ///
+    /// \param i_pixelCoord The pixel coordinate.
+    /// \param i_statistics The statistics of the samples of the pixel.
+    inline void SetStatistics( const gm::Vec2i& i_pixelCoord, const PixelStatistics& i_statistics )
+    {
+        if ( HasChannel( SampleCount ) )
+        {
+            m_sampleCount( i_pixelCoord.X(), i_pixelCoord.Y() ) = ( float ) i_statistics.SampleCount();
+        }
+
+        if ( HasChannel( Variance ) )
+        {
+            m_variance( i_pixelCoord.X(), i_pixelCoord.Y() ) =
+                i_statistics.LuminanceVariance() / ( float ) std::max( i_statistics.SampleCount(), 1 );
+        }
+    }
+
+    /// Get the albedo AOV.
+    inline const RGBImageBuffer& AlbedoBuffer() const
+    {
+        return m_albedo;
+    }
+
+    /// Get the normal AOV.
+    inline const RGBImageBuffer& NormalBuffer() const
+    {
+        return m_normal;
+    }
+
+    /// Get the depth AOV.
+    inline const ImageBuffer< float >& DepthBuffer() const
+    {
+        return m_depth;
+    }
+
+    /// Get the variance AOV.
+    inline const ImageBuffer< float >& VarianceBuffer() const
+    {
+        return m_variance;
+    }
+
+    /// Write the channels \p i_channels, among the requested ones, into file location \p i_filePath, as an
+    /// OpenEXR image.
+    ///
+    /// \param i_filePath file location to save the image.
+    /// \param i_channels The channels to write, as a combination of \ref Channel flags.
+    ///
+    /// \return success of writing the image.
+    inline bool Write( const std::string& i_filePath, int i_channels ) const
+    {
+        auto isWritten = [&]( Channel i_channel ) { return HasChannel( i_channel ) && ( i_channels & i_channel ); };
+
+        std::vector< EXRChannel > channels;
+        if ( isWritten( Albedo ) )
+        {
+            _AppendVectorChannels( "albedo", "RGB", m_albedo, channels );
+        }
+
+        if ( isWritten( Normal ) )
+        {
+            _AppendVectorChannels( "normal", "XYZ", m_normal, channels );
+        }
+
+        if ( isWritten( Depth ) )
+        {
+            channels.push_back( EXRChannel{"Z", m_depth.Data(), 1} );
+        }
+
+        if ( isWritten( ObjectID ) )
+        {
+            channels.push_back( EXRChannel{"objectId", m_objectId.Data(), 1} );
+        }
+
+        if ( isWritten( SampleCount ) )
+        {
+            channels.push_back( EXRChannel{"sampleCount", m_sampleCount.Data(), 1} );
+        }
+
+        if ( isWritten( Variance ) )
+        {
+            channels.push_back( EXRChannel{"variance", m_variance.Data(), 1} );
+        }
+
+        return WriteEXRImage( m_width, m_height, channels, i_filePath );
+    }
+
+private:
+    // The width of the buffer of \p i_channel: the image width if requested, otherwise zero.
+    inline int _ChannelWidth( Channel i_channel ) const
+    {
+        return HasChannel( i_channel ) ? m_width : 0;
+    }
+
+    // The height of the buffer of \p i_channel: the image height if requested, otherwise zero.
+    inline int _ChannelHeight( Channel i_channel ) const
+    {
+        return HasChannel( i_channel ) ? m_height : 0;
+    }
+
+    // Append a channel of the layer \p i_layer, for each component of \p i_buffer, named by \p i_components.
+    static inline void _AppendVectorChannels( const std::string&         i_layer,
+                                              const std::string&         i_components,
+                                              const RGBImageBuffer&      i_buffer,
+                                              std::vector< EXRChannel >& io_channels )
+    {
+        for ( size_t componentIndex = 0; componentIndex < 3; ++componentIndex )
+        {
+            const float* values = &( i_buffer.Data()[ 0 ][ componentIndex ] );
+            io_channels.push_back( EXRChannel{i_layer + '.' + i_components[ componentIndex ], values, 3} );
+        }
+    }
+
+    int m_channels = 0;
+    int m_width    = 0;
+    int m_height   = 0;
+
+    RGBImageBuffer       m_albedo;
+    RGBImageBuffer       m_normal;
+    ImageBuffer< float > m_depth;
+    ImageBuffer< float > m_objectId;
+    ImageBuffer< float > m_sampleCount;
+    ImageBuffer< float > m_variance;
+};
+
+/// Parse the comma separated list of AOV names \p i_aovs, into the \ref AOVImage::Channel flags \p o_channels.
+///
+/// Supported AOV names are "albedo", "normal", "depth", "objectId", "sampleCount" and "variance".
+///
+/// \param i_aovs The comma separated AOV names.  Empty requests no AOVs.
+/// \param o_channels The requested channels.
+///
+/// \return success of parsing the AOVs.  Fails if an AOV name is not recognized.
+inline bool ParseAOVChannels( const std::string& i_aovs, int& o_channels )
+{
+    o_channels = 0;
+
+    std::istringstream stream( i_aovs );
+    std::string        name;
+    while ( std::getline( stream, name, ',' ) )
+    {
+        if ( name == "albedo" )
+        {
+            o_channels |= AOVImage::Albedo;
+        }
+        else if ( name == "normal" )
+        {
+            o_channels |= AOVImage::Normal;
+        }
+        else if ( name == "depth" )
+        {
+            o_channels |= AOVImage::Depth;
+        }
+        else if ( name == "objectId" )
+        {
+            o_channels |= AOVImage::ObjectID;
+        }
+        else if ( name == "sampleCount" )
+        {
+            o_channels |= AOVImage::SampleCount;
+        }
+        else if ( name == "variance" )
+        {
+            o_channels |= AOVImage::Variance;
+        }
+        else
+        {
+            std::cerr << "Unrecognized AOV: " << name << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,37 @@
+#pragma once
+
+/// \file raytrace/aovSample.h
+///
+/// The arbitrary output variables gathered along a single camera ray.
+
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec3f.h>
+
+RAYTRACE_NS_OPEN
+
+/// \class AOVSample
+///
+/// AOVSample stores the arbitrary output variables (AOVs) of a single camera ray, gathered at its first
+/// non-specular hit.  See \ref Integrator::ComputeRayAOVs.
+class AOVSample
+{
+public:
+    /// The albedo of the surface, tinted by the specular surfaces on the way to it.  The background color if
+    /// the ray escaped the scene.
+    gm::Vec3f m_albedo;
+
+    /// The outward facing normal of the surface.  Zero if the ray escaped the scene.
+    gm::Vec3f m_normal;
+
+    /// The length of the path from the camera to the surface.
+    float m_depth = 0.0f;
+
+    /// The ID of the scene object which was hit, see \ref SceneObject::ObjectId.
+    int m_objectId = -1;
+
+    /// Whether the ray hit a non-specular surface.
+    bool m_isHit = false;
+};
+
+RAYTRACE_NS_CLOSE
@@ -7,6 +7,7 @@
 #include <raytrace/ray.h>
 
 #include <gm/functions/linearInterpolation.h>
+#include <gm/functions/linearMap.h>
 
 #include <gm/types/floatRange.h>
 #include <gm/types/intRange.h>
@@ -0,0 +1,184 @@
+#pragma once
+
+/// \file raytrace/axisAlignedRect.h
+///
+/// Representation of a rectangle lying in a plane perpendicular to a coordinate axis.
+
+#include <raytrace/hitRecord.h>
+#include <raytrace/material.h>
+#include <raytrace/ray.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/functions/contains.h>
+#include <gm/functions/faceForward.h>
+
+#include <gm/types/vec2f.h>
+#include <gm/types/vec2fRange.h>
+#include <gm/types/vec3f.h>
+#include <gm/types/vec3fRange.h>
+
+RAYTRACE_NS_OPEN
+
+/// \class AxisAlignedRect
+///
+/// AxisAlignedRect is a rectangle lying in the plane where the coordinate along axis \p NormalAxisT is constant.
+///
+/// Unlike a flattened \ref Box, a ray is intersected against a single plane, and the rectangle exposes its area
+/// and can be sampled, such that it is a cheap area light.  The rectangle has no inside: its normal faces the
+/// incident ray.
+///
+/// \tparam NormalAxisT The axis perpendicular to the rectangle: 0 for X, 1 for Y, 2 for Z.
+template < int NormalAxisT >
+class AxisAlignedRect : public SceneObject
+{
+public:
+    /// Construct a static rectangle.
+    ///
+    /// \param i_bounds The bounds of the rectangle along the two other axes, in increasing axis order.  For
+    /// example, the X and Z coordinates of a rectangle perpendicular to the Y axis.
+    /// \param i_offset The coordinate of the plane of the rectangle, along \p NormalAxisT.
+    /// \param i_material Optional material assigned to the rectangle.
+    inline explicit AxisAlignedRect( const gm::Vec2fRange& i_bounds,
+                                     float                 i_offset,
+                                     MaterialSharedPtr     i_material = nullptr )
+        : m_bounds( i_bounds )
+        , m_offset( i_offset )
+        , m_material( i_material )
+    {
+    }
+
+    virtual inline bool
+    Hit( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const override
+    {
+        float magnitude;
+        if ( !_Intersect( i_ray, i_magnitudeRange, magnitude ) )
+        {
+            return false;
+        }
+
+        o_record.m_magnitude = magnitude;
+        o_record.m_material  = m_material.get();
+        o_record.m_object    = this;
+        return true;
+    }
+
+    virtual inline bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const override
+    {
+        float magnitude;
+        return _Intersect( i_ray, i_magnitudeRange, magnitude );
+    }
+
+    virtual inline void ComputeSurfaceInteraction( const raytrace::Ray& i_ray, HitRecord& io_record ) const override
+    {
+        io_record.m_position = i_ray.Origin() + i_ray.Direction() * io_record.m_magnitude;
+        io_record.m_position[ NormalAxisT ] = m_offset;
+        io_record.m_normal   = gm::FaceForward( c_normal, -i_ray.Direction() );
+        io_record.m_uv       = _ComputeUV( io_record.m_position );
+    }
+
+    virtual inline gm::Vec3fRange Extent( const std::vector< float >& i_times ) const override
+    {
+        // Pad the extent along the normal, such that it is not degenerate.
+        gm::Vec3f min = _PlanePoint( m_bounds.Min() );
+        gm::Vec3f max = _PlanePoint( m_bounds.Max() );
+        min[ NormalAxisT ] -= c_extentPadding;
+        max[ NormalAxisT ] += c_extentPadding;
+        return gm::Vec3fRange( min, max );
+    }
+
+    virtual inline const Material* SurfaceMaterial() const override
+    {
+        return m_material.get();
+    }
+
+    virtual inline float Area( float i_time ) const override
+    {
+        gm::Vec2f size = m_bounds.Max() - m_bounds.Min();
+        return size[ 0 ] * size[ 1 ];
+    }
+
+    virtual inline bool SampleSurface( const gm::Vec2f& i_sample, float i_time, HitRecord& o_record ) const override
+    {
+        gm::Vec2f size = m_bounds.Max() - m_bounds.Min();
+        o_record.m_position =
+            _PlanePoint( gm::Vec2f( m_bounds.Min()[ 0 ] + i_sample[ 0 ] * size[ 0 ],
+                                    m_bounds.Min()[ 1 ] + i_sample[ 1 ] * size[ 1 ] ) );
+        o_record.m_normal   = c_normal;
+        o_record.m_uv       = i_sample;
+        o_record.m_material = m_material.get();
+        o_record.m_object   = this;
+        return true;
+    }
+
+private:
+    // The two axes spanning the plane of the rectangle, in increasing order.
+    static constexpr int c_firstAxis  = NormalAxisT == 0 ? 1 : 0;
+    static constexpr int c_secondAxis = NormalAxisT == 2 ? 1 : 2;
+
+    // Half of the thickness of the extent of the rectangle.
+    static constexpr float c_extentPadding = 0.0001f;
+
+    // The normal, along the positive axis.
+    static const gm::Vec3f c_normal;
+
+    // Intersect \p i_ray with the plane of the rectangle, and check that the hit lies within the rectangle, and
+    // \p i_magnitudeRange.
+    inline bool
+    _Intersect( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange, float& o_magnitude ) const
+    {
+        // A ray parallel to the plane produces an infinite or undefined magnitude, which is not contained.
+        o_magnitude = ( m_offset - i_ray.Origin()[ NormalAxisT ] ) / i_ray.Direction()[ NormalAxisT ];
+        if ( !gm::Contains( i_magnitudeRange, o_magnitude ) )
+        {
+            return false;
+        }
+
+        gm::Vec2f planeCoord( i_ray.Origin()[ c_firstAxis ] + o_magnitude * i_ray.Direction()[ c_firstAxis ],
+                              i_ray.Origin()[ c_secondAxis ] + o_magnitude * i_ray.Direction()[ c_secondAxis ] );
+        return gm::Contains( m_bounds, planeCoord );
+    }
+
+    // The point of the plane with coordinates \p i_planeCoord along the two spanning axes.
+    inline gm::Vec3f _PlanePoint( const gm::Vec2f& i_planeCoord ) const
+    {
+        gm::Vec3f point;
+        point[ NormalAxisT ]  = m_offset;
+        point[ c_firstAxis ]  = i_planeCoord[ 0 ];
+        point[ c_secondAxis ] = i_planeCoord[ 1 ];
+        return point;
+    }
+
+    // Texture coordinates of \p i_position, normalized across the rectangle.
+    inline gm::Vec2f _ComputeUV( const gm::Vec3f& i_position ) const
+    {
+        gm::Vec2f size = m_bounds.Max() - m_bounds.Min();
+        return gm::Vec2f( ( i_position[ c_firstAxis ] - m_bounds.Min()[ 0 ] ) / size[ 0 ],
+                          ( i_position[ c_secondAxis ] - m_bounds.Min()[ 1 ] ) / size[ 1 ] );
+    }
+
+    gm::Vec2fRange    m_bounds;
+    float             m_offset = 0.0f;
+    MaterialSharedPtr m_material;
+};
+
+template < int NormalAxisT >
+const gm::Vec3f AxisAlignedRect< NormalAxisT >::c_normal( NormalAxisT == 0 ? 1.0f : 0.0f,
+                                                           NormalAxisT == 1 ? 1.0f : 0.0f,
+                                                           NormalAxisT == 2 ? 1.0f : 0.0f );
+
+/// \typedef XYRect
+///
+/// Rectangle perpendicular to the Z axis, bounded along X and Y.
+using XYRect = AxisAlignedRect< 2 >;
+
+/// \typedef XZRect
+///
+/// Rectangle perpendicular to the Y axis, bounded along X and Z.
+using XZRect = AxisAlignedRect< 1 >;
+
+/// \typedef YZRect
+///
+/// Rectangle perpendicular to the X axis, bounded along Y and Z.
+using YZRect = AxisAlignedRect< 0 >;
+
+RAYTRACE_NS_CLOSE
@@ -19,6 +19,8 @@
 #include <gm/functions/rayAABBIntersection.h>
 #include <gm/functions/rayPosition.h>
 
+#include <algorithm>
+
 RAYTRACE_NS_OPEN
 
 /// \class Box
@@ -61,12 +63,12 @@ public:
         {
             if ( gm::Contains( i_magnitudeRange, intersections.Min() ) )
             {
-                _RecordHit( i_ray, intersections.Min(), o_record );
+                _RecordHit( intersections.Min(), o_record );
                 return true;
             }
             else if ( gm::Contains( i_magnitudeRange, intersections.Max() ) )
             {
-                _RecordHit( i_ray, intersections.Max(), o_record );
+                _RecordHit( intersections.Max(), o_record );
                 return true;
             }
         }
@@ -74,6 +76,21 @@ public:
         return false;
     }
 
+    virtual inline bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const override
+    {
+        gm::FloatRange intersections;
+        return gm::RayAABBIntersection(
+                   i_ray.Origin(), i_ray.Direction(), _ComputeAABB( i_ray.Time() ), intersections ) &&
+               ( gm::Contains( i_magnitudeRange, intersections.Min() ) ||
+                 gm::Contains( i_magnitudeRange, intersections.Max() ) );
+    }
+
+    virtual inline void ComputeSurfaceInteraction( const raytrace::Ray& i_ray, HitRecord& io_record ) const override
+    {
+        io_record.m_position = gm::RayPosition( i_ray.Origin(), i_ray.Direction(), io_record.m_magnitude );
+        _ComputeNormalAndUV( io_record.m_position, i_ray.Time(), io_record.m_normal, io_record.m_uv );
+    }
+
     virtual inline gm::Vec3fRange Extent( const std::vector< float >& i_times ) const override
     {
         gm::Vec3fRange extent;
@@ -84,6 +101,58 @@ public:
         return extent;
     }
 
+    virtual inline const Material* SurfaceMaterial() const override
+    {
+        return m_material.get();
+    }
+
+    virtual inline float Area( float i_time ) const override
+    {
+        gm::Vec3f dimensions = m_dimensions.Value( i_time );
+        return 2.0f * ( dimensions.X() * dimensions.Y() + dimensions.Y() * dimensions.Z() +
+                        dimensions.Z() * dimensions.X() );
+    }
+
+    virtual inline bool SampleSurface( const gm::Vec2f& i_sample, float i_time, HitRecord& o_record ) const override
+    {
+        gm::Vec3f dimensions = m_dimensions.Value( i_time );
+        gm::Vec3f halfDims   = dimensions * 0.5f;
+
+        // Select a side, proportional to its area, then a point on the side.  The first sample dimension is split
+        // into the selection of the side, and the first coordinate on the side.
+        float sideAreas[ 3 ] = {dimensions.Y() * dimensions.Z(),  // X sides.
+                                dimensions.Z() * dimensions.X(),  // Y sides.
+                                dimensions.X() * dimensions.Y()}; // Z sides.
+        float totalArea      = 2.0f * ( sideAreas[ 0 ] + sideAreas[ 1 ] + sideAreas[ 2 ] );
+        if ( totalArea <= 0.0f )
+        {
+            return false;
+        }
+
+        float selection = i_sample[ 0 ] * totalArea;
+        int   side      = 0;
+        while ( side < 5 && selection >= sideAreas[ side / 2 ] )
+        {
+            selection -= sideAreas[ side / 2 ];
+            ++side;
+        }
+
+        int       axis         = side / 2;
+        int       firstAxis    = ( axis + 1 ) % 3;
+        int       secondAxis   = ( axis + 2 ) % 3;
+        float     firstSample  = sideAreas[ axis ] > 0.0f ? std::min( selection / sideAreas[ axis ], 1.0f ) : 0.0f;
+        gm::Vec3f offset;
+        offset[ axis ]       = ( side % 2 == 0 ) ? halfDims[ axis ] : -halfDims[ axis ];
+        offset[ firstAxis ]  = ( 2.0f * firstSample - 1.0f ) * halfDims[ firstAxis ];
+        offset[ secondAxis ] = ( 2.0f * i_sample[ 1 ] - 1.0f ) * halfDims[ secondAxis ];
+
+        o_record.m_position = m_origin.Value( i_time ) + offset;
+        _ComputeNormalAndUV( o_record.m_position, i_time, o_record.m_normal, o_record.m_uv );
+        o_record.m_material = m_material.get();
+        o_record.m_object   = this;
+        return true;
+    }
+
 private:
     // Compute an axis-aligned bounding box based on box origin and dimensions.
     gm::Vec3fRange _ComputeAABB( float i_time ) const
@@ -93,13 +162,13 @@ private:
         return gm::Vec3fRange( origin - halfDims, origin + halfDims );
     }
 
-    // Helper method to record a ray hitting the box.
-    inline void _RecordHit( const raytrace::Ray& i_ray, float i_rayMagnitude, HitRecord& o_record ) const
+    // Helper method to record a ray hitting the box.  Surface attributes are deferred to
+    // \ref ComputeSurfaceInteraction.
+    inline void _RecordHit( float i_rayMagnitude, HitRecord& o_record ) const
     {
-        o_record.m_position = gm::RayPosition( i_ray.Origin(), i_ray.Direction(), i_rayMagnitude );
-        _ComputeNormalAndUV( o_record.m_position, i_ray.Time(), o_record.m_normal, o_record.m_uv );
         o_record.m_magnitude = i_rayMagnitude;
-        o_record.m_material  = m_material;
+        o_record.m_material  = m_material.get();
+        o_record.m_object    = this;
     }
 
     // Helper method to compute the normal of the hit, based on position.
@@ -0,0 +1,153 @@
+#pragma once
+
+/// \file raytrace/bvh.h
+///
+/// Construction of the bounding volume hierarchy selected by the render settings.
+
+#include <raytrace/bvhBuilder.h>
+#include <raytrace/bvhNode.h>
+#include <raytrace/lbvhBuilder.h>
+#include <raytrace/linearBVH.h>
+#include <raytrace/motionBVH.h>
+#include <raytrace/renderSettings.h>
+#include <raytrace/sahBVHBuilder.h>
+#include <raytrace/sceneObject.h>
+#include <raytrace/sceneObjectList.h>
+#include <raytrace/spatialBVH.h>
+#include <raytrace/wideBVH.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// Create the bounding volume hierarchy builder described by \p i_settings.
+///
+/// Supported values of \ref RenderSettings::m_bvhBuilder are:
+/// - "sah": binned Surface Area Heuristic build, via \ref SAHBVHBuilder.
+/// - "lbvh": Morton code sorted linear build, via \ref LBVHBuilder.
+///
+/// \param i_settings The render settings.
+///
+/// \return The builder, or null if the builder type is not recognized.
+inline std::unique_ptr< BVHBuilder > CreateBVHBuilder( const RenderSettings& i_settings )
+{
+    if ( i_settings.m_bvhBuilder == "sah" )
+    {
+        return std::unique_ptr< BVHBuilder >(
+            new SAHBVHBuilder( i_settings.m_bvhBinCount, i_settings.m_bvhLeafSize, i_settings.m_threadCount ) );
+    }
+    else if ( i_settings.m_bvhBuilder == "lbvh" )
+    {
+        return std::unique_ptr< BVHBuilder >( new LBVHBuilder( i_settings.m_bvhLeafSize, i_settings.m_threadCount ) );
+    }
+
+    std::cerr << "Unrecognized BVH builder: " << i_settings.m_bvhBuilder << std::endl;
+    return nullptr;
+}
+
+/// Build a bounding volume hierarchy over \p i_sceneObjects, with the BVH type and parameters
+/// described by \p i_settings.
+///
+/// Supported values of \ref RenderSettings::m_bvh are:
+/// - "linear": built tree, flattened into a \ref LinearBVH.
+/// - "bvh4" / "bvh8": built tree, collapsed into a \ref WideBVH with 4 or 8 children per node.
+/// - "motion": tree built per time range, as a \ref MotionBVH with node extents sampled at
+///   \ref RenderSettings::m_motionKeyframeCount keyframes.
+/// - "sah": built tree, as a tree of \ref BVHNode.
+/// - "spatial": spatial midpoint partitioning, via \ref SpatialBVHNode.
+/// - "none": no acceleration structure, every object is tested via \ref SceneObjectList.
+///
+/// Except for "spatial" and "none", the tree is built with the builder selected by
+/// \ref RenderSettings::m_bvhBuilder, via \ref CreateBVHBuilder.
+///
+/// If debugging is enabled, the build time and expected SAH cost of the built tree are printed.
+///
+/// Each scene object is assigned its index in \p i_sceneObjects as its object ID, see \ref SceneObject::ObjectId.
+///
+/// \param i_sceneObjects The scene objects to build the BVH for.
+/// \param i_settings The render settings.
+///
+/// \return The root object of the BVH, or null if the BVH or builder type is not recognized.
+inline SceneObjectPtr BuildBVH( const SceneObjectPtrs& i_sceneObjects, const RenderSettings& i_settings )
+{
+    for ( size_t objectIndex = 0; objectIndex < i_sceneObjects.size(); ++objectIndex )
+    {
+        i_sceneObjects[ objectIndex ]->SetObjectId( ( int ) objectIndex );
+    }
+
+    std::vector< float > times = {i_settings.m_shutterRange.Min(), i_settings.m_shutterRange.Max()};
+
+    if ( i_settings.m_bvh == "spatial" )
+    {
+        return std::make_shared< SpatialBVHNode >( i_sceneObjects, times );
+    }
+    else if ( i_settings.m_bvh == "none" )
+    {
+        return std::make_shared< SceneObjectList >( i_sceneObjects );
+    }
+    else if ( i_settings.m_bvh != "linear" && i_settings.m_bvh != "bvh4" && i_settings.m_bvh != "bvh8" &&
+              i_settings.m_bvh != "sah" && i_settings.m_bvh != "motion" )
+    {
+        std::cerr << "Unrecognized BVH type: " << i_settings.m_bvh << std::endl;
+        return nullptr;
+    }
+
+    std::unique_ptr< BVHBuilder > builder = CreateBVHBuilder( i_settings );
+    if ( !builder )
+    {
+        return nullptr;
+    }
+
+    std::chrono::steady_clock::time_point buildStart = std::chrono::steady_clock::now();
+    auto                                  buildTime  = [&]() {
+        return std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - buildStart ).count();
+    };
+    if ( i_settings.m_bvh == "motion" )
+    {
+        std::shared_ptr< MotionBVH > motionBVH = std::make_shared< MotionBVH >(
+            i_sceneObjects, i_settings.m_shutterRange, i_settings.m_motionKeyframeCount, *builder );
+        if ( i_settings.m_debug )
+        {
+            std::cout << "BVH build time: " << buildTime() << "ms" << std::endl;
+            std::cout << "Motion BVH time ranges: " << motionBVH->TimeRangeCount() << std::endl;
+        }
+
+        return motionBVH;
+    }
+
+    SceneObjectPtrs                 orderedObjects;
+    std::unique_ptr< BVHBuildNode > root = builder->Build( i_sceneObjects, times, orderedObjects );
+    if ( !root )
+    {
+        return std::make_shared< SceneObjectList >( i_sceneObjects );
+    }
+
+    if ( i_settings.m_debug )
+    {
+        std::cout << "BVH build time: " << buildTime() << "ms" << std::endl;
+        std::cout << "BVH expected SAH cost: " << builder->ExpectedCost( *root ) << std::endl;
+    }
+
+    if ( i_settings.m_bvh == "linear" )
+    {
+        return std::make_shared< LinearBVH >( *root, orderedObjects );
+    }
+    else if ( i_settings.m_bvh == "bvh4" )
+    {
+        return std::make_shared< BVH4 >( *root, orderedObjects );
+    }
+    else if ( i_settings.m_bvh == "bvh8" )
+    {
+        return std::make_shared< BVH8 >( *root, orderedObjects );
+    }
+    else
+    {
+        return BVHNode::FromBuildTree( *root, orderedObjects );
+    }
+}
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,124 @@
+#pragma once
+
+/// \file raytrace/bvhBuildNode.h
+///
+/// Intermediate bounding volume hierarchy representation, produced by the BVH builders.
+
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec3fRange.h>
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \var c_bvhMaxLeafSize
+///
+/// The maximum number of objects which a leaf of a build tree may hold, such that the object count fits the
+/// 16-bit field of the flattened nodes.
+constexpr int c_bvhMaxLeafSize = std::numeric_limits< uint16_t >::max();
+
+/// \var c_bvhMaxDepth
+///
+/// The maximum number of interior nodes along any path from the root of a build tree to a leaf.
+///
+/// The traversals defer children onto fixed size stacks, which are sized by this depth.
+constexpr int c_bvhMaxDepth = 64;
+
+/// \class BVHBuildNode
+///
+/// BVHBuildNode is a single node of a binary BVH tree, as produced by a BVH builder.
+///
+/// The build tree does not reference scene objects directly.  Instead, leaf nodes describe a contiguous
+/// range of a separate, builder-ordered, scene object array.  The build tree is an intermediate
+/// representation, to be converted into a traversable acceleration structure such as \ref BVHNode.
+class BVHBuildNode
+{
+public:
+    /// Check if this node is a leaf.
+    ///
+    /// \return true if this node is a leaf, referencing scene objects.
+    inline bool IsLeaf() const
+    {
+        return m_objectCount > 0;
+    }
+
+    /// The extent encompassing all the objects under this node.
+    gm::Vec3fRange m_extent;
+
+    /// Left & right children.  Only set for interior nodes.
+    std::unique_ptr< BVHBuildNode > m_children[ 2 ];
+
+    /// The axis which the objects were partitioned along.  Only set for interior nodes.
+    int m_splitAxis = 0;
+
+    /// The offset of the first object, into the ordered object array.  Only set for leaf nodes.
+    int m_objectOffset = 0;
+
+    /// The number of objects in this leaf.  Zero for interior nodes.
+    int m_objectCount = 0;
+};
+
+/// Compute the surface area of an extent.
+///
+/// \param i_extent The extent.
+///
+/// \return The surface area, or 0 if the extent is empty.
+inline float SurfaceArea( const gm::Vec3fRange& i_extent )
+{
+    if ( i_extent.IsEmpty() )
+    {
+        return 0.0f;
+    }
+
+    gm::Vec3f diagonal = i_extent.Max() - i_extent.Min();
+    return 2.0f * ( diagonal[ 0 ] * diagonal[ 1 ] + diagonal[ 1 ] * diagonal[ 2 ] + diagonal[ 2 ] * diagonal[ 0 ] );
+}
+
+/// Compute the expected cost of tracing a ray through the tree rooted at \p i_node, as modeled by the
+/// Surface Area Heuristic.
+///
+/// The probability of a ray visiting a node is approximated by the ratio of its surface area against the
+/// surface area of the root node.
+///
+/// \param i_node The root node of the tree.
+/// \param i_traversalCost The cost of visiting an interior node.
+/// \param i_intersectionCost The cost of intersecting a single object.
+///
+/// \return The expected cost of tracing a ray.
+inline float ComputeSAHCost( const BVHBuildNode& i_node, float i_traversalCost, float i_intersectionCost )
+{
+    float rootArea = SurfaceArea( i_node.m_extent );
+    if ( rootArea <= 0.0f )
+    {
+        return i_node.IsLeaf() ? i_node.m_objectCount * i_intersectionCost : i_traversalCost;
+    }
+
+    // Accumulate the area weighted cost of every node, via an explicit stack.
+    float                              cost = 0.0f;
+    std::vector< const BVHBuildNode* > stack( 1, &i_node );
+    while ( !stack.empty() )
+    {
+        const BVHBuildNode* node = stack.back();
+        stack.pop_back();
+
+        float probability = SurfaceArea( node->m_extent ) / rootArea;
+        if ( node->IsLeaf() )
+        {
+            cost += probability * node->m_objectCount * i_intersectionCost;
+        }
+        else
+        {
+            cost += probability * i_traversalCost;
+            stack.push_back( node->m_children[ 0 ].get() );
+            stack.push_back( node->m_children[ 1 ].get() );
+        }
+    }
+
+    return cost;
+}
+
+RAYTRACE_NS_CLOSE
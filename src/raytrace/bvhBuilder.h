@@ -0,0 +1,136 @@
+#pragma once
+
+/// \file raytrace/bvhBuilder.h
+///
+/// Abstract base class of the bounding volume hierarchy builders.
+
+#include <raytrace/bvhBuildNode.h>
+#include <raytrace/sceneObject.h>
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class BVHBuilder
+///
+/// BVHBuilder constructs a binary \ref BVHBuildNode tree over a collection of scene objects.
+///
+/// Builders may use multiple threads.  Subtrees over disjoint ranges of objects are independent, so they
+/// are built concurrently once a range is large enough to be worth a thread.  The resulting tree does not
+/// depend on the number of threads.
+class BVHBuilder
+{
+public:
+    /// Explicit constructor with the number of threads, and the cost model of the built trees.
+    ///
+    /// \param i_threadCount The number of threads to build with.  If zero or negative, the number of
+    /// concurrent threads supported by the hardware is used.
+    /// \param i_traversalCost The relative cost of visiting an interior node.
+    /// \param i_intersectionCost The relative cost of intersecting a single object.
+    inline explicit BVHBuilder( int i_threadCount, float i_traversalCost, float i_intersectionCost )
+        : m_threadCount( i_threadCount )
+        , m_traversalCost( i_traversalCost )
+        , m_intersectionCost( i_intersectionCost )
+    {
+        if ( m_threadCount <= 0 )
+        {
+            m_threadCount = std::max( 1, ( int ) std::thread::hardware_concurrency() );
+        }
+    }
+
+    virtual ~BVHBuilder() = default;
+
+    /// Build a BVH tree for a collection of scene objects.
+    ///
+    /// \param i_sceneObjects Scene objects to build the BVH for.
+    /// \param i_times Time samples to compute extents for.
+    /// \param o_orderedObjects The scene objects, re-ordered such that each leaf references a contiguous range.
+    ///
+    /// \return The root node of the build tree, or null if \p i_sceneObjects is empty.
+    virtual std::unique_ptr< BVHBuildNode > Build( const SceneObjectPtrs&      i_sceneObjects,
+                                                   const std::vector< float >& i_times,
+                                                   SceneObjectPtrs&            o_orderedObjects ) const = 0;
+
+    /// Compute the expected cost of tracing a ray through a tree produced by this builder.
+    ///
+    /// \param i_root The root node of the build tree.
+    ///
+    /// \return The expected SAH cost.
+    inline float ExpectedCost( const BVHBuildNode& i_root ) const
+    {
+        return ComputeSAHCost( i_root, m_traversalCost, m_intersectionCost );
+    }
+
+    /// Get the number of threads used for building.
+    inline int ThreadCount() const
+    {
+        return m_threadCount;
+    }
+
+protected:
+    // Minimum number of objects in a range, for work on it to be handed to another thread.
+    static constexpr int c_minParallelObjectCount = 4096;
+
+    // Invoke \p i_rangeFunction over consecutive, disjoint ranges of [0, \p i_count), in parallel.
+    //
+    // \p i_rangeFunction has the signature void( int i_begin, int i_end ).
+    template < typename RangeFunctionT >
+    inline void _ParallelFor( int i_count, const RangeFunctionT& i_rangeFunction ) const
+    {
+        int workerCount = std::min( m_threadCount, std::max( 1, i_count / ( int ) c_minParallelObjectCount ) );
+        if ( workerCount <= 1 )
+        {
+            i_rangeFunction( 0, i_count );
+            return;
+        }
+
+        // The calling thread processes the first range.
+        std::vector< std::thread > threads;
+        threads.reserve( workerCount - 1 );
+        for ( int workerIndex = 1; workerIndex < workerCount; ++workerIndex )
+        {
+            threads.push_back( std::thread( [&, workerIndex]() {
+                i_rangeFunction( ( int ) ( ( long long ) i_count * workerIndex / workerCount ),
+                                 ( int ) ( ( long long ) i_count * ( workerIndex + 1 ) / workerCount ) );
+            } ) );
+        }
+
+        i_rangeFunction( 0, ( int ) ( ( long long ) i_count / workerCount ) );
+        for ( std::thread& thread : threads )
+        {
+            thread.join();
+        }
+    }
+
+    // Invoke \p i_leftFunction and \p i_rightFunction, concurrently if \p i_threadBudget allows for it and
+    // there are enough objects to be worth a thread.  The thread budget is divided between both sides.
+    //
+    // Both functions have the signature void( int i_threadBudget ).
+    template < typename LeftFunctionT, typename RightFunctionT >
+    static inline void _ForkJoin( int                   i_threadBudget,
+                                  int                   i_objectCount,
+                                  const LeftFunctionT&  i_leftFunction,
+                                  const RightFunctionT& i_rightFunction )
+    {
+        if ( i_threadBudget <= 1 || i_objectCount < c_minParallelObjectCount )
+        {
+            i_leftFunction( 1 );
+            i_rightFunction( 1 );
+            return;
+        }
+
+        int         leftBudget = i_threadBudget / 2;
+        std::thread leftThread( [&]() { i_leftFunction( leftBudget ); } );
+        i_rightFunction( i_threadBudget - leftBudget );
+        leftThread.join();
+    }
+
+    int   m_threadCount      = 1;
+    float m_traversalCost    = 0.0f;
+    float m_intersectionCost = 0.0f;
+};
+
+RAYTRACE_NS_CLOSE
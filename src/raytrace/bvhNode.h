@@ -0,0 +1,122 @@
+#pragma once
+
+/// \file raytrace/bvhNode.h
+///
+/// Bounding volume hierarchy acceleration structure, converted from a BVH build tree.
+
+#include <raytrace/bvhBuildNode.h>
+#include <raytrace/hitRecord.h>
+#include <raytrace/sceneObject.h>
+#include <raytrace/sceneObjectList.h>
+
+#include <gm/functions/rayAABBIntersection.h>
+
+RAYTRACE_NS_OPEN
+
+/// \class BVHNode
+///
+/// BVHNode is a single interior node in the bounding volume hierarchy.
+///
+/// BVHNode trees are converted from a \ref BVHBuildNode tree, produced by one of the BVH builders, such
+/// as \ref SAHBVHBuilder.  Leaves holding a single object are represented by the object itself, while leaves
+/// holding multiple objects are represented by a \ref SceneObjectList.
+class BVHNode : public SceneObject
+{
+public:
+    /// Convert a build tree into a tree of scene objects.
+    ///
+    /// \param i_buildNode The root node of the build tree.
+    /// \param i_orderedObjects The ordered scene objects, which leaves of the build tree reference.
+    ///
+    /// \return The root scene object.
+    static inline SceneObjectPtr FromBuildTree( const BVHBuildNode&    i_buildNode,
+                                                const SceneObjectPtrs& i_orderedObjects )
+    {
+        if ( !i_buildNode.IsLeaf() )
+        {
+            return std::make_shared< BVHNode >( i_buildNode.m_extent,
+                                                FromBuildTree( *i_buildNode.m_children[ 0 ], i_orderedObjects ),
+                                                FromBuildTree( *i_buildNode.m_children[ 1 ], i_orderedObjects ) );
+        }
+
+        if ( i_buildNode.m_objectCount == 1 )
+        {
+            return i_orderedObjects[ i_buildNode.m_objectOffset ];
+        }
+
+        SceneObjectPtrs::const_iterator objectsBegin = i_orderedObjects.begin() + i_buildNode.m_objectOffset;
+        return std::make_shared< SceneObjectList >(
+            SceneObjectPtrs( objectsBegin, objectsBegin + i_buildNode.m_objectCount ) );
+    }
+
+    /// Explicit constructor with the extent and children of this node.
+    ///
+    /// \param i_extent The extent encompassing both children.
+    /// \param i_left The left child.
+    /// \param i_right The right child.
+    inline explicit BVHNode( const gm::Vec3fRange& i_extent,
+                             const SceneObjectPtr& i_left,
+                             const SceneObjectPtr& i_right )
+        : m_extent( i_extent )
+        , m_left( i_left )
+        , m_right( i_right )
+    {
+    }
+
+    virtual inline bool
+    Hit( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const override
+    {
+        // Test extent intersection.
+        gm::FloatRange intersections;
+        if ( !gm::RayAABBIntersection( i_ray.Origin(), i_ray.Direction(), m_extent, intersections ) )
+        {
+            return false;
+        }
+
+        // If the nearest intersection is farther than the maximum allowed range, early out.
+        if ( intersections.Min() > i_magnitudeRange.Max() )
+        {
+            return false;
+        }
+
+        // Test left node intersection.
+        bool hitLeft = m_left->Hit( i_ray, i_magnitudeRange, o_record );
+
+        // Test right node intersection, only accepting hits nearer than the left.
+        gm::FloatRange rightMagnitudeRange = i_magnitudeRange;
+        if ( hitLeft )
+        {
+            rightMagnitudeRange.Max() = o_record.m_magnitude;
+        }
+        bool hitRight = m_right->Hit( i_ray, rightMagnitudeRange, o_record );
+
+        return hitLeft || hitRight;
+    }
+
+    virtual inline bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const override
+    {
+        gm::FloatRange intersections;
+        if ( !gm::RayAABBIntersection( i_ray.Origin(), i_ray.Direction(), m_extent, intersections ) ||
+             intersections.Min() > i_magnitudeRange.Max() )
+        {
+            return false;
+        }
+
+        return m_left->Occluded( i_ray, i_magnitudeRange ) || m_right->Occluded( i_ray, i_magnitudeRange );
+    }
+
+    virtual inline gm::Vec3fRange Extent( const std::vector< float >& i_times ) const override
+    {
+        return m_extent;
+    }
+
+private:
+    // Cached extent, encompassing the extent from both left & right nodes.
+    gm::Vec3fRange m_extent;
+
+    // Left & right nodes.
+    SceneObjectPtr m_left;
+    SceneObjectPtr m_right;
+};
+
+RAYTRACE_NS_CLOSE
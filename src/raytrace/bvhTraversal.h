@@ -0,0 +1,22 @@
+#pragma once
+
+/// \file raytrace/bvhTraversal.h
+///
+/// Constants shared by the traversals of the bounding volume hierarchies.
+
+#include <raytrace/raytrace.h>
+
+#include <limits>
+
+RAYTRACE_NS_OPEN
+
+/// \var c_bvhFarDistanceScale
+///
+/// The factor which the far distance of a ray to a node extent is scaled up by, in slab tests.
+///
+/// Each plane distance is computed with a subtraction and a multiplication, which are rounded.  Scaling the far
+/// distance by the bound of the rounding error ensures that a ray grazing an extent, such as one through a vertex
+/// or edge shared by adjacent triangles, or along a flat extent, is never culled.
+constexpr float c_bvhFarDistanceScale = 1.0f + 3.0f * std::numeric_limits< float >::epsilon();
+
+RAYTRACE_NS_CLOSE
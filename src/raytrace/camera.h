@@ -7,6 +7,7 @@
 #include <raytrace/raytrace.h>
 
 #include <gm/functions/crossProduct.h>
+#include <gm/functions/normalize.h>
 #include <gm/functions/radians.h>
 
 #include <gm/types/vec3f.h>
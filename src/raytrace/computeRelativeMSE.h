@@ -0,0 +1,45 @@
+#pragma once
+
+/// \file raytrace/computeRelativeMSE.h
+///
+/// Measurement of the error of an image against a reference.
+
+#include <raytrace/imageBuffer.h>
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec3f.h>
+
+RAYTRACE_NS_OPEN
+
+/// Compute the relative mean squared error of the image \p i_image against the reference \p i_reference.
+///
+/// The squared error of each color channel is divided by the squared reference value, such that the error is
+/// comparable across bright and dark regions, with a small offset to prevent division by zero.
+///
+/// \pre \p i_image and \p i_reference must have the same dimensions.
+///
+/// \param i_image The image to measure.
+/// \param i_reference The reference image, such as a render with a high sample count.
+///
+/// \return The relative mean squared error.
+inline double ComputeRelativeMSE( const RGBImageBuffer& i_image, const RGBImageBuffer& i_reference )
+{
+    double errorSum = 0.0;
+    for ( int yCoord = 0; yCoord < i_image.Height(); ++yCoord )
+    {
+        for ( int xCoord = 0; xCoord < i_image.Width(); ++xCoord )
+        {
+            const gm::Vec3f& color     = i_image( xCoord, yCoord );
+            const gm::Vec3f& reference = i_reference( xCoord, yCoord );
+            for ( int channel = 0; channel < 3; ++channel )
+            {
+                double difference = color[ channel ] - reference[ channel ];
+                errorSum += difference * difference / ( reference[ channel ] * reference[ channel ] + 0.01 );
+            }
+        }
+    }
+
+    return errorSum / ( 3.0 * i_image.Width() * i_image.Height() );
+}
+
+RAYTRACE_NS_CLOSE
@@ -8,6 +8,7 @@
 #include <raytrace/hitRecord.h>
 #include <raytrace/isotropic.h>
 #include <raytrace/material.h>
+#include <raytrace/randomNumberGenerator.h>
 #include <raytrace/ray.h>
 #include <raytrace/sceneObject.h>
 #include <raytrace/texture.h>
@@ -15,9 +16,13 @@
 #include <gm/base/constants.h>
 
 #include <gm/functions/contains.h>
+#include <gm/functions/length.h>
 #include <gm/functions/rayPosition.h>
 #include <gm/functions/raySphereIntersection.h>
 
+#include <cstdint>
+#include <cstring>
+
 RAYTRACE_NS_OPEN
 
 /// \class ConstantMedium
@@ -75,8 +80,11 @@ public:
             ( secondHit.m_magnitude - firstHit.m_magnitude ) * gm::Length( i_ray.Direction() );
 
         // Compute a random distance, based on probability as a function of the density.
-        float randomHitDistance =
-            m_negInverseDensity.Value( i_ray.Time() ) * log( gm::RandomNumber( gm::FloatRange( 0, 1 ) ) );
+        // The random number is keyed by the ray and its entry point, so it does not depend on the thread
+        // nor the order in which objects are tested.  1 - u lies in (0, 1], which keeps the logarithm finite.
+        RandomNumberGenerator random( _HashRay( i_ray, firstHit.m_magnitude ) );
+        float                 randomHitDistance =
+            m_negInverseDensity.Value( i_ray.Time() ) * log( 1.0f - random.UniformFloat() );
 
         // Ray does not hit any other particles in this medium.
         if ( randomHitDistance > distanceWithinGeometry )
@@ -86,19 +94,55 @@ public:
 
         // Record volume hit.
         o_record.m_magnitude = firstHit.m_magnitude + randomHitDistance * gm::Length( i_ray.Direction() );
-        o_record.m_position  = gm::RayPosition( i_ray.Origin(), i_ray.Direction(), o_record.m_magnitude );
-        o_record.m_normal    = gm::Vec3f( 0, 1, 0 ); // Arbituary - un-used by current materials.
-        o_record.m_material  = m_material;
+        o_record.m_material  = m_material.get();
+        o_record.m_object    = this;
 
         return true;
     }
 
+    virtual inline bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const override
+    {
+        // Whether the ray is blocked depends on the scattering distance sampled by Hit, such that the fraction of
+        // rays blocked matches the transmittance of the medium.
+        HitRecord record;
+        return Hit( i_ray, i_magnitudeRange, record );
+    }
+
+    virtual inline void ComputeSurfaceInteraction( const raytrace::Ray& i_ray, HitRecord& io_record ) const override
+    {
+        io_record.m_position = gm::RayPosition( i_ray.Origin(), i_ray.Direction(), io_record.m_magnitude );
+        io_record.m_normal   = gm::Vec3f( 0, 1, 0 ); // Arbituary - un-used by current materials.
+    }
+
     virtual inline gm::Vec3fRange Extent( const std::vector< float >& i_times ) const override
     {
         return m_geometry->Extent( i_times );
     }
 
 private:
+    // Hash the bits of \p i_ray, and the magnitude \p i_magnitude along it, into a sequence index.
+    static inline uint64_t _HashRay( const raytrace::Ray& i_ray, float i_magnitude )
+    {
+        float values[ 8 ] = {i_ray.Origin()[ 0 ],
+                             i_ray.Origin()[ 1 ],
+                             i_ray.Origin()[ 2 ],
+                             i_ray.Direction()[ 0 ],
+                             i_ray.Direction()[ 1 ],
+                             i_ray.Direction()[ 2 ],
+                             i_ray.Time(),
+                             i_magnitude};
+
+        // FNV-1a, over 32-bit words.
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for ( float value : values )
+        {
+            uint32_t bits;
+            std::memcpy( &bits, &value, sizeof( bits ) );
+            hash = ( hash ^ bits ) * 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
     SceneObjectPtr     m_geometry;
     MaterialSharedPtr  m_material;
     Attribute< float > m_negInverseDensity;
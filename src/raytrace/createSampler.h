@@ -0,0 +1,53 @@
+#pragma once
+
+/// \file raytrace/createSampler.h
+///
+/// Construction of the sampler selected by the render settings.
+
+#include <raytrace/haltonSampler.h>
+#include <raytrace/independentSampler.h>
+#include <raytrace/renderSettings.h>
+#include <raytrace/sampler.h>
+#include <raytrace/sobolSampler.h>
+#include <raytrace/stratifiedSampler.h>
+
+#include <iostream>
+
+RAYTRACE_NS_OPEN
+
+/// Create the sampler described by \p i_settings.
+///
+/// Supported values of \ref RenderSettings::m_sampler are:
+/// - "independent": independent random values, via \ref IndependentSampler.
+/// - "stratified": jittered strata, via \ref StratifiedSampler.
+/// - "halton": Owen-scrambled Halton sequence, via \ref HaltonSampler.
+/// - "sobol": Owen-scrambled, padded Sobol sequence, via \ref SobolSampler.
+///
+/// \param i_settings The render settings.
+///
+/// \return The sampler, or null if the sampler type is not recognized.
+inline SamplerPtr CreateSampler( const RenderSettings& i_settings )
+{
+    uint32_t seed = ( uint32_t ) i_settings.m_seed;
+    if ( i_settings.m_sampler == "independent" )
+    {
+        return SamplerPtr( new IndependentSampler( i_settings.m_samplesPerPixel, seed ) );
+    }
+    else if ( i_settings.m_sampler == "stratified" )
+    {
+        return SamplerPtr( new StratifiedSampler( i_settings.m_samplesPerPixel, seed ) );
+    }
+    else if ( i_settings.m_sampler == "halton" )
+    {
+        return SamplerPtr( new HaltonSampler( i_settings.m_samplesPerPixel, seed ) );
+    }
+    else if ( i_settings.m_sampler == "sobol" )
+    {
+        return SamplerPtr( new SobolSampler( i_settings.m_samplesPerPixel, seed ) );
+    }
+
+    std::cerr << "Unrecognized sampler: " << i_settings.m_sampler << std::endl;
+    return nullptr;
+}
+
+RAYTRACE_NS_CLOSE
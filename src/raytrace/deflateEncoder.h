@@ -0,0 +1,330 @@
+#pragma once
+
+/// \file raytrace/deflateEncoder.h
+///
+/// Dependency-free compression of bytes into DEFLATE streams, as embedded in zlib streams and PNG files.
+///
+/// Reference: P. Deutsch, "DEFLATE Compressed Data Format Specification version 1.3" (RFC 1951), and
+/// P. Deutsch, J-L. Gailly, "ZLIB Compressed Data Format Specification version 3.3" (RFC 1950).
+
+#include <raytrace/raytrace.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class DeflateEncoder
+///
+/// DeflateEncoder compresses bytes into DEFLATE blocks, with LZ77 matching and the fixed Huffman codes.
+///
+/// Data is compressed in segments.  Each segment only matches against its own earlier bytes, and is terminated
+/// with an empty stored block, which aligns it to a byte boundary (a "sync flush").  Segments compressed
+/// separately, for example in parallel, can therefore be concatenated into a single stream, which is then
+/// terminated with \ref FinishStream.
+class DeflateEncoder
+{
+public:
+    /// Compress \p i_size bytes of \p i_data into a segment of DEFLATE blocks, appended to \p io_output.
+    ///
+    /// \param i_data The bytes to compress.
+    /// \param i_size The number of bytes.
+    /// \param io_output The buffer to append the compressed segment to.
+    static inline void EncodeSegment( const uint8_t* i_data, size_t i_size, std::vector< uint8_t >& io_output )
+    {
+        _BitWriter writer( io_output );
+        if ( i_size > 0 )
+        {
+            // BFINAL = 0, BTYPE = 01 (fixed Huffman codes).
+            writer.Write( 0, 1 );
+            writer.Write( 1, 2 );
+
+            // The most recent position of each hashed triplet, and the chains of previous positions with the
+            // same hash.
+            std::vector< int32_t > headPositions( 1 << c_hashBits, -1 );
+            std::vector< int32_t > previousPositions( i_size, -1 );
+            auto                   insertPosition = [&]( size_t i_position ) {
+                if ( i_position + c_minMatchLength <= i_size )
+                {
+                    uint32_t hash                   = _HashTriplet( i_data + i_position );
+                    previousPositions[ i_position ] = headPositions[ hash ];
+                    headPositions[ hash ]           = ( int32_t ) i_position;
+                }
+            };
+
+            size_t position = 0;
+            while ( position < i_size )
+            {
+                int matchDistance = 0;
+                int matchLength =
+                    _FindMatch( i_data, i_size, position, headPositions, previousPositions, matchDistance );
+                if ( matchLength >= c_minMatchLength )
+                {
+                    _WriteMatch( writer, matchLength, matchDistance );
+                    for ( int offset = 0; offset < matchLength; ++offset )
+                    {
+                        insertPosition( position + offset );
+                    }
+                    position += matchLength;
+                }
+                else
+                {
+                    _WriteLiteralLengthSymbol( writer, i_data[ position ] );
+                    insertPosition( position );
+                    position += 1;
+                }
+            }
+
+            // End of block.
+            _WriteLiteralLengthSymbol( writer, 256 );
+        }
+
+        // Sync flush: an empty stored block, whose length fields start on a byte boundary.
+        writer.Write( 0, 3 );
+        writer.Align();
+        io_output.insert( io_output.end(), {0x00, 0x00, 0xff, 0xff} );
+    }
+
+    /// Terminate a stream of DEFLATE segments, by appending an empty final block to \p io_output.
+    ///
+    /// \param io_output The buffer holding the compressed segments.
+    static inline void FinishStream( std::vector< uint8_t >& io_output )
+    {
+        // BFINAL = 1, BTYPE = 01 (fixed Huffman codes), followed by the 7 bit end of block code.
+        io_output.push_back( 0x03 );
+        io_output.push_back( 0x00 );
+    }
+
+    /// Compute the Adler-32 checksum of \p i_size bytes of \p i_data, which terminates zlib streams.
+    ///
+    /// \param i_data The bytes to checksum.
+    /// \param i_size The number of bytes.
+    /// \param i_adler The checksum of the preceding bytes, to continue from.
+    ///
+    /// \return The checksum.
+    static inline uint32_t Adler32( const uint8_t* i_data, size_t i_size, uint32_t i_adler = 1 )
+    {
+        // The largest number of bytes which can be summed before the sums must be reduced, without overflow.
+        constexpr size_t   c_maxRunLength = 5552;
+        constexpr uint32_t c_modulus      = 65521;
+
+        uint32_t lowSum  = i_adler & 0xffff;
+        uint32_t highSum = i_adler >> 16;
+        while ( i_size > 0 )
+        {
+            size_t runLength = std::min( i_size, c_maxRunLength );
+            for ( size_t byteIndex = 0; byteIndex < runLength; ++byteIndex )
+            {
+                lowSum += i_data[ byteIndex ];
+                highSum += lowSum;
+            }
+
+            i_data += runLength;
+            i_size -= runLength;
+            lowSum %= c_modulus;
+            highSum %= c_modulus;
+        }
+
+        return ( highSum << 16 ) | lowSum;
+    }
+
+private:
+    // Match lengths, and the distance which matches may reach back.
+    static constexpr int    c_minMatchLength = 3;
+    static constexpr int    c_maxMatchLength = 258;
+    static constexpr size_t c_windowSize     = 32768;
+
+    // The number of bits of the triplet hash.
+    static constexpr int c_hashBits = 15;
+
+    // The search for a match stops after this many candidates, or once a match of this length is found.
+    static constexpr int c_maxChainLength  = 8;
+    static constexpr int c_niceMatchLength = 64;
+
+    // Writes values into a byte buffer, least significant bit first.
+    class _BitWriter
+    {
+    public:
+        inline explicit _BitWriter( std::vector< uint8_t >& io_output )
+            : m_output( io_output )
+        {
+        }
+
+        // Write the \p i_bitCount low bits of \p i_value.
+        inline void Write( uint32_t i_value, int i_bitCount )
+        {
+            m_bits |= ( uint64_t ) i_value << m_bitCount;
+            m_bitCount += i_bitCount;
+            while ( m_bitCount >= 8 )
+            {
+                m_output.push_back( ( uint8_t ) m_bits );
+                m_bits >>= 8;
+                m_bitCount -= 8;
+            }
+        }
+
+        // Pad the written bits up to a byte boundary.
+        inline void Align()
+        {
+            if ( m_bitCount > 0 )
+            {
+                m_output.push_back( ( uint8_t ) m_bits );
+                m_bits     = 0;
+                m_bitCount = 0;
+            }
+        }
+
+    private:
+        std::vector< uint8_t >& m_output;
+        uint64_t                m_bits     = 0;
+        int                     m_bitCount = 0;
+    };
+
+    // Find the longest match for the bytes at \p i_position, among the previous positions of the same triplet
+    // within the window.  Returns the match length, and its distance through \p o_distance.
+    static inline int _FindMatch( const uint8_t*                i_data,
+                                  size_t                        i_size,
+                                  size_t                        i_position,
+                                  const std::vector< int32_t >& i_headPositions,
+                                  const std::vector< int32_t >& i_previousPositions,
+                                  int&                          o_distance )
+    {
+        if ( i_position + c_minMatchLength > i_size )
+        {
+            return 0;
+        }
+
+        int     maxLength  = ( int ) std::min< size_t >( c_maxMatchLength, i_size - i_position );
+        int     bestLength = 0;
+        int32_t candidate  = i_headPositions[ _HashTriplet( i_data + i_position ) ];
+        for ( int chainIndex = 0; chainIndex < c_maxChainLength && candidate >= 0; ++chainIndex )
+        {
+            if ( i_position - candidate > c_windowSize )
+            {
+                break;
+            }
+
+            // Candidates which cannot improve on the best match are rejected by their last byte first.
+            if ( i_data[ candidate + bestLength ] == i_data[ i_position + bestLength ] )
+            {
+                int length = 0;
+                while ( length < maxLength && i_data[ candidate + length ] == i_data[ i_position + length ] )
+                {
+                    ++length;
+                }
+
+                if ( length > bestLength )
+                {
+                    bestLength = length;
+                    o_distance = ( int ) ( i_position - candidate );
+                    if ( length >= std::min( maxLength, c_niceMatchLength ) )
+                    {
+                        break;
+                    }
+                }
+            }
+
+            candidate = i_previousPositions[ candidate ];
+        }
+
+        return bestLength;
+    }
+
+    // The fixed Huffman codes of the literal/length symbols, with their bits reversed into writing order.
+    struct _FixedCodes
+    {
+        uint16_t m_codes[ 288 ];
+        uint8_t  m_bitCounts[ 288 ];
+    };
+
+    static inline const _FixedCodes& _LiteralLengthCodes()
+    {
+        static const _FixedCodes codes = []() {
+            _FixedCodes fixedCodes;
+            for ( int symbol = 0; symbol < 288; ++symbol )
+            {
+                uint32_t code     = 0;
+                int      bitCount = 0;
+                if ( symbol < 144 )
+                {
+                    code     = 0x30 + symbol;
+                    bitCount = 8;
+                }
+                else if ( symbol < 256 )
+                {
+                    code     = 0x190 + ( symbol - 144 );
+                    bitCount = 9;
+                }
+                else if ( symbol < 280 )
+                {
+                    code     = symbol - 256;
+                    bitCount = 7;
+                }
+                else
+                {
+                    code     = 0xc0 + ( symbol - 280 );
+                    bitCount = 8;
+                }
+
+                fixedCodes.m_codes[ symbol ]     = ( uint16_t ) _ReverseBits( code, bitCount );
+                fixedCodes.m_bitCounts[ symbol ] = ( uint8_t ) bitCount;
+            }
+            return fixedCodes;
+        }();
+        return codes;
+    }
+
+    // Reverse the order of the \p i_bitCount low bits of \p i_value.
+    static inline uint32_t _ReverseBits( uint32_t i_value, int i_bitCount )
+    {
+        uint32_t reversedValue = 0;
+        for ( int bitIndex = 0; bitIndex < i_bitCount; ++bitIndex )
+        {
+            reversedValue = ( reversedValue << 1 ) | ( ( i_value >> bitIndex ) & 1 );
+        }
+        return reversedValue;
+    }
+
+    // Write the fixed Huffman code of the literal/length symbol \p i_symbol.
+    static inline void _WriteLiteralLengthSymbol( _BitWriter& io_writer, int i_symbol )
+    {
+        const _FixedCodes& codes = _LiteralLengthCodes();
+        io_writer.Write( codes.m_codes[ i_symbol ], codes.m_bitCounts[ i_symbol ] );
+    }
+
+    // Write a back reference of \p i_length bytes, \p i_distance bytes back.
+    static inline void _WriteMatch( _BitWriter& io_writer, int i_length, int i_distance )
+    {
+        // The base values and extra bit counts of the length codes 257-285, and of the distance codes 0-29.
+        static const uint16_t lengthBases[ 29 ]     = {3,  4,  5,  6,  7,  8,  9,  10,  11,  13,  15,  17,  19,  23, 27,
+                                                   31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const uint8_t  lengthExtraBits[ 29 ] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                                      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const uint16_t distanceBases[ 30 ]   = {1,    2,    3,    4,    5,    7,    9,    13,    17,    25,
+                                                     33,   49,   65,   97,   129,  193,  257,  385,   513,   769,
+                                                     1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        static const uint8_t  distanceExtraBits[ 30 ] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                                        6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        // The code of a value is the last whose base does not exceed it.
+        int lengthCode = ( int ) ( std::upper_bound( lengthBases, lengthBases + 29, i_length ) - lengthBases ) - 1;
+        _WriteLiteralLengthSymbol( io_writer, 257 + lengthCode );
+        io_writer.Write( i_length - lengthBases[ lengthCode ], lengthExtraBits[ lengthCode ] );
+
+        int distanceCode =
+            ( int ) ( std::upper_bound( distanceBases, distanceBases + 30, i_distance ) - distanceBases ) - 1;
+        io_writer.Write( _ReverseBits( distanceCode, 5 ), 5 );
+        io_writer.Write( i_distance - distanceBases[ distanceCode ], distanceExtraBits[ distanceCode ] );
+    }
+
+    // Hash the 3 bytes starting at \p i_data.
+    static inline uint32_t _HashTriplet( const uint8_t* i_data )
+    {
+        uint32_t triplet = ( ( uint32_t ) i_data[ 0 ] << 16 ) | ( ( uint32_t ) i_data[ 1 ] << 8 ) | i_data[ 2 ];
+        return ( triplet * 2654435761u ) >> ( 32 - c_hashBits );
+    }
+};
+
+RAYTRACE_NS_CLOSE
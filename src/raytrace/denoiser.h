@@ -0,0 +1,461 @@
+#pragma once
+
+/// \file raytrace/denoiser.h
+///
+/// Edge-avoiding removal of the noise of a render, guided by its AOVs.
+///
+/// Reference: "Spatiotemporal Variance-Guided Filtering: Real-Time Reconstruction for Path-Traced Global
+/// Illumination", Schied et al. 2017, without its temporal accumulation.
+///
+/// The filter is vectorized with SSE instructions when available, otherwise a scalar implementation is used.
+
+#include <raytrace/aovImage.h>
+#include <raytrace/imageBuffer.h>
+#include <raytrace/pixelStatistics.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/tileRenderer.h>
+
+#include <gm/types/vec3f.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+RAYTRACE_NS_OPEN
+
+/// \class Denoiser
+///
+/// Denoiser removes the noise of a render with an edge-avoiding à-trous wavelet filter.
+///
+/// The radiance is first divided by the albedo AOV, such that texture detail is not blurred, and multiplied back
+/// once filtered.  Each iteration of the filter then averages every pixel with its neighbours across a 5x5 B3
+/// spline kernel, whose taps are spaced twice as far apart as in the previous iteration.  The weight of each
+/// neighbour falls off with its difference from the pixel in:
+/// - Normal, from the normal AOV, preserving geometric edges.
+/// - Depth, relative to the depth of the pixel, preserving silhouettes.
+/// - Luminance, relative to the standard deviation of the noise of the pixel, estimated from the variance AOV.
+///   Noisy pixels are averaged more aggressively than converged ones, and real detail is preserved.
+///
+/// The variance is filtered alongside the radiance, so that later iterations see the reduced noise.
+///
+/// Pixels without a normal, where the camera rays escaped the scene, are left unfiltered.
+class Denoiser
+{
+public:
+    /// The AOV channels which guide the filter.
+    static constexpr int c_guideChannels =
+        AOVImage::Albedo | AOVImage::Normal | AOVImage::Depth | AOVImage::Variance;
+
+    /// Explicit constructor with the filter parameters.
+    ///
+    /// \param i_iterationCount The number of iterations of the filter.  Each doubles the filter footprint.
+    /// \param i_colorSigma The luminance difference, in standard deviations of the noise, over which neighbours
+    /// are averaged.
+    /// \param i_depthSigma The depth difference, relative to the depth of the pixel, over which neighbours are
+    /// averaged.
+    /// \param i_threadCount The number of threads to filter with.  Zero uses all the hardware threads.
+    inline explicit Denoiser( int i_iterationCount, float i_colorSigma, float i_depthSigma, int i_threadCount = 0 )
+        : m_iterationCount( std::max( i_iterationCount, 0 ) )
+        , m_colorSigma( i_colorSigma )
+        , m_depthSigma( i_depthSigma )
+        , m_bandRenderer( i_threadCount, c_rowsPerBand )
+    {
+    }
+
+    /// Filter the radiance \p i_radiance into \p o_radiance.
+    ///
+    /// \pre \p i_guides must hold the \ref c_guideChannels channels, with the dimensions of \p i_radiance.
+    ///
+    /// \param i_radiance The linear radiance of each pixel.
+    /// \param i_guides The AOVs of the render.
+    /// \param o_radiance The image buffer to write the filtered radiance of each pixel into.
+    inline void Apply( const RGBImageBuffer& i_radiance, const AOVImage& i_guides, RGBImageBuffer& o_radiance ) const
+    {
+        int width  = i_radiance.Width();
+        int height = i_radiance.Height();
+        o_radiance.Resize( width, height );
+
+        _Planes planes( width, height, m_iterationCount );
+
+        // Divide the radiance by the albedo, and normalize the normals.
+        m_bandRenderer.ForEachRowBand( height, [&]( int i_beginRow, int i_endRow ) {
+            for ( int yCoord = i_beginRow; yCoord < i_endRow; ++yCoord )
+            {
+                for ( int xCoord = 0; xCoord < width; ++xCoord )
+                {
+                    size_t    index  = planes.Index( xCoord, yCoord );
+                    gm::Vec3f albedo = _DemodulationAlbedo( i_guides.AlbedoBuffer()( xCoord, yCoord ) );
+                    gm::Vec3f normal = i_guides.NormalBuffer()( xCoord, yCoord );
+                    float normalLength = std::sqrt( normal[ 0 ] * normal[ 0 ] + normal[ 1 ] * normal[ 1 ] +
+                                                    normal[ 2 ] * normal[ 2 ] );
+                    float albedoLuminance = PixelStatistics::Luminance( albedo );
+                    for ( int channel = 0; channel < 3; ++channel )
+                    {
+                        planes.m_color[ 0 ][ channel ][ index ] =
+                            i_radiance( xCoord, yCoord )[ channel ] / albedo[ channel ];
+                        planes.m_normal[ channel ][ index ] =
+                            normalLength > 0.0f ? normal[ channel ] / normalLength : 0.0f;
+                    }
+                    planes.m_variance[ 0 ][ index ] =
+                        i_guides.VarianceBuffer()( xCoord, yCoord ) / ( albedoLuminance * albedoLuminance );
+                    planes.m_depth[ index ] = i_guides.DepthBuffer()( xCoord, yCoord );
+                }
+            }
+        } );
+
+        int source = 0;
+        for ( int iteration = 0; iteration < m_iterationCount; ++iteration )
+        {
+            _Pass pass( planes, source, 1 << iteration, m_colorSigma, m_depthSigma );
+            m_bandRenderer.ForEachRowBand( height, [&]( int i_beginRow, int i_endRow ) {
+                for ( int yCoord = i_beginRow; yCoord < i_endRow; ++yCoord )
+                {
+                    _FilterRow( pass, planes.Index( 0, yCoord ), width );
+                }
+            } );
+            source = 1 - source;
+        }
+
+        // Multiply the filtered radiance back by the albedo.
+        m_bandRenderer.ForEachRowBand( height, [&]( int i_beginRow, int i_endRow ) {
+            for ( int yCoord = i_beginRow; yCoord < i_endRow; ++yCoord )
+            {
+                for ( int xCoord = 0; xCoord < width; ++xCoord )
+                {
+                    size_t    index  = planes.Index( xCoord, yCoord );
+                    gm::Vec3f albedo = _DemodulationAlbedo( i_guides.AlbedoBuffer()( xCoord, yCoord ) );
+                    for ( int channel = 0; channel < 3; ++channel )
+                    {
+                        o_radiance( xCoord, yCoord )[ channel ] =
+                            planes.m_color[ source ][ channel ][ index ] * albedo[ channel ];
+                    }
+                }
+            }
+        } );
+    }
+
+private:
+    // The number of rows filtered together by a thread.
+    static constexpr int c_rowsPerBand = 16;
+
+    // Offset added to the albedo, so that the radiance of black surfaces survives demodulation.
+    static constexpr float c_albedoEpsilon = 0.01f;
+
+    // Offset added to the standard deviation of the noise, so that noise-free pixels do not divide by zero.
+    static constexpr float c_deviationEpsilon = 1e-4f;
+
+    // The exponent of the normal weight, as a number of squarings of the cosine between normals: 2^7 = 128.
+    static constexpr int c_normalSquaringCount = 7;
+
+    // The luminance and depth terms of a weight are clamped, such that the weight underflows to zero.
+    static constexpr float c_maxExponent = 80.0f;
+
+    // The padded, structure of arrays layout of the image.  The values of horizontally adjacent pixels are
+    // contiguous, and so are those of their neighbours at any offset, so neighbours of several pixels are loaded
+    // at once.  The padding is wide enough for the widest kernel, and has zero normals, so it carries no weight.
+    struct _Planes
+    {
+        inline _Planes( int i_width, int i_height, int i_iterationCount )
+            : m_padding( 2 << std::max( i_iterationCount - 1, 0 ) )
+            , m_rowStride( ( ( i_width + 3 ) & ~3 ) + 2 * m_padding )
+        {
+            size_t size = ( size_t ) m_rowStride * ( i_height + 2 * m_padding );
+            for ( int channel = 0; channel < 3; ++channel )
+            {
+                m_color[ 0 ][ channel ].resize( size, 0.0f );
+                m_color[ 1 ][ channel ].resize( size, 0.0f );
+                m_normal[ channel ].resize( size, 0.0f );
+            }
+            m_variance[ 0 ].resize( size, 0.0f );
+            m_variance[ 1 ].resize( size, 0.0f );
+            m_depth.resize( size, 0.0f );
+        }
+
+        // The index of the values of pixel (\p i_xCoord, \p i_yCoord).
+        inline size_t Index( int i_xCoord, int i_yCoord ) const
+        {
+            return ( size_t )( i_yCoord + m_padding ) * m_rowStride + i_xCoord + m_padding;
+        }
+
+        int m_padding   = 0;
+        int m_rowStride = 0;
+
+        // Radiance divided by albedo, and its variance, in ping-pong pairs of source and destination.
+        std::vector< float > m_color[ 2 ][ 3 ];
+        std::vector< float > m_variance[ 2 ];
+
+        std::vector< float > m_normal[ 3 ];
+        std::vector< float > m_depth;
+    };
+
+    // The planes read and written by an iteration of the filter, and its parameters.
+    struct _Pass
+    {
+        inline _Pass( _Planes& io_planes, int i_source, int i_step, float i_colorSigma, float i_depthSigma )
+            : m_rowStride( io_planes.m_rowStride )
+            , m_step( i_step )
+            , m_colorSigma( i_colorSigma )
+            , m_depthSigma( i_depthSigma * i_step )
+            , m_variance( io_planes.m_variance[ i_source ].data() )
+            , m_depth( io_planes.m_depth.data() )
+            , m_filteredVariance( io_planes.m_variance[ 1 - i_source ].data() )
+        {
+            for ( int channel = 0; channel < 3; ++channel )
+            {
+                m_color[ channel ]         = io_planes.m_color[ i_source ][ channel ].data();
+                m_normal[ channel ]        = io_planes.m_normal[ channel ].data();
+                m_filteredColor[ channel ] = io_planes.m_color[ 1 - i_source ][ channel ].data();
+            }
+        }
+
+        ptrdiff_t m_rowStride  = 0;
+        int       m_step       = 1;
+        float     m_colorSigma = 0.0f;
+        float     m_depthSigma = 0.0f;
+
+        const float* m_color[ 3 ];
+        const float* m_variance;
+        const float* m_normal[ 3 ];
+        const float* m_depth;
+        float*       m_filteredColor[ 3 ];
+        float*       m_filteredVariance;
+    };
+
+    // The albedo which radiance is divided by.
+    static inline gm::Vec3f _DemodulationAlbedo( const gm::Vec3f& i_albedo )
+    {
+        return gm::Vec3f( std::max( i_albedo[ 0 ], 0.0f ) + c_albedoEpsilon,
+                          std::max( i_albedo[ 1 ], 0.0f ) + c_albedoEpsilon,
+                          std::max( i_albedo[ 2 ], 0.0f ) + c_albedoEpsilon );
+    }
+
+    // The 1D B3 spline kernel, whose outer product is the 5x5 filter kernel.
+    static inline float _KernelWeight( int i_offset )
+    {
+        static constexpr float c_weights[ 5 ] = {1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f};
+        return c_weights[ i_offset + 2 ];
+    }
+
+    // Filter the \p i_width pixels of the row starting at \p i_index.
+    static inline void _FilterRow( const _Pass& i_pass, size_t i_index, int i_width )
+    {
+        int xCoord = 0;
+#if defined( __SSE2__ )
+        // Rows are padded to a multiple of 4 pixels.
+        for ( ; xCoord < i_width; xCoord += 4 )
+        {
+            _FilterPixels( i_pass, i_index + xCoord );
+        }
+#endif
+        for ( ; xCoord < i_width; ++xCoord )
+        {
+            _FilterPixel( i_pass, i_index + xCoord );
+        }
+    }
+
+    // Filter the pixel at \p i_index.
+    static inline void _FilterPixel( const _Pass& i_pass, size_t i_index )
+    {
+        auto luminance = [&]( size_t i_pixelIndex ) {
+            return 0.2126f * i_pass.m_color[ 0 ][ i_pixelIndex ] + 0.7152f * i_pass.m_color[ 1 ][ i_pixelIndex ] +
+                   0.0722f * i_pass.m_color[ 2 ][ i_pixelIndex ];
+        };
+
+        // Estimate the variance from a 3x3 neighbourhood, which is more robust than that of a single pixel.
+        float variance = 0.0f;
+        for ( int yOffset = -1; yOffset <= 1; ++yOffset )
+        {
+            for ( int xOffset = -1; xOffset <= 1; ++xOffset )
+            {
+                float weight = ( yOffset == 0 ? 0.5f : 0.25f ) * ( xOffset == 0 ? 0.5f : 0.25f );
+                variance += weight * i_pass.m_variance[ i_index + yOffset * i_pass.m_rowStride + xOffset ];
+            }
+        }
+
+        float pixelLuminance = luminance( i_index );
+        float luminanceScale = 1.0f / ( i_pass.m_colorSigma * std::sqrt( std::max( variance, 0.0f ) ) +
+                                        c_deviationEpsilon );
+        float depthScale = 1.0f / ( i_pass.m_depthSigma * i_pass.m_depth[ i_index ] + c_deviationEpsilon );
+
+        float centerWeight = _KernelWeight( 0 ) * _KernelWeight( 0 );
+        float weightSum    = centerWeight;
+        float colorSum[ 3 ];
+        for ( int channel = 0; channel < 3; ++channel )
+        {
+            colorSum[ channel ] = centerWeight * i_pass.m_color[ channel ][ i_index ];
+        }
+        float varianceSum = centerWeight * centerWeight * i_pass.m_variance[ i_index ];
+
+        for ( int yOffset = -2; yOffset <= 2; ++yOffset )
+        {
+            for ( int xOffset = -2; xOffset <= 2; ++xOffset )
+            {
+                if ( yOffset == 0 && xOffset == 0 )
+                {
+                    continue;
+                }
+
+                size_t neighbour = i_index + ( yOffset * i_pass.m_rowStride + xOffset ) * i_pass.m_step;
+                float  exponent  = std::abs( pixelLuminance - luminance( neighbour ) ) * luminanceScale +
+                                 std::abs( i_pass.m_depth[ i_index ] - i_pass.m_depth[ neighbour ] ) * depthScale;
+                float normalWeight = std::max( i_pass.m_normal[ 0 ][ i_index ] * i_pass.m_normal[ 0 ][ neighbour ] +
+                                                   i_pass.m_normal[ 1 ][ i_index ] * i_pass.m_normal[ 1 ][ neighbour ] +
+                                                   i_pass.m_normal[ 2 ][ i_index ] * i_pass.m_normal[ 2 ][ neighbour ],
+                                               0.0f );
+                for ( int squaring = 0; squaring < c_normalSquaringCount; ++squaring )
+                {
+                    normalWeight *= normalWeight;
+                }
+
+                float weight = _KernelWeight( yOffset ) * _KernelWeight( xOffset ) * normalWeight *
+                               std::exp( -std::min( exponent, c_maxExponent ) );
+                weightSum += weight;
+                for ( int channel = 0; channel < 3; ++channel )
+                {
+                    colorSum[ channel ] += weight * i_pass.m_color[ channel ][ neighbour ];
+                }
+                varianceSum += weight * weight * i_pass.m_variance[ neighbour ];
+            }
+        }
+
+        for ( int channel = 0; channel < 3; ++channel )
+        {
+            i_pass.m_filteredColor[ channel ][ i_index ] = colorSum[ channel ] / weightSum;
+        }
+        i_pass.m_filteredVariance[ i_index ] = varianceSum / ( weightSum * weightSum );
+    }
+
+#if defined( __SSE2__ )
+    // Filter the 4 pixels starting at \p i_index, as \ref _FilterPixel.
+    static inline void _FilterPixels( const _Pass& i_pass, size_t i_index )
+    {
+        const __m128 zero = _mm_setzero_ps();
+        auto         load = [&]( const float* i_plane, size_t i_pixelIndex ) {
+            return _mm_loadu_ps( i_plane + i_pixelIndex );
+        };
+        auto luminance = [&]( size_t i_pixelIndex ) {
+            return _mm_add_ps(
+                _mm_add_ps( _mm_mul_ps( _mm_set1_ps( 0.2126f ), load( i_pass.m_color[ 0 ], i_pixelIndex ) ),
+                            _mm_mul_ps( _mm_set1_ps( 0.7152f ), load( i_pass.m_color[ 1 ], i_pixelIndex ) ) ),
+                _mm_mul_ps( _mm_set1_ps( 0.0722f ), load( i_pass.m_color[ 2 ], i_pixelIndex ) ) );
+        };
+        auto absolute = [&]( __m128 i_values ) { return _mm_andnot_ps( _mm_set1_ps( -0.0f ), i_values ); };
+
+        __m128 variance = zero;
+        for ( int yOffset = -1; yOffset <= 1; ++yOffset )
+        {
+            for ( int xOffset = -1; xOffset <= 1; ++xOffset )
+            {
+                float weight = ( yOffset == 0 ? 0.5f : 0.25f ) * ( xOffset == 0 ? 0.5f : 0.25f );
+                variance     = _mm_add_ps( variance,
+                                       _mm_mul_ps( _mm_set1_ps( weight ),
+                                                   load( i_pass.m_variance,
+                                                         i_index + yOffset * i_pass.m_rowStride + xOffset ) ) );
+            }
+        }
+
+        __m128 pixelLuminance = luminance( i_index );
+        __m128 luminanceScale = _mm_div_ps(
+            _mm_set1_ps( 1.0f ),
+            _mm_add_ps( _mm_mul_ps( _mm_set1_ps( i_pass.m_colorSigma ), _mm_sqrt_ps( _mm_max_ps( variance, zero ) ) ),
+                        _mm_set1_ps( c_deviationEpsilon ) ) );
+        __m128 pixelDepth = load( i_pass.m_depth, i_index );
+        __m128 depthScale =
+            _mm_div_ps( _mm_set1_ps( 1.0f ),
+                        _mm_add_ps( _mm_mul_ps( _mm_set1_ps( i_pass.m_depthSigma ), pixelDepth ),
+                                    _mm_set1_ps( c_deviationEpsilon ) ) );
+        __m128 pixelNormal[ 3 ];
+        for ( int axis = 0; axis < 3; ++axis )
+        {
+            pixelNormal[ axis ] = load( i_pass.m_normal[ axis ], i_index );
+        }
+
+        __m128 centerWeight = _mm_set1_ps( _KernelWeight( 0 ) * _KernelWeight( 0 ) );
+        __m128 weightSum    = centerWeight;
+        __m128 colorSum[ 3 ];
+        for ( int channel = 0; channel < 3; ++channel )
+        {
+            colorSum[ channel ] = _mm_mul_ps( centerWeight, load( i_pass.m_color[ channel ], i_index ) );
+        }
+        __m128 varianceSum =
+            _mm_mul_ps( _mm_mul_ps( centerWeight, centerWeight ), load( i_pass.m_variance, i_index ) );
+
+        for ( int yOffset = -2; yOffset <= 2; ++yOffset )
+        {
+            for ( int xOffset = -2; xOffset <= 2; ++xOffset )
+            {
+                if ( yOffset == 0 && xOffset == 0 )
+                {
+                    continue;
+                }
+
+                size_t neighbour = i_index + ( yOffset * i_pass.m_rowStride + xOffset ) * i_pass.m_step;
+                __m128 exponent  = _mm_add_ps(
+                    _mm_mul_ps( absolute( _mm_sub_ps( pixelLuminance, luminance( neighbour ) ) ), luminanceScale ),
+                    _mm_mul_ps( absolute( _mm_sub_ps( pixelDepth, load( i_pass.m_depth, neighbour ) ) ),
+                                depthScale ) );
+                __m128 normalWeight = zero;
+                for ( int axis = 0; axis < 3; ++axis )
+                {
+                    normalWeight = _mm_add_ps(
+                        normalWeight, _mm_mul_ps( pixelNormal[ axis ], load( i_pass.m_normal[ axis ], neighbour ) ) );
+                }
+                normalWeight = _mm_max_ps( normalWeight, zero );
+                for ( int squaring = 0; squaring < c_normalSquaringCount; ++squaring )
+                {
+                    normalWeight = _mm_mul_ps( normalWeight, normalWeight );
+                }
+
+                __m128 weight = _mm_mul_ps( _mm_set1_ps( _KernelWeight( yOffset ) * _KernelWeight( xOffset ) ),
+                                            _mm_mul_ps( normalWeight, _ExpNegative( exponent ) ) );
+                weightSum     = _mm_add_ps( weightSum, weight );
+                for ( int channel = 0; channel < 3; ++channel )
+                {
+                    colorSum[ channel ] = _mm_add_ps(
+                        colorSum[ channel ], _mm_mul_ps( weight, load( i_pass.m_color[ channel ], neighbour ) ) );
+                }
+                varianceSum = _mm_add_ps(
+                    varianceSum, _mm_mul_ps( _mm_mul_ps( weight, weight ), load( i_pass.m_variance, neighbour ) ) );
+            }
+        }
+
+        for ( int channel = 0; channel < 3; ++channel )
+        {
+            _mm_storeu_ps( i_pass.m_filteredColor[ channel ] + i_index, _mm_div_ps( colorSum[ channel ], weightSum ) );
+        }
+        _mm_storeu_ps( i_pass.m_filteredVariance + i_index,
+                       _mm_div_ps( varianceSum, _mm_mul_ps( weightSum, weightSum ) ) );
+    }
+
+    // Compute exp(-x) of non-negative \p i_values, by splitting off the integer powers of two, which are
+    // written into the exponent bits, and approximating the remainder with its Taylor polynomial.
+    static inline __m128 _ExpNegative( __m128 i_values )
+    {
+        __m128  values    = _mm_sub_ps( _mm_setzero_ps(), _mm_min_ps( i_values, _mm_set1_ps( c_maxExponent ) ) );
+        __m128i powerOf2  = _mm_cvtps_epi32( _mm_mul_ps( values, _mm_set1_ps( 1.44269504f ) ) );
+        __m128  remainder = _mm_sub_ps( values, _mm_mul_ps( _mm_cvtepi32_ps( powerOf2 ), _mm_set1_ps( 0.69314718f ) ) );
+
+        __m128 polynomial = _mm_set1_ps( 1.0f / 120.0f );
+        polynomial = _mm_add_ps( _mm_mul_ps( polynomial, remainder ), _mm_set1_ps( 1.0f / 24.0f ) );
+        polynomial = _mm_add_ps( _mm_mul_ps( polynomial, remainder ), _mm_set1_ps( 1.0f / 6.0f ) );
+        polynomial = _mm_add_ps( _mm_mul_ps( polynomial, remainder ), _mm_set1_ps( 0.5f ) );
+        polynomial = _mm_add_ps( _mm_mul_ps( polynomial, remainder ), _mm_set1_ps( 1.0f ) );
+        polynomial = _mm_add_ps( _mm_mul_ps( polynomial, remainder ), _mm_set1_ps( 1.0f ) );
+
+        __m128 scale = _mm_castsi128_ps( _mm_slli_epi32( _mm_add_epi32( powerOf2, _mm_set1_epi32( 127 ) ), 23 ) );
+        return _mm_mul_ps( polynomial, scale );
+    }
+#endif
+
+    int          m_iterationCount = 0;
+    float        m_colorSigma     = 0.0f;
+    float        m_depthSigma     = 0.0f;
+    TileRenderer m_bandRenderer;
+};
+
+RAYTRACE_NS_CLOSE
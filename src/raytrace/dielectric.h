@@ -8,7 +8,9 @@
 #include <gm/types/vec3f.h>
 
 #include <gm/functions/clamp.h>
+#include <gm/functions/dotProduct.h>
 #include <gm/functions/min.h>
+#include <gm/functions/normalize.h>
 
 #include <raytrace/hitRecord.h>
 #include <raytrace/material.h>
@@ -40,10 +42,11 @@ public:
     {
     }
 
-    inline virtual bool Scatter( const raytrace::Ray& i_ray,
-                                 const HitRecord&     i_hitRecord,
-                                 gm::Vec3f&           o_attenuation,
-                                 raytrace::Ray&       o_scatteredRay ) const override
+    inline virtual bool Scatter( const raytrace::Ray&   i_ray,
+                                 const HitRecord&       i_hitRecord,
+                                 Sampler&               io_sampler,
+                                 gm::Vec3f&             o_attenuation,
+                                 raytrace::Ray&         o_scatteredRay ) const override
     {
         // Fixed attenuation color
         o_attenuation = gm::Vec3f( 1.0f, 1.0f, 1.0f );
@@ -85,7 +88,7 @@ public:
 
         // Schlick approximation for reflections produced when the ray is at a steep angle to
         // to the geometric surface normal.
-        if ( gm::RandomNumber( gm::FloatRange( 0.0f, 1.0f ) ) < Schlick( cosTheta, incidentIndex / refractedIndex ) )
+        if ( io_sampler.Get1D() < Schlick( cosTheta, incidentIndex / refractedIndex ) )
         {
             o_scatteredRay = raytrace::Ray( /* origin */ i_hitRecord.m_position,
                                             /* direction */ Reflect( normRayDir, incidentNormal ),
@@ -102,6 +105,11 @@ public:
         return true;
     }
 
+    inline virtual bool IsSpecular() const override
+    {
+        return true;
+    }
+
 private:
     float m_refractiveIndex = 1.0f;
 };
@@ -26,10 +26,11 @@ public:
     /// This material emits light, but does not scatter any rays.
     ///
     /// \retval false
-    inline virtual bool Scatter( const raytrace::Ray& i_ray,
-                                 const HitRecord&     i_hitRecord,
-                                 gm::Vec3f&           o_attenuation,
-                                 raytrace::Ray&       o_scatteredRay ) const override
+    inline virtual bool Scatter( const raytrace::Ray&   i_ray,
+                                 const HitRecord&       i_hitRecord,
+                                 Sampler&               io_sampler,
+                                 gm::Vec3f&             o_attenuation,
+                                 raytrace::Ray&         o_scatteredRay ) const override
     {
         return false;
     }
@@ -39,6 +40,11 @@ public:
         return m_emissive->Sample( i_uv, i_position );
     }
 
+    inline virtual bool IsEmissive() const override
+    {
+        return true;
+    }
+
 private:
     TextureSharedPtr m_emissive;
 };
@@ -0,0 +1,208 @@
+#pragma once
+
+/// \file raytrace/exrImageWriter.h
+///
+/// Serialization of multi-channel floating point images into an OpenEXR file on disk.
+///
+/// Reference: "OpenEXR File Layout", https://openexr.com/en/latest/OpenEXRFileLayout.html
+
+#include <raytrace/raytrace.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class EXRChannel
+///
+/// A channel of 32-bit floating point values, to write into an OpenEXR image.
+class EXRChannel
+{
+public:
+    /// The name of the channel, such as "Z", or "albedo.R" for the red channel of the "albedo" layer.
+    std::string m_name;
+
+    /// The value of the first pixel of the bottom row.  Pixels follow in row-major order, as in \ref ImageBuffer.
+    const float* m_values = nullptr;
+
+    /// The number of floats between the values of consecutive pixels.
+    int m_stride = 1;
+};
+
+/// \class EXREncoder
+///
+/// EXREncoder encodes channels of floating point values into the contents of an uncompressed, scanline
+/// OpenEXR file.
+///
+/// Uncompressed scanlines keep the encoding a plain copy of the values, with a fixed size per row, which
+/// any OpenEXR reader supports.
+class EXREncoder
+{
+public:
+    /// Encode the channels \p i_channels of an image into the contents of an OpenEXR file.
+    ///
+    /// \param i_width The width of the image.
+    /// \param i_height The height of the image.
+    /// \param i_channels The channels of the image.  Their names must be unique.
+    ///
+    /// \return The OpenEXR file contents.
+    static inline std::vector< uint8_t >
+    Encode( int i_width, int i_height, const std::vector< EXRChannel >& i_channels )
+    {
+        // Channels are stored in alphabetical order of their names.
+        std::vector< EXRChannel > channels = i_channels;
+        std::sort( channels.begin(), channels.end(), []( const EXRChannel& i_lhs, const EXRChannel& i_rhs ) {
+            return i_lhs.m_name < i_rhs.m_name;
+        } );
+
+        // Magic number, then version 2, of a single part scanline image.
+        std::vector< uint8_t > file = {0x76, 0x2f, 0x31, 0x01, 2, 0, 0, 0};
+
+        std::vector< uint8_t > channelList;
+        for ( const EXRChannel& channel : channels )
+        {
+            channelList.insert( channelList.end(), channel.m_name.begin(), channel.m_name.end() );
+            channelList.push_back( 0 );
+            _AppendInt32( c_pixelTypeFloat, channelList );
+            _AppendInt32( 0, channelList ); // Perceptually linear flag, then reserved bytes.
+            _AppendInt32( 1, channelList ); // Horizontal sampling.
+            _AppendInt32( 1, channelList ); // Vertical sampling.
+        }
+        channelList.push_back( 0 );
+
+        std::vector< uint8_t > window;
+        _AppendInt32( 0, window );
+        _AppendInt32( 0, window );
+        _AppendInt32( i_width - 1, window );
+        _AppendInt32( i_height - 1, window );
+
+        std::vector< uint8_t > unitFloat;
+        _AppendFloat( 1.0f, unitFloat );
+
+        _AppendAttribute( "channels", "chlist", channelList, file );
+        _AppendAttribute( "compression", "compression", {0}, file ); // No compression.
+        _AppendAttribute( "dataWindow", "box2i", window, file );
+        _AppendAttribute( "displayWindow", "box2i", window, file );
+        _AppendAttribute( "lineOrder", "lineOrder", {0}, file ); // Increasing Y.
+        _AppendAttribute( "pixelAspectRatio", "float", unitFloat, file );
+        _AppendAttribute( "screenWindowCenter", "v2f", std::vector< uint8_t >( 8, 0 ), file );
+        _AppendAttribute( "screenWindowWidth", "float", unitFloat, file );
+        file.push_back( 0 );
+
+        // Table of the file offsets of each scanline, followed by the scanlines.  Each scanline is its line
+        // number and size, then the values of each channel in turn.
+        size_t lineSize    = ( size_t ) i_width * channels.size() * sizeof( float );
+        size_t tableOffset = file.size();
+        size_t linesOffset = tableOffset + ( size_t ) i_height * sizeof( uint64_t );
+        file.resize( linesOffset + ( size_t ) i_height * ( 2 * sizeof( int32_t ) + lineSize ) );
+        for ( int line = 0; line < i_height; ++line )
+        {
+            uint64_t lineOffset = linesOffset + ( uint64_t ) line * ( 2 * sizeof( int32_t ) + lineSize );
+            _StoreLittleEndian( lineOffset, sizeof( uint64_t ), file.data() + tableOffset + line * sizeof( uint64_t ) );
+
+            // Lines are numbered from the top down.
+            uint8_t* output = file.data() + lineOffset;
+            _StoreLittleEndian( ( uint32_t ) line, sizeof( int32_t ), output );
+            _StoreLittleEndian( ( uint32_t ) lineSize, sizeof( int32_t ), output + sizeof( int32_t ) );
+            output += 2 * sizeof( int32_t );
+
+            size_t rowOffset = ( size_t )( i_height - 1 - line ) * i_width;
+            for ( const EXRChannel& channel : channels )
+            {
+                const float* values = channel.m_values + rowOffset * channel.m_stride;
+                for ( int xCoord = 0; xCoord < i_width; ++xCoord )
+                {
+                    uint32_t bits;
+                    std::memcpy( &bits, values + xCoord * channel.m_stride, sizeof( float ) );
+                    _StoreLittleEndian( bits, sizeof( float ), output );
+                    output += sizeof( float );
+                }
+            }
+        }
+
+        return file;
+    }
+
+private:
+    // The pixel type of 32-bit floating point channels.
+    static constexpr int32_t c_pixelTypeFloat = 2;
+
+    // Append an attribute of the header, named \p i_name, with type \p i_type and contents \p i_data, to
+    // \p io_file.
+    static inline void _AppendAttribute( const std::string&            i_name,
+                                         const std::string&            i_type,
+                                         const std::vector< uint8_t >& i_data,
+                                         std::vector< uint8_t >&       io_file )
+    {
+        io_file.insert( io_file.end(), i_name.begin(), i_name.end() );
+        io_file.push_back( 0 );
+        io_file.insert( io_file.end(), i_type.begin(), i_type.end() );
+        io_file.push_back( 0 );
+        _AppendInt32( ( int32_t ) i_data.size(), io_file );
+        io_file.insert( io_file.end(), i_data.begin(), i_data.end() );
+    }
+
+    // Append \p i_value to \p io_output, in little endian byte order.
+    static inline void _AppendInt32( int32_t i_value, std::vector< uint8_t >& io_output )
+    {
+        size_t offset = io_output.size();
+        io_output.resize( offset + sizeof( int32_t ) );
+        _StoreLittleEndian( ( uint32_t ) i_value, sizeof( int32_t ), io_output.data() + offset );
+    }
+
+    // Append \p i_value to \p io_output, in little endian byte order.
+    static inline void _AppendFloat( float i_value, std::vector< uint8_t >& io_output )
+    {
+        uint32_t bits;
+        std::memcpy( &bits, &i_value, sizeof( float ) );
+        _AppendInt32( ( int32_t ) bits, io_output );
+    }
+
+    // Store the \p i_byteCount low bytes of \p i_value at \p o_output, in little endian byte order.
+    static inline void _StoreLittleEndian( uint64_t i_value, size_t i_byteCount, uint8_t* o_output )
+    {
+        for ( size_t byteIndex = 0; byteIndex < i_byteCount; ++byteIndex )
+        {
+            o_output[ byteIndex ] = ( uint8_t )( i_value >> ( 8 * byteIndex ) );
+        }
+    }
+};
+
+/// Write the channels \p i_channels of an image into file location \p i_filePath, as an uncompressed OpenEXR.
+///
+/// \param i_width The width of the image.
+/// \param i_height The height of the image.
+/// \param i_channels The channels of the image.  Their names must be unique.
+/// \param i_filePath file location to save the OpenEXR image.
+///
+/// \return success of writing the image.
+inline bool WriteEXRImage( int                              i_width,
+                           int                              i_height,
+                           const std::vector< EXRChannel >& i_channels,
+                           const std::string&               i_filePath )
+{
+    std::ofstream fileOutput( i_filePath.c_str(), std::ios::out | std::ios::trunc | std::ios::binary );
+    if ( !fileOutput.is_open() )
+    {
+        fprintf( stderr, "Cannot open file '%s' for writing!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    std::vector< uint8_t > file = EXREncoder::Encode( i_width, i_height, i_channels );
+    fileOutput.write( reinterpret_cast< const char* >( file.data() ), file.size() );
+    fileOutput.close();
+    if ( !fileOutput )
+    {
+        fprintf( stderr, "Failed to write image '%s'!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,116 @@
+#pragma once
+
+/// \file raytrace/haltonSampler.h
+///
+/// Sampler producing values from the scrambled Halton sequence.
+
+#include <raytrace/sampler.h>
+
+RAYTRACE_NS_OPEN
+
+/// \class HaltonSampler
+///
+/// HaltonSampler produces the values of dimension \em d as the radical inverse of the sample index, in the
+/// base of the \em d'th prime number.
+///
+/// The digits of each radical inverse are scrambled with a random permutation, which depends on the pixel,
+/// dimension, and the digits preceding it (Owen scrambling).  This decorrelates the pixels and the dimensions
+/// with large bases, while retaining the stratification of the sequence.  The zero digits which follow those of
+/// the sample index are permuted like any other, such that samples sharing the leading digits remain stratified.
+///
+/// Beyond the supported primes, the values of a dimension are drawn independently.
+class HaltonSampler : public Sampler
+{
+public:
+    /// Explicit constructor with the number of samples per pixel.
+    ///
+    /// \param i_samplesPerPixel The number of samples which each pixel will take.
+    /// \param i_seed The seed which the sample values are randomized with.
+    inline explicit HaltonSampler( int i_samplesPerPixel, uint32_t i_seed = 0 )
+        : Sampler( i_samplesPerPixel, i_seed )
+    {
+    }
+
+    virtual inline SamplerPtr Clone() const override
+    {
+        return SamplerPtr( new HaltonSampler( *this ) );
+    }
+
+    virtual inline float Get1D() override
+    {
+        float value = _SampleDimension( m_dimension );
+        m_dimension += 1;
+        return value;
+    }
+
+    virtual inline gm::Vec2f Get2D() override
+    {
+        float x = _SampleDimension( m_dimension );
+        float y = _SampleDimension( m_dimension + 1 );
+        m_dimension += 2;
+        return gm::Vec2f( x, y );
+    }
+
+private:
+    // The prime bases of the supported dimensions.
+    static constexpr int c_primeCount = 64;
+    static inline const uint32_t* _Primes()
+    {
+        static const uint32_t primes[ c_primeCount ] = {
+            2,   3,   5,   7,   11,  13,  17,  19,  23,  29,  31,  37,  41,  43,  47,  53,
+            59,  61,  67,  71,  73,  79,  83,  89,  97,  101, 103, 107, 109, 113, 127, 131,
+            137, 139, 149, 151, 157, 163, 167, 173, 179, 181, 191, 193, 197, 199, 211, 223,
+            227, 229, 233, 239, 241, 251, 257, 263, 269, 271, 277, 281, 283, 293, 307, 311};
+        return primes;
+    }
+
+    // Compute the value of dimension \p i_dimension, for the current sample.
+    inline float _SampleDimension( int i_dimension )
+    {
+        if ( i_dimension >= c_primeCount )
+        {
+            // Keep the random number stream positioned at the dimension which follows.
+            return m_random.UniformFloat();
+        }
+
+        float value =
+            _ScrambledRadicalInverse( _Primes()[ i_dimension ], m_sampleIndex, _DimensionHash( i_dimension ) );
+        m_random.UniformUInt32();
+        return value;
+    }
+
+    // Compute the radical inverse of \p i_index in \p i_base, with the digits permuted by Owen scrambling.
+    static inline float _ScrambledRadicalInverse( uint32_t i_base, uint32_t i_index, uint32_t i_hash )
+    {
+        float    inverseBase      = 1.0f / ( float ) i_base;
+        float    inverseBasePower = 1.0f;
+        uint32_t digitCount       = 0;
+        uint64_t reversedDigits   = 0;
+
+        // The zero digits beyond the end of the index are permuted too, until they fall below the resolution of a
+        // float.  Otherwise every value would lie on the lattice of the preceding digits.
+        while ( 1.0f - ( float ) ( i_base - 1 ) * inverseBasePower < 1.0f )
+        {
+            uint32_t nextIndex = i_index / i_base;
+            uint32_t digit     = i_index - nextIndex * i_base;
+
+            // The permutation of each digit depends on the digits preceding it.
+            digit = _PermutationElement( digit, i_base, _PrefixHash( i_hash, digitCount, reversedDigits ) );
+
+            reversedDigits = reversedDigits * i_base + digit;
+            inverseBasePower *= inverseBase;
+            i_index = nextIndex;
+            ++digitCount;
+        }
+
+        return std::min( inverseBasePower * ( float ) reversedDigits, c_oneMinusEpsilon );
+    }
+
+    // Hash the leading \p i_digitCount digits of a scrambled radical inverse, \p i_reversedDigits.
+    static inline uint32_t _PrefixHash( uint32_t i_hash, uint32_t i_digitCount, uint64_t i_reversedDigits )
+    {
+        return _MixBits( _MixBits( ( ( uint64_t ) i_hash << 32 ) | i_digitCount ) ^ i_reversedDigits );
+    }
+};
+
+RAYTRACE_NS_CLOSE
@@ -4,10 +4,12 @@
 ///
 /// Record of a ray hitting a \ref SceneObject.
 
+#include <gm/types/vec2f.h>
 #include <gm/types/vec3f.h>
 
 #include <raytrace/material.h>
 #include <raytrace/raytrace.h>
+#include <raytrace/sceneObject.h>
 
 RAYTRACE_NS_OPEN
 
@@ -15,6 +17,9 @@ RAYTRACE_NS_OPEN
 ///
 /// HitRecord stores a record of a ray hitting a scene object, so that it may be used to influence
 /// the behavior of the next hit (of the same ray, with another object!).
+///
+/// During traversal, only the magnitude, material and object are recorded.  The surface attributes are
+/// computed once the nearest hit is known, via \ref SceneObject::ComputeSurfaceInteraction on \ref m_object.
 class HitRecord
 {
 public:
@@ -28,10 +33,25 @@ public:
     gm::Vec2f m_uv;
 
     /// Material associated with the geometry that was hit by the ray.
-    MaterialSharedPtr m_material;
+    ///
+    /// This is a non-owning reference, so that recording a candidate hit does not touch the reference count
+    /// of the material.  Materials are owned by the scene objects they are assigned to, which outlive the
+    /// rendering of the scene.
+    const Material* m_material = nullptr;
+
+    /// The scene object which was hit, responsible for computing the surface attributes.
+    const SceneObject* m_object = nullptr;
 
     /// The magnitude of the ray at the point of contact.
     float m_magnitude = 0.0f;
+
+    /// The index of the primitive which was hit, for scene objects composed of many primitives, such as the
+    /// triangles of a \ref TriangleMesh.
+    int m_primitiveIndex = 0;
+
+    /// For hits of an \ref Instance, the object hit within the instanced object, which computes the surface
+    /// attributes in object space.  \ref m_object is then the instance itself.
+    const SceneObject* m_instancedObject = nullptr;
 };
 
 RAYTRACE_NS_CLOSE
@@ -75,6 +75,22 @@ public:
         return m_buffer[ ( i_y * m_width ) + i_x ];
     }
 
+    /// Read access to the contiguous pixel values, in row-major order.
+    ///
+    /// \return pointer to the value of the first pixel.
+    inline const ValueT* Data() const
+    {
+        return m_buffer.data();
+    }
+
+    /// Write access to the contiguous pixel values, in row-major order.
+    ///
+    /// \return pointer to the value of the first pixel.
+    inline ValueT* Data()
+    {
+        return m_buffer.data();
+    }
+
     /// Resize the image buffer.
     ///
     /// If the new dimensions \p i_width and \p i_height are different from the current, the image will be resize.
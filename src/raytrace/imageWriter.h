@@ -0,0 +1,168 @@
+#pragma once
+
+/// \file raytrace/imageWriter.h
+///
+/// Writing the radiance of a render to disk, in the file format selected by the file extension.
+
+#include <raytrace/imageBuffer.h>
+#include <raytrace/pfmImageWriter.h>
+#include <raytrace/pngImageWriter.h>
+#include <raytrace/postProcessor.h>
+#include <raytrace/ppmImageWriter.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/renderSettings.h>
+#include <raytrace/tileStreamWriter.h>
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <memory>
+#include <string>
+
+RAYTRACE_NS_OPEN
+
+/// \class ImageWriter
+///
+/// ImageWriter writes the linear radiance of a render to disk, in one of the file formats:
+/// - PPM: binary, 8-bit RGB.  The radiance is graded by a \ref PostProcessor.
+/// - PNG: 8-bit RGB.  The radiance is graded by a \ref PostProcessor.
+/// - PFM: 32-bit floating point RGB.  The radiance is written as is, retaining its full dynamic range.
+class ImageWriter
+{
+public:
+    /// \enum Format
+    ///
+    /// The supported image file formats.
+    enum class Format
+    {
+        PPM,
+        PNG,
+        PFM
+    };
+
+    /// Explicit constructor with the file format, post processor and thread count.
+    ///
+    /// \param i_format The image file format to write.
+    /// \param i_postProcessor The post processor grading the radiance into 8-bit formats.
+    /// \param i_threadCount The number of threads to encode with.  Zero uses all the hardware threads.
+    inline explicit ImageWriter( Format i_format, const PostProcessor& i_postProcessor, int i_threadCount )
+        : m_format( i_format )
+        , m_postProcessor( i_postProcessor )
+        , m_threadCount( i_threadCount )
+    {
+    }
+
+    /// Write the radiance \p i_radiance into file location \p i_filePath.
+    ///
+    /// \param i_radiance The linear radiance of each pixel.
+    /// \param i_filePath file location to save the image.
+    ///
+    /// \return success of writing the image.
+    inline bool Write( const RGBImageBuffer& i_radiance, const std::string& i_filePath ) const
+    {
+        if ( m_format == Format::PFM )
+        {
+            return WritePFMImage( i_radiance, i_filePath );
+        }
+
+        RGBImageBuffer image( i_radiance.Width(), i_radiance.Height() );
+        m_postProcessor.Apply( i_radiance, image );
+        if ( m_format == Format::PNG )
+        {
+            return WritePNGImage( image, i_filePath, m_threadCount );
+        }
+        else
+        {
+            return WritePPMImage( image, i_filePath, m_threadCount );
+        }
+    }
+
+    /// Open a stream writing the image into file location \p i_filePath tile by tile, as tiles finish rendering.
+    ///
+    /// PNG files are compressed as a whole, so they cannot be streamed.
+    ///
+    /// \param i_filePath file location to save the image.
+    /// \param i_width The width of the image.
+    /// \param i_height The height of the image.
+    /// \param i_maxQueuedTiles The number of finished tiles which may wait to be written.
+    ///
+    /// \return The stream, or null if the file format cannot be streamed, or the file cannot be created.
+    /// \sa TileStreamWriter
+    inline TileStreamWriterPtr
+    OpenTileStream( const std::string& i_filePath, int i_width, int i_height, int i_maxQueuedTiles ) const
+    {
+        if ( m_format == Format::PNG )
+        {
+            fprintf( stderr, "PNG images cannot be streamed: '%s'!\n", i_filePath.c_str() );
+            return nullptr;
+        }
+
+        TileStreamWriter::Format format =
+            m_format == Format::PFM ? TileStreamWriter::Format::PFM : TileStreamWriter::Format::PPM;
+        TileStreamWriterPtr stream(
+            new TileStreamWriter( format, i_width, i_height, m_postProcessor, i_maxQueuedTiles ) );
+        if ( !stream->Open( i_filePath ) )
+        {
+            return nullptr;
+        }
+
+        return stream;
+    }
+
+private:
+    Format        m_format = Format::PPM;
+    PostProcessor m_postProcessor;
+    int           m_threadCount = 0;
+};
+
+/// \typedef ImageWriterPtr
+///
+/// Unique pointer to an image writer.
+using ImageWriterPtr = std::unique_ptr< ImageWriter >;
+
+/// Create the image writer described by \p i_settings.
+///
+/// The file format is selected by the (case insensitive) extension of \ref RenderSettings::m_outputFilePath:
+/// ".ppm", ".png" or ".pfm".
+///
+/// \param i_settings The render settings.
+///
+/// \return The image writer, or null if the file extension or the tone mapping curve is not recognized.
+inline ImageWriterPtr CreateImageWriter( const RenderSettings& i_settings )
+{
+    PostProcessorPtr postProcessor = CreatePostProcessor( i_settings );
+    if ( !postProcessor )
+    {
+        return nullptr;
+    }
+
+    const std::string& filePath       = i_settings.m_outputFilePath;
+    size_t             extensionIndex = filePath.find_last_of( '.' );
+    std::string        extension = extensionIndex == std::string::npos ? "" : filePath.substr( extensionIndex + 1 );
+    std::transform( extension.begin(), extension.end(), extension.begin(), []( unsigned char i_character ) {
+        return ( char ) std::tolower( i_character );
+    } );
+
+    ImageWriter::Format format;
+    if ( extension == "ppm" )
+    {
+        format = ImageWriter::Format::PPM;
+    }
+    else if ( extension == "png" )
+    {
+        format = ImageWriter::Format::PNG;
+    }
+    else if ( extension == "pfm" )
+    {
+        format = ImageWriter::Format::PFM;
+    }
+    else
+    {
+        std::cerr << "Unrecognized image file extension: " << filePath << std::endl;
+        return nullptr;
+    }
+
+    return ImageWriterPtr( new ImageWriter( format, *postProcessor, i_settings.m_threadCount ) );
+}
+
+RAYTRACE_NS_CLOSE
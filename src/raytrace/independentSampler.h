@@ -0,0 +1,48 @@
+#pragma once
+
+/// \file raytrace/independentSampler.h
+///
+/// Sampler producing independent, uniformly distributed random values.
+
+#include <raytrace/sampler.h>
+
+RAYTRACE_NS_OPEN
+
+/// \class IndependentSampler
+///
+/// IndependentSampler draws every value independently, from the random number stream of the pixel sample.
+///
+/// This is plain Monte Carlo sampling, which serves as the baseline the other samplers improve upon.
+class IndependentSampler : public Sampler
+{
+public:
+    /// Explicit constructor with the number of samples per pixel.
+    ///
+    /// \param i_samplesPerPixel The number of samples which each pixel will take.
+    /// \param i_seed The seed which the sample values are randomized with.
+    inline explicit IndependentSampler( int i_samplesPerPixel, uint32_t i_seed = 0 )
+        : Sampler( i_samplesPerPixel, i_seed )
+    {
+    }
+
+    virtual inline SamplerPtr Clone() const override
+    {
+        return SamplerPtr( new IndependentSampler( *this ) );
+    }
+
+    virtual inline float Get1D() override
+    {
+        m_dimension += 1;
+        return m_random.UniformFloat();
+    }
+
+    virtual inline gm::Vec2f Get2D() override
+    {
+        m_dimension += 2;
+        float x = m_random.UniformFloat();
+        float y = m_random.UniformFloat();
+        return gm::Vec2f( x, y );
+    }
+};
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,123 @@
+#pragma once
+
+/// \file raytrace/instance.h
+///
+/// Placement of a shared scene object with a transformation.
+
+#include <raytrace/hitRecord.h>
+#include <raytrace/ray.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/base/diagnostic.h>
+
+#include <gm/functions/inverse.h>
+#include <gm/functions/normalize.h>
+#include <gm/functions/transformAABB.h>
+#include <gm/functions/transformPoint.h>
+#include <gm/functions/transformVector.h>
+#include <gm/functions/transpose.h>
+
+#include <gm/types/mat4f.h>
+#include <gm/types/vec3fRange.h>
+
+RAYTRACE_NS_OPEN
+
+/// \class Instance
+///
+/// Instance places a shared scene object, such as a \ref TriangleMesh or the result of \ref BuildBVH, in the scene
+/// with an object-to-world transformation.
+///
+/// Rays are transformed into object space, rather than the object into world space, so any number of instances
+/// share a single copy of the object and its acceleration structure.  Building a BVH over the instances themselves
+/// yields a two-level hierarchy: the top level over the instances, and the bottom level within the shared object.
+///
+/// The ray direction is transformed without normalization, such that hit magnitudes are the same in both spaces.
+///
+/// Only two levels are supported: the instanced object must not itself contain instances.  Emissive objects
+/// which are instanced are not sampled as lights, see \ref SceneObject::SurfaceMaterial.
+class Instance : public SceneObject
+{
+public:
+    /// Construct an instance of \p i_object.
+    ///
+    /// \param i_object The object to instance, which may be shared by other instances.
+    /// \param i_objectToWorld The transformation from the space of \p i_object into world space.  Must be invertible.
+    inline explicit Instance( const SceneObjectPtr& i_object, const gm::Mat4f& i_objectToWorld )
+        : m_object( i_object )
+        , m_objectToWorld( i_objectToWorld )
+    {
+        bool invertible = gm::Inverse( m_objectToWorld, m_worldToObject );
+        GM_ASSERT( invertible );
+        ( void ) invertible;
+
+        // Normals are transformed by the inverse transpose, to remain perpendicular to the transformed surface.
+        m_normalToWorld = gm::Transpose( m_worldToObject );
+    }
+
+    virtual inline bool
+    Hit( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const override
+    {
+        if ( !m_object->Hit( _ToObjectSpace( i_ray ), i_magnitudeRange, o_record ) )
+        {
+            return false;
+        }
+
+        o_record.m_instancedObject = o_record.m_object;
+        o_record.m_object          = this;
+        return true;
+    }
+
+    virtual inline bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const override
+    {
+        return m_object->Occluded( _ToObjectSpace( i_ray ), i_magnitudeRange );
+    }
+
+    virtual inline void ComputeSurfaceInteraction( const raytrace::Ray& i_ray, HitRecord& io_record ) const override
+    {
+        GM_ASSERT( io_record.m_instancedObject != nullptr );
+        io_record.m_instancedObject->ComputeSurfaceInteraction( _ToObjectSpace( i_ray ), io_record );
+        io_record.m_position = gm::TransformPoint( m_objectToWorld, io_record.m_position );
+        io_record.m_normal   = gm::Normalize( gm::TransformVector( m_normalToWorld, io_record.m_normal ) );
+    }
+
+    virtual inline gm::Vec3fRange Extent( const std::vector< float >& i_times ) const override
+    {
+        gm::Vec3fRange objectExtent = m_object->Extent( i_times );
+        if ( objectExtent.IsEmpty() )
+        {
+            return objectExtent;
+        }
+
+        return gm::TransformAABB( m_objectToWorld, objectExtent );
+    }
+
+    /// Get the instanced object.
+    inline const SceneObjectPtr& Object() const
+    {
+        return m_object;
+    }
+
+    /// Get the transformation from the space of the instanced object into world space.
+    inline const gm::Mat4f& ObjectToWorld() const
+    {
+        return m_objectToWorld;
+    }
+
+private:
+    // Transform \p i_ray from world space into the space of the instanced object.
+    inline raytrace::Ray _ToObjectSpace( const raytrace::Ray& i_ray ) const
+    {
+        return raytrace::Ray( gm::TransformPoint( m_worldToObject, i_ray.Origin() ),
+                              gm::TransformVector( m_worldToObject, i_ray.Direction() ),
+                              i_ray.Time() );
+    }
+
+    SceneObjectPtr m_object;
+    gm::Mat4f      m_objectToWorld;
+
+    // Derived from the object-to-world transformation, once, rather than per ray.
+    gm::Mat4f m_worldToObject;
+    gm::Mat4f m_normalToWorld;
+};
+
+RAYTRACE_NS_CLOSE
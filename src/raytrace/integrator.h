@@ -0,0 +1,343 @@
+#pragma once
+
+/// \file raytrace/integrator.h
+///
+/// Computation of the color carried by a ray through the scene.
+
+#include <raytrace/aovSample.h>
+#include <raytrace/hitRecord.h>
+#include <raytrace/lightList.h>
+#include <raytrace/material.h>
+#include <raytrace/ray.h>
+#include <raytrace/sampler.h>
+#include <raytrace/sceneObject.h>
+#include <raytrace/texture.h>
+
+#include <gm/functions/length.h>
+
+#include <gm/types/floatRange.h>
+#include <gm/types/vec2f.h>
+#include <gm/types/vec3f.h>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+RAYTRACE_NS_OPEN
+
+/// \var c_debugIndent
+///
+/// Indentation used when printing debug information.  4 spaces.
+constexpr const char* c_debugIndent = "    ";
+
+/// \class Integrator
+///
+/// Integrator computes the color of light arriving along a ray, by tracing it through the scene and
+/// following its scattered descendents.
+class Integrator
+{
+public:
+    /// The number of sample dimensions consumed by the camera ray: the position within the pixel (2), the
+    /// position on the lens (2), and the time (1).  The dimensions of the first bounce follow.
+    static constexpr int c_cameraDimensionCount = 5;
+
+    /// The number of sample dimensions reserved for each bounce: up to 3 for the material scattering,
+    /// followed by 1 for russian roulette, then 3 for sampling a light.
+    static constexpr int c_bounceDimensionCount = 7;
+
+    /// Explicit constructor with the scene to trace rays against.
+    ///
+    /// \param i_rootObject The root object to perform hit tests against.
+    /// \param i_background The texture sampled, by ray direction, when a ray does not hit an object.
+    /// \param i_rayBounceLimit The number of bounces a ray can perform before it is retired.
+    /// \param i_russianRouletteDepth The number of bounces a ray performs before it becomes subject to
+    /// russian roulette termination.
+    /// \param i_lights The lights to sample directly at each bounce.  Empty disables light sampling.
+    inline explicit Integrator( const SceneObjectPtr&   i_rootObject,
+                                const TextureSharedPtr& i_background,
+                                int                     i_rayBounceLimit,
+                                int                     i_russianRouletteDepth,
+                                const LightList&        i_lights = LightList() )
+        : m_rootObject( i_rootObject )
+        , m_background( i_background )
+        , m_rayBounceLimit( i_rayBounceLimit )
+        , m_russianRouletteDepth( i_russianRouletteDepth )
+        , m_lights( i_lights )
+    {
+    }
+
+    /// Compute the ray color.
+    ///
+    /// The ray is traced iteratively through the scene.  At each surface hit, the emission of the surface,
+    /// weighted by the throughput of the path so far, is accumulated into the color.  The throughput is then
+    /// attenuated by the surface material, and the path continues along the scattered ray.
+    ///
+    /// In the case where the path escapes the scene, the background is sampled.
+    ///
+    /// If there are lights, they are also sampled directly at each surface hit whose material can be evaluated
+    /// (see \ref Material::EvaluateScatter), and the sampled point is tested for visibility with a shadow ray.
+    /// Light reached both ways is combined by multiple importance sampling, with the power heuristic: each estimate
+    /// is weighted by how likely its own strategy was to produce it, relative to the other.  Small lights are
+    /// then found by light sampling, and large or glossy reflections of lights by scattering.
+    ///
+    /// Reference: "Optimally Combining Sampling Techniques for Monte Carlo Rendering", Veach and Guibas 1995.
+    ///
+    /// Once the path has performed \ref m_russianRouletteDepth bounces, it is randomly terminated with a
+    /// probability inversely proportional to its throughput.  Surviving paths have their throughput
+    /// scaled up by the inverse of the survival probability, which keeps the estimate unbiased.
+    ///
+    /// Each bounce draws from its own block of \ref c_bounceDimensionCount sampler dimensions, such that a
+    /// given dimension serves the same purpose across all the samples of a pixel.
+    ///
+    /// \param i_ray The incident ray.
+    /// \param io_sampler The sampler of the sample, which scattering and termination draw from.
+    /// \param i_printDebug Optional flag to enable printing of debug ray information.
+    ///
+    /// \return The computed ray color.
+    inline gm::Vec3f ComputeRayColor( const raytrace::Ray& i_ray, Sampler& io_sampler, bool i_printDebug = false ) const
+    {
+        gm::Vec3f     color( 0, 0, 0 );
+        gm::Vec3f     throughput( 1, 1, 1 );
+        raytrace::Ray ray = i_ray;
+
+        // The probability density of scattering along the ray, or zero if its direction could not have been
+        // produced by light sampling, such as camera rays and rays scattered by mirrors.
+        float scatterPdf = 0.0f;
+
+        for ( int bounceIndex = 0; bounceIndex < m_rayBounceLimit; ++bounceIndex )
+        {
+            if ( i_printDebug )
+            {
+                std::cout << c_debugIndent << c_debugIndent << ray << std::endl;
+                std::cout << c_debugIndent << c_debugIndent << "Num bounces: " << m_rayBounceLimit - bounceIndex
+                          << std::endl;
+            }
+
+            // Check if the ray hits any objects in the scene.
+            HitRecord      record;
+            gm::FloatRange magnitudeRange( 0.001f, // Fix for "Shadow acne" by culling hits which are too near.
+                                           std::numeric_limits< float >::max() );
+            if ( !m_rootObject->Hit( ray, magnitudeRange, record ) )
+            {
+                // Did not hit an object.  Produce background color.
+                if ( i_printDebug )
+                {
+                    std::cout << c_debugIndent << c_debugIndent << "Background colour!" << std::endl;
+                }
+
+                return color + _Multiply( throughput, m_background->Sample( gm::Vec2f( 0, 0 ), ray.Direction() ) );
+            }
+
+            // Only now that the nearest hit is known, compute its surface attributes.
+            record.m_object->ComputeSurfaceInteraction( ray, record );
+
+            if ( i_printDebug )
+            {
+                std::cout << c_debugIndent << c_debugIndent << "Hit" << std::endl
+                          << c_debugIndent << c_debugIndent << c_debugIndent << "position: " << record.m_position
+                          << std::endl
+                          << c_debugIndent << c_debugIndent << c_debugIndent << "normal: " << record.m_normal
+                          << std::endl;
+            }
+
+            // Accumulate ray emission (lights!), weighted against the chance of light sampling reaching it.
+            gm::Vec3f emission = _Multiply( throughput, record.m_material->Emit( record.m_uv, record.m_position ) );
+            if ( scatterPdf > 0.0f )
+            {
+                emission *= _PowerHeuristic( scatterPdf, m_lights.Pdf( ray.Origin(), record, ray.Time() ) );
+            }
+            color += emission;
+
+            // Sample a light directly.
+            int bounceDimension = c_cameraDimensionCount + bounceIndex * c_bounceDimensionCount;
+            if ( !m_lights.IsEmpty() )
+            {
+                io_sampler.SetDimension( bounceDimension + c_lightDimensionOffset );
+                gm::Vec3f lightColor = _SampleLight( ray, record, io_sampler );
+                if ( i_printDebug )
+                {
+                    std::cout << c_debugIndent << c_debugIndent << "Light sample: " << lightColor << std::endl;
+                }
+
+                color += _Multiply( throughput, lightColor );
+            }
+
+            // Check for ray scattering.
+            raytrace::Ray scatteredRay;
+            gm::Vec3f     attenuation;
+            io_sampler.SetDimension( bounceDimension );
+            if ( !record.m_material->Scatter( ray, record, io_sampler, attenuation, scatteredRay ) )
+            {
+                if ( i_printDebug )
+                {
+                    std::cout << c_debugIndent << c_debugIndent << "No scatter!" << std::endl;
+                }
+
+                return color;
+            }
+
+            if ( i_printDebug )
+            {
+                std::cout << c_debugIndent << c_debugIndent << "Attenuation: " << attenuation << std::endl;
+            }
+
+            // Record the probability density of the scattered direction, to weight the emission it hits.
+            gm::Vec3f scatterValue;
+            if ( m_lights.IsEmpty() || !record.m_material->EvaluateScatter(
+                                           ray, record, scatteredRay.Direction(), scatterValue, scatterPdf ) )
+            {
+                scatterPdf = 0.0f;
+            }
+
+            // Material produced a new scattered ray.
+            // To resolve an aggregate color, the throughput is attenuated by the vector product.
+            throughput = _Multiply( throughput, attenuation );
+            ray        = scatteredRay;
+
+            // Russian roulette.
+            if ( bounceIndex + 1 >= m_russianRouletteDepth )
+            {
+                float maxThroughput       = std::max( throughput[ 0 ], std::max( throughput[ 1 ], throughput[ 2 ] ) );
+                float survivalProbability = std::min( maxThroughput, 1.0f );
+                io_sampler.SetDimension( bounceDimension + c_russianRouletteDimensionOffset );
+                if ( io_sampler.Get1D() >= survivalProbability )
+                {
+                    if ( i_printDebug )
+                    {
+                        std::cout << c_debugIndent << c_debugIndent << "Terminated by russian roulette!" << std::endl;
+                    }
+
+                    return color;
+                }
+
+                throughput /= survivalProbability;
+            }
+        }
+
+        // No bounces left, terminate ray and do not produce any further color.
+        return color;
+    }
+
+    /// Compute the arbitrary output variables (AOVs) of the ray, at its first non-specular hit.
+    ///
+    /// The ray is traced like \ref ComputeRayColor, drawing from the same sampler dimensions, but only through
+    /// specular surfaces (see \ref Material::IsSpecular), whose attenuation tints the recorded albedo.  Paths
+    /// are not terminated by russian roulette, as only the first few bounces are followed.
+    ///
+    /// \param i_ray The incident ray.
+    /// \param io_sampler The sampler of the sample, which specular scattering draws from.
+    /// \param o_sample The AOVs of the ray.
+    inline void ComputeRayAOVs( const raytrace::Ray& i_ray, Sampler& io_sampler, AOVSample& o_sample ) const
+    {
+        gm::Vec3f     throughput( 1, 1, 1 );
+        float         pathLength = 0.0f;
+        raytrace::Ray ray        = i_ray;
+
+        o_sample = AOVSample();
+        for ( int bounceIndex = 0; bounceIndex < m_rayBounceLimit; ++bounceIndex )
+        {
+            HitRecord      record;
+            gm::FloatRange magnitudeRange( 0.001f, std::numeric_limits< float >::max() );
+            if ( !m_rootObject->Hit( ray, magnitudeRange, record ) )
+            {
+                o_sample.m_albedo = _Multiply( throughput, m_background->Sample( gm::Vec2f( 0, 0 ), ray.Direction() ) );
+                return;
+            }
+
+            record.m_object->ComputeSurfaceInteraction( ray, record );
+            pathLength += record.m_magnitude * gm::Length( ray.Direction() );
+
+            if ( !record.m_material->IsSpecular() )
+            {
+                o_sample.m_albedo   = _Multiply( throughput, record.m_material->Albedo( record ) );
+                o_sample.m_normal   = record.m_normal;
+                o_sample.m_depth    = pathLength;
+                o_sample.m_objectId = record.m_object->ObjectId();
+                o_sample.m_isHit    = true;
+                return;
+            }
+
+            raytrace::Ray scatteredRay;
+            gm::Vec3f     attenuation;
+            io_sampler.SetDimension( c_cameraDimensionCount + bounceIndex * c_bounceDimensionCount );
+            if ( !record.m_material->Scatter( ray, record, io_sampler, attenuation, scatteredRay ) )
+            {
+                return;
+            }
+
+            throughput = _Multiply( throughput, attenuation );
+            ray        = scatteredRay;
+        }
+    }
+
+private:
+    // The offset, within the sample dimensions of a bounce, of the dimension for russian roulette, following the
+    // dimensions for the material scattering.
+    static constexpr int c_russianRouletteDimensionOffset = 3;
+
+    // The offset, within the sample dimensions of a bounce, of the dimensions for sampling a light: 1 for selecting
+    // the light, then 2 for the point on it.
+    static constexpr int c_lightDimensionOffset = 4;
+
+    // The fraction of the distance to a sampled light point, which its shadow ray tests for occluders.  Stops short
+    // of the light, such that the light itself does not occlude the point.
+    static constexpr float c_shadowRayExtent = 1.0f - 1e-5f;
+
+    // Estimate the light arriving directly from a light, at the hit \p i_record of \p i_ray, and scattered back
+    // along the ray.  The estimate is weighted against the chance of a scattered ray reaching the same point.
+    inline gm::Vec3f _SampleLight( const raytrace::Ray& i_ray, const HitRecord& i_record, Sampler& io_sampler ) const
+    {
+        float       lightSample   = io_sampler.Get1D();
+        gm::Vec2f   surfaceSample = io_sampler.Get2D();
+        LightSample sample;
+        if ( !m_lights.Sample( lightSample, surfaceSample, i_record.m_position, i_ray.Time(), sample ) )
+        {
+            return gm::Vec3f( 0, 0, 0 );
+        }
+
+        gm::Vec3f scatterValue;
+        float     scatterPdf = 0.0f;
+        if ( !i_record.m_material->EvaluateScatter( i_ray, i_record, sample.m_direction, scatterValue, scatterPdf ) ||
+             ( scatterValue[ 0 ] <= 0.0f && scatterValue[ 1 ] <= 0.0f && scatterValue[ 2 ] <= 0.0f ) )
+        {
+            return gm::Vec3f( 0, 0, 0 );
+        }
+
+        raytrace::Ray  shadowRay( i_record.m_position, sample.m_direction, i_ray.Time() );
+        gm::FloatRange magnitudeRange( 0.001f, sample.m_distance * c_shadowRayExtent );
+        if ( m_rootObject->Occluded( shadowRay, magnitudeRange ) )
+        {
+            return gm::Vec3f( 0, 0, 0 );
+        }
+
+        return _Multiply( scatterValue, sample.m_emission ) *
+               ( _PowerHeuristic( sample.m_pdf, scatterPdf ) / sample.m_pdf );
+    }
+
+    // Weight of an estimate from a strategy with probability density \p i_pdf, combined with another strategy of
+    // probability density \p i_otherPdf, by the power heuristic.
+    static inline float _PowerHeuristic( float i_pdf, float i_otherPdf )
+    {
+        if ( i_pdf <= 0.0f )
+        {
+            return 0.0f;
+        }
+
+        float ratio = i_otherPdf / i_pdf;
+        return 1.0f / ( 1.0f + ratio * ratio );
+    }
+
+    // Component-wise product of two vectors.
+    static inline gm::Vec3f _Multiply( const gm::Vec3f& i_lhs, const gm::Vec3f& i_rhs )
+    {
+        return gm::Vec3f( i_lhs[ 0 ] * i_rhs[ 0 ], i_lhs[ 1 ] * i_rhs[ 1 ], i_lhs[ 2 ] * i_rhs[ 2 ] );
+    }
+
+    SceneObjectPtr   m_rootObject;
+    TextureSharedPtr m_background;
+    int              m_rayBounceLimit       = 0;
+    int              m_russianRouletteDepth = 0;
+    LightList        m_lights;
+};
+
+RAYTRACE_NS_CLOSE
@@ -11,6 +11,8 @@
 #include <raytrace/randomUnitVector.h>
 #include <raytrace/texture.h>
 
+#include <gm/base/constants.h>
+
 RAYTRACE_NS_OPEN
 
 /// \class Isotropic
@@ -27,14 +29,15 @@ public:
     {
     }
 
-    inline virtual bool Scatter( const raytrace::Ray& i_ray,
-                                 const HitRecord&     i_hitRecord,
-                                 gm::Vec3f&           o_attenuation,
-                                 raytrace::Ray&       o_scatteredRay ) const override
+    inline virtual bool Scatter( const raytrace::Ray&   i_ray,
+                                 const HitRecord&       i_hitRecord,
+                                 Sampler&               io_sampler,
+                                 gm::Vec3f&             o_attenuation,
+                                 raytrace::Ray&         o_scatteredRay ) const override
     {
         // Scatter the ray in a random direction.
         o_scatteredRay = raytrace::Ray( /* origin */ i_hitRecord.m_position,
-                                        /* direction */ RandomUnitVector(),
+                                        /* direction */ RandomUnitVector( io_sampler.Get2D() ),
                                         /* time */ i_ray.Time() );
 
         // Accumulate attenuation from albedo sample.
@@ -42,6 +45,23 @@ public:
         return true;
     }
 
+    /// Scattered directions are uniformly distributed over the sphere, with the albedo as attenuation.
+    inline virtual bool EvaluateScatter( const raytrace::Ray& i_ray,
+                                         const HitRecord&     i_hitRecord,
+                                         const gm::Vec3f&     i_direction,
+                                         gm::Vec3f&           o_value,
+                                         float&               o_pdf ) const override
+    {
+        o_pdf   = 1.0f / ( 4.0f * gm::Pi );
+        o_value = m_albedo->Sample( i_hitRecord.m_uv, i_hitRecord.m_position ) * o_pdf;
+        return true;
+    }
+
+    inline virtual gm::Vec3f Albedo( const HitRecord& i_hitRecord ) const override
+    {
+        return m_albedo->Sample( i_hitRecord.m_uv, i_hitRecord.m_position );
+    }
+
 private:
     TextureSharedPtr m_albedo;
 };
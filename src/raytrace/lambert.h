@@ -11,6 +11,13 @@
 #include <raytrace/randomUnitVector.h>
 #include <raytrace/texture.h>
 
+#include <gm/base/constants.h>
+
+#include <gm/functions/dotProduct.h>
+#include <gm/functions/normalize.h>
+
+#include <algorithm>
+
 RAYTRACE_NS_OPEN
 
 /// \class Lambert
@@ -30,15 +37,16 @@ public:
     {
     }
 
-    inline virtual bool Scatter( const raytrace::Ray& i_ray,
-                                 const HitRecord&     i_hitRecord,
-                                 gm::Vec3f&           o_attenuation,
-                                 raytrace::Ray&       o_scatteredRay ) const override
+    inline virtual bool Scatter( const raytrace::Ray&   i_ray,
+                                 const HitRecord&       i_hitRecord,
+                                 Sampler&               io_sampler,
+                                 gm::Vec3f&             o_attenuation,
+                                 raytrace::Ray&         o_scatteredRay ) const override
     {
         // Produce random scatter direction.
-        gm::Vec3f rayTarget = i_hitRecord.m_position + // From the hit point...
-                              i_hitRecord.m_normal +   // Add a unit in the direction of the normal.
-                              RandomUnitVector();      // Add random unit vector.
+        gm::Vec3f rayTarget = i_hitRecord.m_position +              // From the hit point...
+                              i_hitRecord.m_normal +                // Add a unit in the direction of the normal.
+                              RandomUnitVector( io_sampler.Get2D() ); // Add random unit vector.
         o_scatteredRay = raytrace::Ray( /* origin */ i_hitRecord.m_position,
                                         /* direction */ gm::Normalize( rayTarget - i_hitRecord.m_position ),
                                         /* time */ i_ray.Time() );
@@ -49,6 +57,24 @@ public:
         return true;
     }
 
+    /// Scattered directions are cosine distributed about the normal, with the albedo as attenuation.
+    inline virtual bool EvaluateScatter( const raytrace::Ray& i_ray,
+                                         const HitRecord&     i_hitRecord,
+                                         const gm::Vec3f&     i_direction,
+                                         gm::Vec3f&           o_value,
+                                         float&               o_pdf ) const override
+    {
+        float cosine = std::max( gm::DotProduct( i_hitRecord.m_normal, i_direction ), 0.0f );
+        o_pdf        = cosine / gm::Pi;
+        o_value      = m_albedo->Sample( i_hitRecord.m_uv, i_hitRecord.m_position ) * o_pdf;
+        return true;
+    }
+
+    inline virtual gm::Vec3f Albedo( const HitRecord& i_hitRecord ) const override
+    {
+        return m_albedo->Sample( i_hitRecord.m_uv, i_hitRecord.m_position );
+    }
+
 private:
     TextureSharedPtr m_albedo;
 };
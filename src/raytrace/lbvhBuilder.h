@@ -0,0 +1,259 @@
+#pragma once
+
+/// \file raytrace/lbvhBuilder.h
+///
+/// Linear bounding volume hierarchy (LBVH) builder, based on sorting objects along a Morton curve.
+
+#include <raytrace/bvhBuildNode.h>
+#include <raytrace/bvhBuilder.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/types/vec3f.h>
+#include <gm/types/vec3fRange.h>
+
+#include <gm/functions/expand.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class LBVHBuilder
+///
+/// LBVHBuilder constructs a binary BVH build tree by sorting the scene objects along a Morton (Z-order) curve.
+///
+/// The centroid of each object is quantized onto a 1024^3 grid, and the bits of its grid coordinates are
+/// interleaved into a 30-bit Morton code.  Objects are ordered by their Morton code with a radix sort, such that
+/// objects which are close in space are close in the ordering.  The hierarchy is formed by recursively
+/// splitting each range of objects where the highest differing bit of their Morton codes changes, which
+/// partitions space at the midpoint of the grid cell shared by the range.
+///
+/// The build runs in time linear to the number of objects, which makes it well suited to interactive
+/// restarts.  Split positions do not take object extents into account though, so the resulting tree is
+/// typically more expensive to trace than one from \ref SAHBVHBuilder.
+class LBVHBuilder : public BVHBuilder
+{
+public:
+    /// Explicit constructor with the builder parameters.
+    ///
+    /// \param i_leafSize The maximum number of objects which a leaf node may hold, up to \ref c_bvhMaxLeafSize.
+    /// \param i_threadCount The number of threads to build with.  If zero or negative, the number of
+    /// concurrent threads supported by the hardware is used.
+    inline explicit LBVHBuilder( int i_leafSize = 4, int i_threadCount = 1 )
+        : BVHBuilder( i_threadCount, /* traversalCost */ 1.0f, /* intersectionCost */ 1.0f )
+        , m_leafSize( std::min( std::max( i_leafSize, 1 ), c_bvhMaxLeafSize ) )
+    {
+    }
+
+    virtual inline std::unique_ptr< BVHBuildNode > Build( const SceneObjectPtrs&      i_sceneObjects,
+                                                          const std::vector< float >& i_times,
+                                                          SceneObjectPtrs&            o_orderedObjects ) const override
+    {
+        o_orderedObjects.clear();
+        if ( i_sceneObjects.empty() )
+        {
+            return nullptr;
+        }
+
+        // Compute the extent of each object, once.
+        std::vector< gm::Vec3fRange > extents( i_sceneObjects.size() );
+        _ParallelFor( extents.size(), [&]( int i_begin, int i_end ) {
+            for ( int objectIndex = i_begin; objectIndex < i_end; ++objectIndex )
+            {
+                extents[ objectIndex ] = i_sceneObjects[ objectIndex ]->Extent( i_times );
+            }
+        } );
+
+        gm::Vec3fRange centroidExtent;
+        for ( const gm::Vec3fRange& extent : extents )
+        {
+            centroidExtent = gm::Expand( centroidExtent, ( extent.Min() + extent.Max() ) * 0.5f );
+        }
+
+        // Compute the Morton code of each object centroid.
+        std::vector< _MortonObject > mortonObjects( i_sceneObjects.size() );
+        _ParallelFor( mortonObjects.size(), [&]( int i_begin, int i_end ) {
+            for ( int objectIndex = i_begin; objectIndex < i_end; ++objectIndex )
+            {
+                gm::Vec3f centroid = ( extents[ objectIndex ].Min() + extents[ objectIndex ].Max() ) * 0.5f;
+                mortonObjects[ objectIndex ].m_code  = _ComputeMortonCode( centroid, centroidExtent );
+                mortonObjects[ objectIndex ].m_index = objectIndex;
+            }
+        } );
+
+        _RadixSort( mortonObjects );
+
+        std::unique_ptr< BVHBuildNode > root = _Build( 0,
+                                                       mortonObjects.size(),
+                                                       c_mortonBitCount - 1,
+                                                       mortonObjects,
+                                                       extents,
+                                                       m_threadCount );
+
+        o_orderedObjects.reserve( mortonObjects.size() );
+        for ( const _MortonObject& mortonObject : mortonObjects )
+        {
+            o_orderedObjects.push_back( i_sceneObjects[ mortonObject.m_index ] );
+        }
+
+        return root;
+    }
+
+    /// Get the maximum number of objects which a leaf node may hold.
+    inline int LeafSize() const
+    {
+        return m_leafSize;
+    }
+
+private:
+    // Number of bits per axis, and in total, of a Morton code.
+    static constexpr int c_mortonAxisBitCount = 10;
+    static constexpr int c_mortonBitCount     = 3 * c_mortonAxisBitCount;
+
+    // Each interior node either consumes a bit of the Morton codes, or halves a range of identical codes, so
+    // the depth of the tree is bounded for any object count.
+    static_assert( c_mortonBitCount + 31 <= c_bvhMaxDepth, "The tree depth may exceed the traversal stacks." );
+
+    // Number of bits sorted per radix sort pass.
+    static constexpr int c_radixBitCount = 10;
+
+    // An object index paired with the Morton code of its centroid.
+    class _MortonObject
+    {
+    public:
+        uint32_t m_code  = 0;
+        int      m_index = 0;
+    };
+
+    // Spread the lower 10 bits of \p i_value apart, such that there are two zero bits between each of them.
+    static inline uint32_t _SpreadBits( uint32_t i_value )
+    {
+        i_value = ( i_value | ( i_value << 16 ) ) & 0x030000FF;
+        i_value = ( i_value | ( i_value << 8 ) ) & 0x0300F00F;
+        i_value = ( i_value | ( i_value << 4 ) ) & 0x030C30C3;
+        i_value = ( i_value | ( i_value << 2 ) ) & 0x09249249;
+        return i_value;
+    }
+
+    // Quantize \p i_centroid within \p i_centroidExtent, and interleave the bits of each axis.  The X axis
+    // occupies the most significant bit of each triplet.
+    static inline uint32_t _ComputeMortonCode( const gm::Vec3f& i_centroid, const gm::Vec3fRange& i_centroidExtent )
+    {
+        uint32_t code = 0;
+        for ( int axis = 0; axis < 3; ++axis )
+        {
+            float axisLength = i_centroidExtent.Max()[ axis ] - i_centroidExtent.Min()[ axis ];
+            float offset     = axisLength > 0.0f ? ( i_centroid[ axis ] - i_centroidExtent.Min()[ axis ] ) / axisLength
+                                                 : 0.0f;
+
+            const float maxCell = ( float ) ( ( 1 << c_mortonAxisBitCount ) - 1 );
+            uint32_t    cell    = ( uint32_t ) std::min( std::max( offset * maxCell, 0.0f ), maxCell );
+            code |= _SpreadBits( cell ) << ( 2 - axis );
+        }
+        return code;
+    }
+
+    // Get the axis which a bit of a Morton code partitions.
+    static inline int _ComputeBitAxis( int i_bit )
+    {
+        return 2 - ( i_bit % 3 );
+    }
+
+    // Sort \p io_mortonObjects by Morton code, with a least significant digit radix sort.
+    static inline void _RadixSort( std::vector< _MortonObject >& io_mortonObjects )
+    {
+        constexpr int                c_bucketCount = 1 << c_radixBitCount;
+        std::vector< _MortonObject > sortedObjects( io_mortonObjects.size() );
+        for ( int shift = 0; shift < c_mortonBitCount; shift += c_radixBitCount )
+        {
+            // Count the objects in each bucket, and convert the counts into bucket offsets.
+            std::vector< int > bucketOffsets( c_bucketCount + 1, 0 );
+            for ( const _MortonObject& mortonObject : io_mortonObjects )
+            {
+                bucketOffsets[ ( ( mortonObject.m_code >> shift ) & ( c_bucketCount - 1 ) ) + 1 ]++;
+            }
+            for ( int bucketIndex = 1; bucketIndex <= c_bucketCount; ++bucketIndex )
+            {
+                bucketOffsets[ bucketIndex ] += bucketOffsets[ bucketIndex - 1 ];
+            }
+
+            // Scatter, retaining the relative order of objects within the same bucket.
+            for ( const _MortonObject& mortonObject : io_mortonObjects )
+            {
+                sortedObjects[ bucketOffsets[ ( mortonObject.m_code >> shift ) & ( c_bucketCount - 1 ) ]++ ] =
+                    mortonObject;
+            }
+            io_mortonObjects.swap( sortedObjects );
+        }
+    }
+
+    // Recursively build the node for the sorted objects within [\p i_begin, \p i_end), whose Morton codes
+    // are identical above \p i_bit.
+    inline std::unique_ptr< BVHBuildNode > _Build( int                                  i_begin,
+                                                   int                                  i_end,
+                                                   int                                  i_bit,
+                                                   const std::vector< _MortonObject >&  i_mortonObjects,
+                                                   const std::vector< gm::Vec3fRange >& i_extents,
+                                                   int                                  i_threadBudget ) const
+    {
+        std::unique_ptr< BVHBuildNode > node( new BVHBuildNode() );
+
+        int objectCount = i_end - i_begin;
+        if ( objectCount <= m_leafSize )
+        {
+            node->m_objectOffset = i_begin;
+            node->m_objectCount  = objectCount;
+            for ( int objectIndex = i_begin; objectIndex < i_end; ++objectIndex )
+            {
+                node->m_extent = gm::Expand( node->m_extent, i_extents[ i_mortonObjects[ objectIndex ].m_index ] );
+            }
+            return node;
+        }
+
+        // Skip over the bits shared by every object in the range.  The codes are sorted, so it suffices to
+        // compare the first and last.
+        uint32_t firstCode = i_mortonObjects[ i_begin ].m_code;
+        uint32_t lastCode  = i_mortonObjects[ i_end - 1 ].m_code;
+        while ( i_bit >= 0 && ( ( firstCode ^ lastCode ) & ( 1u << i_bit ) ) == 0 )
+        {
+            --i_bit;
+        }
+
+        int midObjectIndex = i_begin + objectCount / 2;
+        if ( i_bit >= 0 )
+        {
+            // Split at the first object with the bit set.
+            uint32_t bitMask = 1u << i_bit;
+            midObjectIndex   = std::partition_point( i_mortonObjects.begin() + i_begin,
+                                                   i_mortonObjects.begin() + i_end,
+                                                   [&]( const _MortonObject& i_mortonObject ) {
+                                                       return ( i_mortonObject.m_code & bitMask ) == 0;
+                                                   } ) -
+                             i_mortonObjects.begin();
+            node->m_splitAxis = _ComputeBitAxis( i_bit );
+        }
+
+        // Objects with identical codes are split at the middle of the range, and keep the remaining bits.
+        int childBit = i_bit >= 0 ? i_bit - 1 : i_bit;
+        _ForkJoin(
+            i_threadBudget,
+            objectCount,
+            [&]( int i_childThreadBudget ) {
+                node->m_children[ 0 ] =
+                    _Build( i_begin, midObjectIndex, childBit, i_mortonObjects, i_extents, i_childThreadBudget );
+            },
+            [&]( int i_childThreadBudget ) {
+                node->m_children[ 1 ] =
+                    _Build( midObjectIndex, i_end, childBit, i_mortonObjects, i_extents, i_childThreadBudget );
+            } );
+
+        node->m_extent = gm::Expand( node->m_children[ 0 ]->m_extent, node->m_children[ 1 ]->m_extent );
+        return node;
+    }
+
+    int m_leafSize = 0;
+};
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,185 @@
+#pragma once
+
+/// \file raytrace/lightList.h
+///
+/// Collection of the emissive objects of a scene, for sampling light directly.
+
+#include <raytrace/hitRecord.h>
+#include <raytrace/material.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/functions/dotProduct.h>
+
+#include <gm/types/vec2f.h>
+#include <gm/types/vec3f.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class LightSample
+///
+/// A point sampled on the surface of a light, as seen from a shaded position.
+class LightSample
+{
+public:
+    /// The unit direction from the shaded position towards the point on the light.
+    gm::Vec3f m_direction;
+
+    /// The distance from the shaded position to the point on the light.
+    float m_distance = 0.0f;
+
+    /// The light emitted by the point, towards the shaded position.
+    gm::Vec3f m_emission;
+
+    /// The probability density of sampling the point, with respect to solid angle at the shaded position.
+    float m_pdf = 0.0f;
+};
+
+/// \class LightList
+///
+/// LightList holds the scene objects with an emissive material (see \ref Material::IsEmissive), whose surface can
+/// be sampled (see \ref SceneObject::SampleSurface).  Light arriving from them is estimated by sampling points on
+/// their surfaces, rather than waiting for scattered rays to hit them by chance.
+///
+/// A light is selected uniformly, then a point uniformly over its surface area.
+class LightList
+{
+public:
+    /// Construct an empty light list, such that no light is sampled.
+    LightList() = default;
+
+    /// Explicit constructor, collecting the lights among \p i_sceneObjects.
+    ///
+    /// \param i_sceneObjects The scene objects.
+    inline explicit LightList( const SceneObjectPtrs& i_sceneObjects )
+    {
+        for ( const SceneObjectPtr& sceneObject : i_sceneObjects )
+        {
+            const Material* material = sceneObject->SurfaceMaterial();
+            if ( material != nullptr && material->IsEmissive() )
+            {
+                m_lights.push_back( sceneObject );
+                m_sortedLights.push_back( sceneObject.get() );
+            }
+        }
+
+        std::sort( m_sortedLights.begin(), m_sortedLights.end() );
+    }
+
+    /// Check if there are no lights to sample.
+    inline bool IsEmpty() const
+    {
+        return m_lights.empty();
+    }
+
+    /// Get the number of lights.
+    inline size_t Size() const
+    {
+        return m_lights.size();
+    }
+
+    /// Sample a point on a light, as seen from \p i_position.
+    ///
+    /// \param i_lightSample Uniformly distributed sample in [0, 1), selecting the light.
+    /// \param i_surfaceSample Uniformly distributed sample in [0, 1)^2, selecting the point on the light.
+    /// \param i_position The shaded position.
+    /// \param i_time The time of the sampled ray.
+    /// \param o_sample The sampled point.
+    ///
+    /// \return Whether a point was sampled.  Fails if there are no lights, or the point is seen edge on.
+    inline bool Sample( float              i_lightSample,
+                        const gm::Vec2f&   i_surfaceSample,
+                        const gm::Vec3f&   i_position,
+                        float              i_time,
+                        LightSample&       o_sample ) const
+    {
+        if ( m_lights.empty() )
+        {
+            return false;
+        }
+
+        size_t lightIndex = std::min( ( size_t )( i_lightSample * m_lights.size() ), m_lights.size() - 1 );
+        const SceneObject& light = *m_lights[ lightIndex ];
+
+        HitRecord record;
+        if ( !light.SampleSurface( i_surfaceSample, i_time, record ) )
+        {
+            return false;
+        }
+
+        gm::Vec3f toLight         = record.m_position - i_position;
+        float     distanceSquared = gm::DotProduct( toLight, toLight );
+        if ( distanceSquared <= 0.0f )
+        {
+            return false;
+        }
+
+        o_sample.m_distance  = std::sqrt( distanceSquared );
+        o_sample.m_direction = toLight / o_sample.m_distance;
+        o_sample.m_pdf       = _SolidAnglePdf( light, record, o_sample.m_direction, distanceSquared, i_time );
+        if ( o_sample.m_pdf <= 0.0f )
+        {
+            return false;
+        }
+
+        o_sample.m_emission = record.m_material->Emit( record.m_uv, record.m_position );
+        return true;
+    }
+
+    /// Compute the probability density, with respect to solid angle at \p i_origin, of \ref Sample producing the
+    /// hit \p i_record.
+    ///
+    /// \param i_origin The position the light is seen from.
+    /// \param i_record The hit of a ray from \p i_origin, with its surface attributes computed.
+    /// \param i_time The time of the ray.
+    ///
+    /// \return The probability density, or zero if the object hit is not a light of this list.
+    inline float Pdf( const gm::Vec3f& i_origin, const HitRecord& i_record, float i_time ) const
+    {
+        if ( !std::binary_search( m_sortedLights.begin(), m_sortedLights.end(), i_record.m_object ) )
+        {
+            return 0.0f;
+        }
+
+        gm::Vec3f toLight         = i_record.m_position - i_origin;
+        float     distanceSquared = gm::DotProduct( toLight, toLight );
+        if ( distanceSquared <= 0.0f )
+        {
+            return 0.0f;
+        }
+
+        return _SolidAnglePdf(
+            *i_record.m_object, i_record, toLight / std::sqrt( distanceSquared ), distanceSquared, i_time );
+    }
+
+private:
+    // Convert the probability density of sampling the point of \p i_record, uniformly over the area of the light
+    // \p i_light, to solid angle, as seen along \p i_direction from \p i_distanceSquared away.
+    inline float _SolidAnglePdf( const SceneObject& i_light,
+                                 const HitRecord&   i_record,
+                                 const gm::Vec3f&   i_direction,
+                                 float              i_distanceSquared,
+                                 float              i_time ) const
+    {
+        float cosine = std::abs( gm::DotProduct( i_record.m_normal, i_direction ) );
+        float area   = i_light.Area( i_time );
+        if ( cosine <= 0.0f || area <= 0.0f )
+        {
+            return 0.0f;
+        }
+
+        return i_distanceSquared / ( cosine * area * ( float ) m_lights.size() );
+    }
+
+    // The lights, in selection order.
+    SceneObjectPtrs m_lights;
+
+    // The lights, sorted by address, to look up whether an object hit is a light.
+    std::vector< const SceneObject* > m_sortedLights;
+};
+
+RAYTRACE_NS_CLOSE
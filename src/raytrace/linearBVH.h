@@ -0,0 +1,306 @@
+#pragma once
+
+/// \file raytrace/linearBVH.h
+///
+/// Bounding volume hierarchy flattened into a contiguous array of nodes.
+
+#include <raytrace/bvhBuildNode.h>
+#include <raytrace/bvhTraversal.h>
+#include <raytrace/hitRecord.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/base/diagnostic.h>
+
+#include <gm/types/floatRange.h>
+#include <gm/types/vec3f.h>
+#include <gm/types/vec3fRange.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class LinearBVHNode
+///
+/// LinearBVHNode is a single, 32 byte, node of a \ref LinearBVH.
+///
+/// Interior nodes are immediately followed by their left child in the node array, and record the index
+/// of their right child.  Leaf nodes record a range of the ordered object array.
+class LinearBVHNode
+{
+public:
+    /// Check if this node is a leaf.
+    inline bool IsLeaf() const
+    {
+        return m_objectCount > 0;
+    }
+
+    /// Minimum & maximum of the extent encompassing all the objects under this node.
+    gm::Vec3f m_min;
+    gm::Vec3f m_max;
+
+    /// For leaf nodes, the offset of the first object.  For interior nodes, the index of the right child.
+    int32_t m_offset = 0;
+
+    /// The number of objects in this leaf, up to \ref c_bvhMaxLeafSize.  Zero for interior nodes.
+    uint16_t m_objectCount = 0;
+
+    /// The axis which the objects were partitioned along.  Only set for interior nodes.
+    uint8_t m_splitAxis = 0;
+
+    /// Unused, pads the node out to 32 bytes.
+    uint8_t m_padding = 0;
+};
+
+static_assert( sizeof( LinearBVHNode ) == 32, "LinearBVHNode is expected to be 32 bytes." );
+
+/// Recursively append \p i_buildNode and its descendents to \p io_nodes, in depth-first order.
+///
+/// Leaf nodes keep the object offsets of the build tree.
+///
+/// \param i_buildNode The build node to flatten.
+/// \param io_nodes The node array to append to.
+///
+/// \return The index of the appended node.
+inline int FlattenBVH( const BVHBuildNode& i_buildNode, std::vector< LinearBVHNode >& io_nodes )
+{
+    int nodeIndex = io_nodes.size();
+    io_nodes.push_back( LinearBVHNode() );
+    io_nodes[ nodeIndex ].m_min = i_buildNode.m_extent.Min();
+    io_nodes[ nodeIndex ].m_max = i_buildNode.m_extent.Max();
+
+    if ( i_buildNode.IsLeaf() )
+    {
+        GM_ASSERT( i_buildNode.m_objectCount <= c_bvhMaxLeafSize );
+        io_nodes[ nodeIndex ].m_offset      = i_buildNode.m_objectOffset;
+        io_nodes[ nodeIndex ].m_objectCount = i_buildNode.m_objectCount;
+    }
+    else
+    {
+        FlattenBVH( *i_buildNode.m_children[ 0 ], io_nodes );
+        int rightIndex                    = FlattenBVH( *i_buildNode.m_children[ 1 ], io_nodes );
+        io_nodes[ nodeIndex ].m_offset    = rightIndex;
+        io_nodes[ nodeIndex ].m_splitAxis = i_buildNode.m_splitAxis;
+    }
+
+    return nodeIndex;
+}
+
+/// Slab test of a ray against the extent of \p i_node, within the accepted range of magnitudes.
+///
+/// \param i_node The node to test.
+/// \param i_origin The origin of the ray.
+/// \param i_inverseDirection The reciprocal of each component of the direction of the ray.
+/// \param i_magnitudeRange The accepted range of magnitudes.
+///
+/// \return Whether the extent of the node overlaps the ray within the accepted range.
+inline bool IntersectLinearBVHNode( const LinearBVHNode&  i_node,
+                                    const gm::Vec3f&      i_origin,
+                                    const gm::Vec3f&      i_inverseDirection,
+                                    const gm::FloatRange& i_magnitudeRange )
+{
+    float magnitudeMin = i_magnitudeRange.Min();
+    float magnitudeMax = i_magnitudeRange.Max();
+    for ( int axis = 0; axis < 3; ++axis )
+    {
+        float near = ( i_node.m_min[ axis ] - i_origin[ axis ] ) * i_inverseDirection[ axis ];
+        float far  = ( i_node.m_max[ axis ] - i_origin[ axis ] ) * i_inverseDirection[ axis ];
+        if ( i_inverseDirection[ axis ] < 0.0f )
+        {
+            std::swap( near, far );
+        }
+        far *= c_bvhFarDistanceScale;
+
+        magnitudeMin = near > magnitudeMin ? near : magnitudeMin;
+        magnitudeMax = far < magnitudeMax ? far : magnitudeMax;
+        if ( magnitudeMax < magnitudeMin )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Traverse the nodes of a flattened hierarchy intersected by \p i_ray within \p i_magnitudeRange, near to far.
+///
+/// At each interior node, the child nearest to the ray origin (along the split axis) is visited first, such
+/// that farther nodes are more likely to be culled by a nearer hit.
+///
+/// \param i_nodes The nodes, in depth-first order, as produced by \ref FlattenBVH.
+/// \param i_ray The ray.
+/// \param i_magnitudeRange The accepted range of magnitudes.
+/// \param i_visitLeaf Called with each leaf reached, and the accepted magnitude range, which it may narrow.  Has
+/// the signature bool( const LinearBVHNode& i_leaf, gm::FloatRange& io_magnitudeRange ).  Traversal stops as soon
+/// as it returns true.
+///
+/// \return Whether traversal was stopped.
+template < typename VisitLeafFunctionT >
+inline bool TraverseLinearBVH( const std::vector< LinearBVHNode >& i_nodes,
+                               const raytrace::Ray&                i_ray,
+                               const gm::FloatRange&               i_magnitudeRange,
+                               VisitLeafFunctionT                  i_visitLeaf )
+{
+    if ( i_nodes.empty() )
+    {
+        return false;
+    }
+
+    // Pre-compute the inverse direction, and the direction sign for each axis.
+    gm::Vec3f inverseDirection( 1.0f / i_ray.Direction()[ 0 ],
+                                1.0f / i_ray.Direction()[ 1 ],
+                                1.0f / i_ray.Direction()[ 2 ] );
+    bool directionIsNegative[ 3 ] = {inverseDirection[ 0 ] < 0.0f,
+                                     inverseDirection[ 1 ] < 0.0f,
+                                     inverseDirection[ 2 ] < 0.0f};
+
+    gm::FloatRange magnitudeRange( i_magnitudeRange );
+
+    // At most one child is deferred per interior node along the path to the current node.
+    int nodeStack[ c_bvhMaxDepth ];
+    int stackSize = 0;
+    int nodeIndex = 0;
+    while ( true )
+    {
+        const LinearBVHNode& node = i_nodes[ nodeIndex ];
+        if ( IntersectLinearBVHNode( node, i_ray.Origin(), inverseDirection, magnitudeRange ) )
+        {
+            if ( node.IsLeaf() )
+            {
+                if ( i_visitLeaf( node, magnitudeRange ) )
+                {
+                    return true;
+                }
+            }
+            else
+            {
+                // Visit the near child first, and defer the far child.
+                GM_ASSERT( stackSize < c_bvhMaxDepth );
+                if ( directionIsNegative[ node.m_splitAxis ] )
+                {
+                    nodeStack[ stackSize++ ] = nodeIndex + 1;
+                    nodeIndex                = node.m_offset;
+                }
+                else
+                {
+                    nodeStack[ stackSize++ ] = node.m_offset;
+                    nodeIndex                = nodeIndex + 1;
+                }
+                continue;
+            }
+        }
+
+        if ( stackSize == 0 )
+        {
+            break;
+        }
+        nodeIndex = nodeStack[ --stackSize ];
+    }
+
+    return false;
+}
+
+/// \class LinearBVH
+///
+/// LinearBVH is a bounding volume hierarchy stored as a contiguous array of \ref LinearBVHNode, in depth-first
+/// order.
+///
+/// The hierarchy is traversed iteratively with a fixed-size stack (see \ref TraverseLinearBVH), instead of
+/// through a virtual \ref Hit call per node.
+class LinearBVH : public SceneObject
+{
+public:
+    /// Flatten a build tree into a linear BVH.
+    ///
+    /// \param i_root The root node of the build tree.
+    /// \param i_orderedObjects The ordered scene objects, which leaves of the build tree reference.
+    inline explicit LinearBVH( const BVHBuildNode& i_root, const SceneObjectPtrs& i_orderedObjects )
+        : m_objectPtrs( i_orderedObjects )
+    {
+        m_objects.reserve( m_objectPtrs.size() );
+        for ( const SceneObjectPtr& objectPtr : m_objectPtrs )
+        {
+            m_objects.push_back( objectPtr.get() );
+        }
+
+        FlattenBVH( i_root, m_nodes );
+    }
+
+    virtual inline bool
+    Hit( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const override
+    {
+        bool objectHit = false;
+        _Traverse( i_ray, i_magnitudeRange, [&]( const SceneObject& i_object, gm::FloatRange& io_magnitudeRange ) {
+            if ( i_object.Hit( i_ray, io_magnitudeRange, o_record ) )
+            {
+                // Narrow the accepted range, such that only nearer hits are recorded from here on.
+                objectHit               = true;
+                io_magnitudeRange.Max() = o_record.m_magnitude;
+            }
+            return false;
+        } );
+        return objectHit;
+    }
+
+    virtual inline bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const override
+    {
+        // Any hit will do, so the traversal stops at the first.
+        return _Traverse( i_ray,
+                          i_magnitudeRange,
+                          [&]( const SceneObject& i_object, gm::FloatRange& io_magnitudeRange ) {
+                              return i_object.Occluded( i_ray, io_magnitudeRange );
+                          } );
+    }
+
+    virtual inline gm::Vec3fRange Extent( const std::vector< float >& i_times ) const override
+    {
+        if ( m_nodes.empty() )
+        {
+            return gm::Vec3fRange();
+        }
+
+        return gm::Vec3fRange( m_nodes[ 0 ].m_min, m_nodes[ 0 ].m_max );
+    }
+
+    /// Get the flattened nodes.
+    inline const std::vector< LinearBVHNode >& Nodes() const
+    {
+        return m_nodes;
+    }
+
+private:
+    // Traverse the nodes intersected by \p i_ray within \p i_magnitudeRange, near to far, calling
+    // \p i_intersectObject with each object of the leaves reached, and the accepted magnitude range, which it may
+    // narrow.  Traversal stops as soon as \p i_intersectObject returns true.
+    //
+    // Returns whether traversal was stopped.
+    template < typename IntersectObjectFunctionT >
+    inline bool _Traverse( const raytrace::Ray&     i_ray,
+                           const gm::FloatRange&    i_magnitudeRange,
+                           IntersectObjectFunctionT i_intersectObject ) const
+    {
+        return TraverseLinearBVH(
+            m_nodes, i_ray, i_magnitudeRange, [&]( const LinearBVHNode& i_leaf, gm::FloatRange& io_magnitudeRange ) {
+                for ( int objectIndex = i_leaf.m_offset; objectIndex < i_leaf.m_offset + i_leaf.m_objectCount;
+                      ++objectIndex )
+                {
+                    if ( i_intersectObject( *m_objects[ objectIndex ], io_magnitudeRange ) )
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            } );
+    }
+
+    // Flattened nodes, in depth-first order.
+    std::vector< LinearBVHNode > m_nodes;
+
+    // Ordered objects referenced by the leaf nodes.  Raw pointers are used during traversal, to avoid
+    // reference counting, while the shared pointers retain ownership.
+    std::vector< const SceneObject* > m_objects;
+    SceneObjectPtrs                   m_objectPtrs;
+};
+
+RAYTRACE_NS_CLOSE
@@ -6,6 +6,12 @@
 
 #include <raytrace/ray.h>
 #include <raytrace/raytrace.h>
+#include <raytrace/sampler.h>
+
+#include <gm/types/vec2f.h>
+#include <gm/types/vec3f.h>
+
+#include <memory>
 
 RAYTRACE_NS_OPEN
 
@@ -30,15 +36,41 @@ public:
     ///
     /// \param i_ray Incident ray.
     /// \param i_hitRecord The recorded hit information of the ray against the geometry.
+    /// \param io_sampler The sampler of the sample being traced, positioned at the dimensions of this bounce.
     /// \param o_attenuation Color produced based on the ray, by the material.
     /// \param o_scatteredRay The optional, scattered ray.
     ///
     /// \retval true If this material produces a scattered ray. \p o_scatteredRay will be populated.
     /// \retval false If this material absorbs the scattered ray.  \p o_scatteredRay will be undefined.
-    virtual bool Scatter( const raytrace::Ray& i_ray,
-                          const HitRecord&     i_hitRecord,
-                          gm::Vec3f&           o_attenuation,
-                          raytrace::Ray&       o_scatteredRay ) const = 0;
+    virtual bool Scatter( const raytrace::Ray&   i_ray,
+                          const HitRecord&       i_hitRecord,
+                          Sampler&               io_sampler,
+                          gm::Vec3f&             o_attenuation,
+                          raytrace::Ray&         o_scatteredRay ) const = 0;
+
+    /// Evaluate the fraction of light arriving along \p i_direction which this material scatters back along the
+    /// incident ray \p i_ray, multiplied by the cosine of the angle to the surface, along with the probability
+    /// density of \ref Scatter producing \p i_direction.
+    ///
+    /// This allows light arriving from known directions, such as lights, to be sampled directly.
+    ///
+    /// \param i_ray Incident ray.
+    /// \param i_hitRecord The recorded hit information of the ray against the geometry.
+    /// \param i_direction Unit direction which light arrives along.
+    /// \param o_value The scattered fraction of the light, multiplied by the cosine term.
+    /// \param o_pdf The probability density of \ref Scatter producing \p i_direction, with respect to solid angle.
+    ///
+    /// \retval true If the material can be evaluated for arbitrary directions.
+    /// \retval false If the material scatters along directions which cannot be evaluated, such as mirrors.  Light
+    /// then only reaches it through scattered rays.
+    virtual bool EvaluateScatter( const raytrace::Ray& i_ray,
+                                  const HitRecord&     i_hitRecord,
+                                  const gm::Vec3f&     i_direction,
+                                  gm::Vec3f&           o_value,
+                                  float&               o_pdf ) const
+    {
+        return false;
+    }
 
     /// Emit colored light based on 2D surface coordinates and position of the ray hit.
     ///
@@ -51,6 +83,34 @@ public:
         // By default, the material does not emit any light!
         return gm::Vec3f( 0, 0, 0 );
     }
+
+    /// Check if the material emits light, such that objects it is assigned to are sampled as lights.
+    ///
+    /// \return Whether the material is emissive.
+    virtual bool IsEmissive() const
+    {
+        return false;
+    }
+
+    /// Get the reflectance color of the material, at the hit \p i_hitRecord, reported by the albedo AOV.
+    ///
+    /// \param i_hitRecord The recorded hit information of the ray against the geometry.
+    ///
+    /// \return The albedo.
+    virtual gm::Vec3f Albedo( const HitRecord& i_hitRecord ) const
+    {
+        // By default, the material reflects all light, such that dividing by its albedo leaves radiance unchanged.
+        return gm::Vec3f( 1, 1, 1 );
+    }
+
+    /// Check if the material scatters rays along a single direction, like a perfect mirror or glass.  AOVs are
+    /// gathered past specular surfaces, at the first surface which is not.
+    ///
+    /// \return Whether the material is specular.
+    virtual bool IsSpecular() const
+    {
+        return false;
+    }
 };
 
 /// \typedef MaterialSharedPtr
@@ -0,0 +1,67 @@
+#pragma once
+
+/// \file raytrace/meshFile.h
+///
+/// Utilities shared by the readers of mesh files.
+
+#include <raytrace/raytrace.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// Read the whole file at file location \p i_filePath into memory, such that it can be parsed in parallel.
+///
+/// \param i_filePath file location of the mesh file.
+/// \param o_contents the contents of the file.
+///
+/// \return success of reading the file.
+inline bool ReadMeshFile( const std::string& i_filePath, std::string& o_contents )
+{
+    std::ifstream fileInput( i_filePath.c_str(), std::ios::in | std::ios::binary | std::ios::ate );
+    if ( !fileInput.is_open() )
+    {
+        fprintf( stderr, "Cannot open file '%s' for reading!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    o_contents.assign( ( size_t ) fileInput.tellg(), '\0' );
+    fileInput.seekg( 0, std::ios::beg );
+    fileInput.read( &o_contents[ 0 ], o_contents.size() );
+    if ( !fileInput )
+    {
+        fprintf( stderr, "Failed to read mesh '%s'!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+/// Split the text within [\p i_begin, \p i_end) into chunks of whole lines, of roughly \p i_chunkSize bytes.
+///
+/// \param i_begin The start of the text.
+/// \param i_end The end of the text.
+/// \param i_chunkSize The approximate number of bytes per chunk.
+/// \param o_chunkBounds The bounds of the chunks: chunk \em i spans [o_chunkBounds[i], o_chunkBounds[i + 1]).
+inline void
+SplitLineChunks( const char* i_begin, const char* i_end, size_t i_chunkSize, std::vector< const char* >& o_chunkBounds )
+{
+    // The boundaries are moved forward to the start of the next line.
+    int chunkCount = std::max( 1, ( int ) ( ( i_end - i_begin ) / i_chunkSize ) );
+    o_chunkBounds.resize( chunkCount + 1 );
+    o_chunkBounds[ 0 ]          = i_begin;
+    o_chunkBounds[ chunkCount ] = i_end;
+    for ( int chunkIndex = 1; chunkIndex < chunkCount; ++chunkIndex )
+    {
+        const char* bound = i_begin + ( i_end - i_begin ) * chunkIndex / chunkCount;
+        bound             = std::find( std::max( bound, o_chunkBounds[ chunkIndex - 1 ] ), i_end, '\n' );
+
+        o_chunkBounds[ chunkIndex ] = bound == i_end ? i_end : bound + 1;
+    }
+}
+
+RAYTRACE_NS_CLOSE
@@ -7,6 +7,8 @@
 #include <gm/types/vec3f.h>
 
 #include <gm/functions/clamp.h>
+#include <gm/functions/dotProduct.h>
+#include <gm/functions/normalize.h>
 
 #include <raytrace/hitRecord.h>
 #include <raytrace/material.h>
@@ -32,13 +34,14 @@ public:
     {
     }
 
-    inline virtual bool Scatter( const raytrace::Ray& i_ray,
-                                 const HitRecord&     i_hitRecord,
-                                 gm::Vec3f&           o_attenuation,
-                                 raytrace::Ray&       o_scatteredRay ) const override
+    inline virtual bool Scatter( const raytrace::Ray&   i_ray,
+                                 const HitRecord&       i_hitRecord,
+                                 Sampler&               io_sampler,
+                                 gm::Vec3f&             o_attenuation,
+                                 raytrace::Ray&         o_scatteredRay ) const override
     {
         gm::Vec3f reflectedDirection = Reflect( i_ray.Direction(), i_hitRecord.m_normal );
-        reflectedDirection += m_fuzziness * RandomUnitVector();
+        reflectedDirection += m_fuzziness * RandomUnitVector( io_sampler.Get2D() );
 
         // Produce reflected ray.
         o_scatteredRay = raytrace::Ray( /* origin */ i_hitRecord.m_position,
@@ -52,6 +55,17 @@ public:
         return ( gm::DotProduct( o_scatteredRay.Direction(), i_hitRecord.m_normal ) > 0 );
     }
 
+    inline virtual gm::Vec3f Albedo( const HitRecord& i_hitRecord ) const override
+    {
+        return m_albedo->Sample( i_hitRecord.m_uv, i_hitRecord.m_position );
+    }
+
+    /// Metal without any fuzziness is a perfect mirror.
+    inline virtual bool IsSpecular() const override
+    {
+        return m_fuzziness == 0.0f;
+    }
+
 private:
     TextureSharedPtr m_albedo;
     float            m_fuzziness;
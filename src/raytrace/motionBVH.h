@@ -0,0 +1,477 @@
+#pragma once
+
+/// \file raytrace/motionBVH.h
+///
+/// Bounding volume hierarchy for moving objects, with node extents sampled at shutter keyframes.
+
+#include <raytrace/bvhBuildNode.h>
+#include <raytrace/bvhTraversal.h>
+#include <raytrace/hitRecord.h>
+#include <raytrace/bvhBuilder.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/base/diagnostic.h>
+
+#include <gm/types/floatRange.h>
+#include <gm/types/vec3f.h>
+#include <gm/types/vec3fRange.h>
+
+#include <gm/functions/expand.h>
+#include <gm/functions/linearInterpolation.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class MotionBVHNode
+///
+/// MotionBVHNode is a single node of a \ref MotionBVH.
+///
+/// Spatial nodes reference a set of extents, one per keyframe of their time range.  Interior spatial nodes
+/// are immediately followed by their left child, and record the index of their right child.
+///
+/// Time split nodes partition their time range in half, instead of partitioning space.  The left child
+/// covers the earlier half, and the right child covers the later half.
+class MotionBVHNode
+{
+public:
+    /// Check if this node is a leaf.
+    inline bool IsLeaf() const
+    {
+        return m_objectCount > 0;
+    }
+
+    /// The time range which this node covers.
+    float m_timeMin = 0.0f;
+    float m_timeMax = 0.0f;
+
+    /// Offset of the first keyframe extent, into the extent array.  Unused by time split nodes.
+    int32_t m_extentOffset = 0;
+
+    /// For leaf nodes, the offset of the first object.  For interior nodes, the index of the right child.
+    int32_t m_offset = 0;
+
+    /// The number of objects in this leaf, up to \ref c_bvhMaxLeafSize.  Zero for interior nodes.
+    uint16_t m_objectCount = 0;
+
+    /// The axis which the objects were partitioned along.  Only set for interior spatial nodes.
+    uint8_t m_splitAxis = 0;
+
+    /// Whether this node partitions time, rather than space.
+    uint8_t m_isTimeSplit = 0;
+};
+
+/// \class MotionBVH
+///
+/// MotionBVH is a bounding volume hierarchy which accounts for the motion of its objects over the shutter
+/// interval.
+///
+/// Rather than a single extent swept over the entire shutter interval, each node stores its extent at a
+/// number of evenly spaced keyframes.  During traversal, the extent of a node at the time of the ray is
+/// linearly interpolated from the two nearest keyframes.  A fast moving object therefore only inflates the
+/// nodes which contain it by its motion between keyframes, rather than its motion over the whole interval.
+///
+/// Interpolation is exact for objects which stay outermost in their node across a pair of keyframes.  Where
+/// objects within the same node overtake each other, the interpolated extents loosely bound the objects in
+/// between.  If this inflates the nodes of a time range too much, the time range is split in half, and a
+/// separate hierarchy is built for each half.
+///
+/// \pre Object motion between two adjacent keyframes is assumed to be linear, such that the interpolated
+/// extent of each object conservatively bounds the object.
+class MotionBVH : public SceneObject
+{
+public:
+    /// Build a motion BVH over a collection of scene objects.
+    ///
+    /// \param i_sceneObjects Scene objects to build the BVH for.
+    /// \param i_shutterRange The time range where the shutter opens and closes.
+    /// \param i_keyframeCount The number of keyframes, per time range, to sample node extents at.
+    /// \param i_builder The builder used to partition the objects of each time range.
+    inline explicit MotionBVH( const SceneObjectPtrs& i_sceneObjects,
+                               const gm::FloatRange&  i_shutterRange,
+                               int                    i_keyframeCount,
+                               const BVHBuilder&      i_builder )
+        : m_keyframeCount( std::max( i_keyframeCount, 2 ) )
+    {
+        std::vector< float > times = {i_shutterRange.Min(), i_shutterRange.Max()};
+        for ( const SceneObjectPtr& sceneObject : i_sceneObjects )
+        {
+            m_extent = gm::Expand( m_extent, sceneObject->Extent( times ) );
+        }
+
+        if ( !i_sceneObjects.empty() )
+        {
+            _BuildTimeRange( i_sceneObjects, i_shutterRange, i_builder, /* timeSplitDepth */ 0 );
+        }
+    }
+
+    virtual inline bool
+    Hit( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const override
+    {
+        bool objectHit = false;
+        _Traverse( i_ray, i_magnitudeRange, [&]( const SceneObject& i_object, gm::FloatRange& io_magnitudeRange ) {
+            if ( i_object.Hit( i_ray, io_magnitudeRange, o_record ) )
+            {
+                // Narrow the accepted range, such that only nearer hits are recorded from here on.
+                objectHit               = true;
+                io_magnitudeRange.Max() = o_record.m_magnitude;
+            }
+            return false;
+        } );
+        return objectHit;
+    }
+
+    virtual inline bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const override
+    {
+        // Any hit will do, so the traversal stops at the first.
+        return _Traverse( i_ray,
+                          i_magnitudeRange,
+                          [&]( const SceneObject& i_object, gm::FloatRange& io_magnitudeRange ) {
+                              return i_object.Occluded( i_ray, io_magnitudeRange );
+                          } );
+    }
+
+    virtual inline gm::Vec3fRange Extent( const std::vector< float >& i_times ) const override
+    {
+        return m_extent;
+    }
+
+    /// Get the number of time ranges which the shutter interval was split into.
+    inline int TimeRangeCount() const
+    {
+        return m_timeRangeCount;
+    }
+
+private:
+    // Traverse the nodes intersected by \p i_ray within \p i_magnitudeRange, near to far, calling
+    // \p i_intersectObject with each object of the leaves reached, and the accepted magnitude range, which it may
+    // narrow.  Traversal stops as soon as \p i_intersectObject returns true.
+    //
+    // Returns whether traversal was stopped.
+    template < typename IntersectObjectFunctionT >
+    inline bool _Traverse( const raytrace::Ray&     i_ray,
+                           const gm::FloatRange&    i_magnitudeRange,
+                           IntersectObjectFunctionT i_intersectObject ) const
+    {
+        if ( m_nodes.empty() )
+        {
+            return false;
+        }
+
+        // Pre-compute the inverse direction, and the direction sign for each axis.
+        gm::Vec3f inverseDirection( 1.0f / i_ray.Direction()[ 0 ],
+                                    1.0f / i_ray.Direction()[ 1 ],
+                                    1.0f / i_ray.Direction()[ 2 ] );
+        bool directionIsNegative[ 3 ] = {inverseDirection[ 0 ] < 0.0f,
+                                         inverseDirection[ 1 ] < 0.0f,
+                                         inverseDirection[ 2 ] < 0.0f};
+
+        gm::FloatRange magnitudeRange( i_magnitudeRange );
+
+        // Time split nodes are only found above the spatial hierarchies, so descend into the time range
+        // containing the ray once, up front.
+        int nodeIndex = 0;
+        while ( m_nodes[ nodeIndex ].m_isTimeSplit )
+        {
+            const MotionBVHNode& node      = m_nodes[ nodeIndex ];
+            float                splitTime = ( node.m_timeMin + node.m_timeMax ) * 0.5f;
+            nodeIndex                      = i_ray.Time() < splitTime ? nodeIndex + 1 : node.m_offset;
+        }
+
+        // Every spatial node of the time range shares the same keyframes, so locate the pair of keyframes
+        // surrounding the ray time once as well.
+        const MotionBVHNode& timeRangeRoot = m_nodes[ nodeIndex ];
+        float                timeLength    = timeRangeRoot.m_timeMax - timeRangeRoot.m_timeMin;
+        float                keyframe      = 0.0f;
+        if ( timeLength > 0.0f )
+        {
+            keyframe = ( i_ray.Time() - timeRangeRoot.m_timeMin ) / timeLength * ( m_keyframeCount - 1 );
+            keyframe = std::min( std::max( keyframe, 0.0f ), ( float ) ( m_keyframeCount - 1 ) );
+        }
+        int   keyframeIndex = std::min( ( int ) keyframe, m_keyframeCount - 2 );
+        float weight        = keyframe - keyframeIndex;
+
+        // At most one child is deferred per interior node along the path to the current node.
+        int nodeStack[ c_bvhMaxDepth ];
+        int stackSize = 0;
+        while ( true )
+        {
+            const MotionBVHNode& node = m_nodes[ nodeIndex ];
+            if ( _IntersectNode( node, keyframeIndex, weight, i_ray.Origin(), inverseDirection, magnitudeRange ) )
+            {
+                if ( node.IsLeaf() )
+                {
+                    for ( int objectIndex = node.m_offset; objectIndex < node.m_offset + node.m_objectCount;
+                          ++objectIndex )
+                    {
+                        if ( i_intersectObject( *m_objects[ objectIndex ], magnitudeRange ) )
+                        {
+                            return true;
+                        }
+                    }
+                }
+                else
+                {
+                    // Visit the near child first, and defer the far child.
+                    GM_ASSERT( stackSize < c_bvhMaxDepth );
+                    if ( directionIsNegative[ node.m_splitAxis ] )
+                    {
+                        nodeStack[ stackSize++ ] = nodeIndex + 1;
+                        nodeIndex                = node.m_offset;
+                    }
+                    else
+                    {
+                        nodeStack[ stackSize++ ] = node.m_offset;
+                        nodeIndex                = nodeIndex + 1;
+                    }
+                    continue;
+                }
+            }
+
+            if ( stackSize == 0 )
+            {
+                break;
+            }
+            nodeIndex = nodeStack[ --stackSize ];
+        }
+
+        return false;
+    }
+
+    // Maximum number of times the shutter interval can be recursively split in half.
+    static constexpr int c_maxTimeSplitDepth = 4;
+
+    // A time range is split if the interpolated extents of its nodes have a total surface area this many
+    // times larger than the exact extents of the nodes.
+    static constexpr float c_timeSplitThreshold = 1.5f;
+
+    // Compute evenly spaced keyframe times across \p i_timeRange.
+    inline std::vector< float > _ComputeKeyframeTimes( const gm::FloatRange& i_timeRange ) const
+    {
+        std::vector< float > keyframeTimes( m_keyframeCount );
+        for ( int keyframeIndex = 0; keyframeIndex < m_keyframeCount; ++keyframeIndex )
+        {
+            float weight                   = ( float ) keyframeIndex / ( m_keyframeCount - 1 );
+            keyframeTimes[ keyframeIndex ] = gm::LinearInterpolation( i_timeRange.Min(), i_timeRange.Max(), weight );
+        }
+        return keyframeTimes;
+    }
+
+    // Append the nodes covering \p i_timeRange, either as a time split node or a spatial hierarchy.
+    //
+    // Returns the index of the appended node.
+    inline int _BuildTimeRange( const SceneObjectPtrs& i_sceneObjects,
+                                const gm::FloatRange&  i_timeRange,
+                                const BVHBuilder&      i_builder,
+                                int                    i_timeSplitDepth )
+    {
+        std::vector< float > keyframeTimes = _ComputeKeyframeTimes( i_timeRange );
+
+        // Partition the objects, based on their extents swept over this time range.
+        SceneObjectPtrs                 orderedObjects;
+        std::unique_ptr< BVHBuildNode > root = i_builder.Build( i_sceneObjects, keyframeTimes, orderedObjects );
+
+        // Append the ordered objects and nodes of this time range.
+        size_t nodeCount   = m_nodes.size();
+        size_t extentCount = m_extents.size();
+        size_t objectCount = m_objects.size();
+        for ( const SceneObjectPtr& sceneObject : orderedObjects )
+        {
+            m_objects.push_back( sceneObject.get() );
+            m_objectPtrs.push_back( sceneObject );
+        }
+
+        int nodeIndex = _Flatten( *root, i_timeRange, keyframeTimes, ( int ) objectCount );
+        if ( i_timeSplitDepth >= ( int ) c_maxTimeSplitDepth ||
+             _ComputeInterpolationInflation( nodeIndex, keyframeTimes ) <= ( float ) c_timeSplitThreshold )
+        {
+            m_timeRangeCount++;
+            return nodeIndex;
+        }
+
+        // The interpolated extents are too loose, so discard this hierarchy, and split the time range in half.
+        m_nodes.resize( nodeCount );
+        m_extents.resize( extentCount );
+        m_objects.resize( objectCount );
+        m_objectPtrs.resize( objectCount );
+
+        m_nodes.push_back( MotionBVHNode() );
+        m_nodes[ nodeIndex ].m_timeMin     = i_timeRange.Min();
+        m_nodes[ nodeIndex ].m_timeMax     = i_timeRange.Max();
+        m_nodes[ nodeIndex ].m_isTimeSplit = 1;
+
+        float splitTime = ( i_timeRange.Min() + i_timeRange.Max() ) * 0.5f;
+        _BuildTimeRange( i_sceneObjects,
+                         gm::FloatRange( i_timeRange.Min(), splitTime ),
+                         i_builder,
+                         i_timeSplitDepth + 1 );
+        int rightIndex = _BuildTimeRange( i_sceneObjects,
+                                          gm::FloatRange( splitTime, i_timeRange.Max() ),
+                                          i_builder,
+                                          i_timeSplitDepth + 1 );
+        m_nodes[ nodeIndex ].m_offset = rightIndex;
+        return nodeIndex;
+    }
+
+    // Measure how loosely the interpolated node extents of the hierarchy rooted at \p i_rootIndex bound
+    // their objects, midway between each pair of keyframes.
+    //
+    // Objects which are the outermost of a node at one keyframe, but not the next, cause the interpolated
+    // extent to bulge beyond the objects in between.
+    //
+    // Returns the ratio of the total surface area of the interpolated extents, to the total surface area of
+    // the exact extents.
+    inline float _ComputeInterpolationInflation( int i_rootIndex, const std::vector< float >& i_keyframeTimes ) const
+    {
+        float interpolatedArea = 0.0f;
+        float exactArea        = 0.0f;
+        for ( int keyframeIndex = 0; keyframeIndex + 1 < m_keyframeCount; ++keyframeIndex )
+        {
+            std::vector< float > midTime = {
+                ( i_keyframeTimes[ keyframeIndex ] + i_keyframeTimes[ keyframeIndex + 1 ] ) * 0.5f};
+
+            // Children follow their parent, so visit the nodes in reverse to compute exact extents bottom-up.
+            std::vector< gm::Vec3fRange > exactExtents( m_nodes.size() - i_rootIndex );
+            for ( int nodeIndex = m_nodes.size() - 1; nodeIndex >= i_rootIndex; --nodeIndex )
+            {
+                const MotionBVHNode& node        = m_nodes[ nodeIndex ];
+                gm::Vec3fRange&      exactExtent = exactExtents[ nodeIndex - i_rootIndex ];
+                if ( node.IsLeaf() )
+                {
+                    for ( int objectIndex = node.m_offset; objectIndex < node.m_offset + node.m_objectCount;
+                          ++objectIndex )
+                    {
+                        exactExtent = gm::Expand( exactExtent, m_objects[ objectIndex ]->Extent( midTime ) );
+                    }
+                }
+                else
+                {
+                    exactExtent = gm::Expand( exactExtents[ nodeIndex + 1 - i_rootIndex ],
+                                              exactExtents[ node.m_offset - i_rootIndex ] );
+                }
+
+                const gm::Vec3fRange* keyframeExtents = &m_extents[ node.m_extentOffset + keyframeIndex ];
+                interpolatedArea +=
+                    SurfaceArea( gm::LinearInterpolation( keyframeExtents[ 0 ], keyframeExtents[ 1 ], 0.5f ) );
+                exactArea += SurfaceArea( exactExtent );
+            }
+        }
+
+        return exactArea > 0.0f ? interpolatedArea / exactArea : 1.0f;
+    }
+
+    // Recursively append \p i_buildNode and its descendents, with extents sampled at \p i_keyframeTimes.
+    //
+    // Returns the index of the appended node.
+    inline int _Flatten( const BVHBuildNode&         i_buildNode,
+                         const gm::FloatRange&       i_timeRange,
+                         const std::vector< float >& i_keyframeTimes,
+                         int                         i_objectOffset )
+    {
+        int nodeIndex = m_nodes.size();
+        m_nodes.push_back( MotionBVHNode() );
+        m_nodes[ nodeIndex ].m_timeMin      = i_timeRange.Min();
+        m_nodes[ nodeIndex ].m_timeMax      = i_timeRange.Max();
+        m_nodes[ nodeIndex ].m_extentOffset = m_extents.size();
+        m_extents.resize( m_extents.size() + m_keyframeCount );
+
+        if ( i_buildNode.IsLeaf() )
+        {
+            GM_ASSERT( i_buildNode.m_objectCount <= c_bvhMaxLeafSize );
+            int objectOffset                   = i_objectOffset + i_buildNode.m_objectOffset;
+            m_nodes[ nodeIndex ].m_offset      = objectOffset;
+            m_nodes[ nodeIndex ].m_objectCount = i_buildNode.m_objectCount;
+
+            // Sample the extent of the objects at each keyframe.
+            for ( int keyframeIndex = 0; keyframeIndex < m_keyframeCount; ++keyframeIndex )
+            {
+                std::vector< float > keyframeTime = {i_keyframeTimes[ keyframeIndex ]};
+                gm::Vec3fRange&      extent       = m_extents[ m_nodes[ nodeIndex ].m_extentOffset + keyframeIndex ];
+                for ( int objectIndex = objectOffset; objectIndex < objectOffset + i_buildNode.m_objectCount;
+                      ++objectIndex )
+                {
+                    extent = gm::Expand( extent, m_objects[ objectIndex ]->Extent( keyframeTime ) );
+                }
+            }
+        }
+        else
+        {
+            int leftIndex  = _Flatten( *i_buildNode.m_children[ 0 ], i_timeRange, i_keyframeTimes, i_objectOffset );
+            int rightIndex = _Flatten( *i_buildNode.m_children[ 1 ], i_timeRange, i_keyframeTimes, i_objectOffset );
+            m_nodes[ nodeIndex ].m_offset    = rightIndex;
+            m_nodes[ nodeIndex ].m_splitAxis = i_buildNode.m_splitAxis;
+
+            // The extent at each keyframe encompasses the extents of both children at the same keyframe.
+            for ( int keyframeIndex = 0; keyframeIndex < m_keyframeCount; ++keyframeIndex )
+            {
+                m_extents[ m_nodes[ nodeIndex ].m_extentOffset + keyframeIndex ] =
+                    gm::Expand( m_extents[ m_nodes[ leftIndex ].m_extentOffset + keyframeIndex ],
+                                m_extents[ m_nodes[ rightIndex ].m_extentOffset + keyframeIndex ] );
+            }
+        }
+
+        return nodeIndex;
+    }
+
+    // Slab test of a ray against the extent of \p i_node, interpolated between the keyframe at
+    // \p i_keyframeIndex and the following keyframe by \p i_weight.
+    inline bool _IntersectNode( const MotionBVHNode&  i_node,
+                                int                   i_keyframeIndex,
+                                float                 i_weight,
+                                const gm::Vec3f&      i_origin,
+                                const gm::Vec3f&      i_inverseDirection,
+                                const gm::FloatRange& i_magnitudeRange ) const
+    {
+        const gm::Vec3fRange& extentA = m_extents[ i_node.m_extentOffset + i_keyframeIndex ];
+        const gm::Vec3fRange& extentB = m_extents[ i_node.m_extentOffset + i_keyframeIndex + 1 ];
+
+        float magnitudeMin = i_magnitudeRange.Min();
+        float magnitudeMax = i_magnitudeRange.Max();
+        for ( int axis = 0; axis < 3; ++axis )
+        {
+            float extentMin    = extentA.Min()[ axis ] + ( extentB.Min()[ axis ] - extentA.Min()[ axis ] ) * i_weight;
+            float extentMax    = extentA.Max()[ axis ] + ( extentB.Max()[ axis ] - extentA.Max()[ axis ] ) * i_weight;
+            float nearDistance = ( extentMin - i_origin[ axis ] ) * i_inverseDirection[ axis ];
+            float farDistance  = ( extentMax - i_origin[ axis ] ) * i_inverseDirection[ axis ];
+            if ( i_inverseDirection[ axis ] < 0.0f )
+            {
+                std::swap( nearDistance, farDistance );
+            }
+            farDistance *= c_bvhFarDistanceScale;
+
+            magnitudeMin = nearDistance > magnitudeMin ? nearDistance : magnitudeMin;
+            magnitudeMax = farDistance < magnitudeMax ? farDistance : magnitudeMax;
+            if ( magnitudeMax < magnitudeMin )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Number of keyframes per time range.
+    int m_keyframeCount = 0;
+
+    // Number of time ranges, each with its own spatial hierarchy.
+    int m_timeRangeCount = 0;
+
+    // Extent of all the objects, over the entire shutter interval.
+    gm::Vec3fRange m_extent;
+
+    // Nodes, with the root first.
+    std::vector< MotionBVHNode > m_nodes;
+
+    // Keyframe extents referenced by the spatial nodes.
+    std::vector< gm::Vec3fRange > m_extents;
+
+    // Ordered objects referenced by the leaf nodes, for each time range.  Raw pointers are used during
+    // traversal, to avoid reference counting, while the shared pointers retain ownership.
+    std::vector< const SceneObject* > m_objects;
+    SceneObjectPtrs                   m_objectPtrs;
+};
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,379 @@
+#pragma once
+
+/// \file raytrace/objMeshReader.h
+///
+/// Deserialization of a triangle mesh from a Wavefront OBJ file on disk.
+
+#include <raytrace/meshFile.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/tileRenderer.h>
+#include <raytrace/triangleMeshData.h>
+
+#include <gm/types/vec2f.h>
+#include <gm/types/vec3f.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class OBJParser
+///
+/// OBJParser parses the contents of a Wavefront OBJ file into triangle mesh buffers.
+///
+/// The contents are split into chunks of whole lines, which are parsed in parallel.  The chunks are then
+/// concatenated in order, which resolves the negative (relative) indices of faces against the attributes of the
+/// preceding chunks.
+///
+/// Polygons are triangulated as fans.  Vertices are shared by the faces referencing the same combination of
+/// position, texture coordinate & normal.  Texture coordinates & normals are only kept if every face corner
+/// references them.  Statements other than vertex attributes and faces, such as groups & materials, are ignored.
+class OBJParser
+{
+public:
+    /// Explicit constructor with the number of threads to parse with.
+    ///
+    /// \param i_threadCount The number of threads to parse with.  Zero uses all the hardware threads.
+    inline explicit OBJParser( int i_threadCount = 0 )
+        : m_chunkRenderer( i_threadCount, 1 )
+    {
+    }
+
+    /// Parse the contents of an OBJ file into \p o_meshData.
+    ///
+    /// \param i_contents The contents of the OBJ file.
+    /// \param o_meshData The mesh buffers to parse into.
+    /// \param o_error Description of the failure, if any.
+    ///
+    /// \return success of parsing.  Fails if a face is malformed, or references a missing attribute.
+    inline bool Parse( const std::string& i_contents, TriangleMeshData& o_meshData, std::string& o_error ) const
+    {
+        std::vector< const char* > chunkBounds;
+        SplitLineChunks( i_contents.data(), i_contents.data() + i_contents.size(), c_chunkSize, chunkBounds );
+
+        int                   chunkCount = chunkBounds.size() - 1;
+        std::vector< _Chunk > chunks( chunkCount );
+        m_chunkRenderer.ForEachRowBand( chunkCount, [&]( int i_beginChunk, int i_endChunk ) {
+            for ( int chunkIndex = i_beginChunk; chunkIndex < i_endChunk; ++chunkIndex )
+            {
+                _ParseChunk( chunkBounds[ chunkIndex ], chunkBounds[ chunkIndex + 1 ], chunks[ chunkIndex ] );
+            }
+        } );
+
+        // Concatenate the attributes of the chunks, and resolve the relative indices of the corners.
+        std::vector< gm::Vec3f > positions;
+        std::vector< gm::Vec2f > uvs;
+        std::vector< gm::Vec3f > normals;
+        std::vector< _Corner >   corners;
+        for ( const _Chunk& chunk : chunks )
+        {
+            if ( !chunk.m_error.empty() )
+            {
+                o_error = "Malformed statement '" + chunk.m_error + "'";
+                return false;
+            }
+
+            const int attributeOffsets[ 3 ] = {( int ) positions.size(), ( int ) uvs.size(), ( int ) normals.size()};
+            for ( _Corner corner : chunk.m_corners )
+            {
+                for ( int attribute = 0; attribute < 3; ++attribute )
+                {
+                    if ( corner.m_relativeMask & ( 1 << attribute ) )
+                    {
+                        corner.m_indices[ attribute ] += attributeOffsets[ attribute ];
+                    }
+                }
+                corners.push_back( corner );
+            }
+
+            positions.insert( positions.end(), chunk.m_positions.begin(), chunk.m_positions.end() );
+            uvs.insert( uvs.end(), chunk.m_uvs.begin(), chunk.m_uvs.end() );
+            normals.insert( normals.end(), chunk.m_normals.begin(), chunk.m_normals.end() );
+        }
+
+        // Validate the indices, and check which attributes are referenced by every corner.
+        const int attributeCounts[ 3 ] = {( int ) positions.size(), ( int ) uvs.size(), ( int ) normals.size()};
+        bool      hasAttribute[ 3 ]    = {true, !corners.empty(), !corners.empty()};
+        for ( const _Corner& corner : corners )
+        {
+            for ( int attribute = 0; attribute < 3; ++attribute )
+            {
+                int  index    = corner.m_indices[ attribute ];
+                bool relative = corner.m_relativeMask & ( 1 << attribute );
+                if ( index >= attributeCounts[ attribute ] || ( index < 0 && ( attribute == 0 || relative ) ) )
+                {
+                    o_error = "Face references a missing vertex attribute";
+                    return false;
+                }
+                hasAttribute[ attribute ] = hasAttribute[ attribute ] && index >= 0;
+            }
+        }
+
+        o_meshData.m_positions.clear();
+        o_meshData.m_uvs.clear();
+        o_meshData.m_normals.clear();
+        o_meshData.m_indices.clear();
+        o_meshData.m_indices.reserve( corners.size() );
+        if ( !hasAttribute[ 1 ] && !hasAttribute[ 2 ] )
+        {
+            // The positions are the vertices.
+            o_meshData.m_positions = std::move( positions );
+            for ( const _Corner& corner : corners )
+            {
+                o_meshData.m_indices.push_back( corner.m_indices[ 0 ] );
+            }
+            return true;
+        }
+
+        // Share a vertex between the corners with the same combination of attributes.
+        std::unordered_map< _VertexKey, int, _VertexKeyHash > vertexIndices;
+        for ( const _Corner& corner : corners )
+        {
+            _VertexKey key;
+            key.m_position = corner.m_indices[ 0 ];
+            key.m_uv       = hasAttribute[ 1 ] ? corner.m_indices[ 1 ] : 0;
+            key.m_normal   = hasAttribute[ 2 ] ? corner.m_indices[ 2 ] : 0;
+
+            auto insertion = vertexIndices.insert( std::make_pair( key, ( int ) o_meshData.m_positions.size() ) );
+            if ( insertion.second )
+            {
+                o_meshData.m_positions.push_back( positions[ key.m_position ] );
+                if ( hasAttribute[ 1 ] )
+                {
+                    o_meshData.m_uvs.push_back( uvs[ key.m_uv ] );
+                }
+                if ( hasAttribute[ 2 ] )
+                {
+                    o_meshData.m_normals.push_back( normals[ key.m_normal ] );
+                }
+            }
+            o_meshData.m_indices.push_back( insertion.first->second );
+        }
+
+        return true;
+    }
+
+private:
+    // The approximate number of bytes per chunk.
+    static constexpr size_t c_chunkSize = 1 << 18;
+
+    // A corner of a face, referencing a position, and optionally a texture coordinate and a normal.
+    class _Corner
+    {
+    public:
+        // Indices of the position, texture coordinate & normal.  -1 if absent.
+        int m_indices[ 3 ] = {-1, -1, -1};
+
+        // Bit mask of the indices which are relative to the start of the chunk they were parsed from.  Negative
+        // OBJ indices reference the attributes preceding the face, some of which may be in previous chunks.
+        int m_relativeMask = 0;
+    };
+
+    // Attributes & faces parsed from a chunk.
+    class _Chunk
+    {
+    public:
+        std::vector< gm::Vec3f > m_positions;
+        std::vector< gm::Vec2f > m_uvs;
+        std::vector< gm::Vec3f > m_normals;
+        std::vector< _Corner >   m_corners;
+
+        // The statement which failed to parse, if any.
+        std::string m_error;
+    };
+
+    // The combination of attributes of a vertex, shared between face corners.
+    class _VertexKey
+    {
+    public:
+        inline bool operator==( const _VertexKey& i_other ) const
+        {
+            return m_position == i_other.m_position && m_uv == i_other.m_uv && m_normal == i_other.m_normal;
+        }
+
+        int m_position = 0;
+        int m_uv       = 0;
+        int m_normal   = 0;
+    };
+
+    class _VertexKeyHash
+    {
+    public:
+        inline size_t operator()( const _VertexKey& i_key ) const
+        {
+            uint64_t hash = ( uint32_t ) i_key.m_position;
+            hash          = hash * 0x9E3779B97F4A7C15ull + ( uint32_t ) i_key.m_uv;
+            hash          = hash * 0x9E3779B97F4A7C15ull + ( uint32_t ) i_key.m_normal;
+            return ( size_t )( hash ^ ( hash >> 32 ) );
+        }
+    };
+
+    // Parse the whole lines within [\p i_begin, \p i_end) into \p o_chunk.
+    static inline void _ParseChunk( const char* i_begin, const char* i_end, _Chunk& o_chunk )
+    {
+        std::string line;
+        const char* lineBegin = i_begin;
+        while ( lineBegin < i_end )
+        {
+            // Parse a copy of the line, such that number parsing stops at its end.
+            const char* lineEnd = std::find( lineBegin, i_end, '\n' );
+            line.assign( lineBegin, lineEnd );
+            lineBegin = lineEnd + 1;
+
+            const char* cursor = line.c_str();
+            while ( *cursor == ' ' || *cursor == '\t' )
+            {
+                ++cursor;
+            }
+
+            bool parsed = true;
+            if ( cursor[ 0 ] == 'v' && ( cursor[ 1 ] == ' ' || cursor[ 1 ] == '\t' ) )
+            {
+                o_chunk.m_positions.push_back( _ParseVec3f( cursor + 1 ) );
+            }
+            else if ( cursor[ 0 ] == 'v' && cursor[ 1 ] == 't' )
+            {
+                char*     end = nullptr;
+                gm::Vec2f uv;
+                uv[ 0 ] = std::strtof( cursor + 2, &end );
+                uv[ 1 ] = std::strtof( end, &end );
+                o_chunk.m_uvs.push_back( uv );
+            }
+            else if ( cursor[ 0 ] == 'v' && cursor[ 1 ] == 'n' )
+            {
+                o_chunk.m_normals.push_back( _ParseVec3f( cursor + 2 ) );
+            }
+            else if ( cursor[ 0 ] == 'f' && ( cursor[ 1 ] == ' ' || cursor[ 1 ] == '\t' ) )
+            {
+                parsed = _ParseFace( cursor + 1, o_chunk );
+            }
+
+            if ( !parsed )
+            {
+                o_chunk.m_error = line;
+                return;
+            }
+        }
+    }
+
+    // Parse three whitespace separated floating point values.
+    static inline gm::Vec3f _ParseVec3f( const char* i_cursor )
+    {
+        char*     end = nullptr;
+        gm::Vec3f value;
+        value[ 0 ] = std::strtof( i_cursor, &end );
+        value[ 1 ] = std::strtof( end, &end );
+        value[ 2 ] = std::strtof( end, &end );
+        return value;
+    }
+
+    // Parse the corners of a face, and append it to \p io_chunk as a fan of triangles around its first corner.
+    static inline bool _ParseFace( const char* i_cursor, _Chunk& io_chunk )
+    {
+        const int attributeCounts[ 3 ] = {( int ) io_chunk.m_positions.size(),
+                                          ( int ) io_chunk.m_uvs.size(),
+                                          ( int ) io_chunk.m_normals.size()};
+
+        std::vector< _Corner > polygon;
+        while ( true )
+        {
+            while ( *i_cursor == ' ' || *i_cursor == '\t' || *i_cursor == '\r' )
+            {
+                ++i_cursor;
+            }
+            if ( *i_cursor == '\0' )
+            {
+                break;
+            }
+
+            // A corner is one of "v", "v/vt", "v//vn" or "v/vt/vn".
+            _Corner corner;
+            for ( int attribute = 0; attribute < 3; ++attribute )
+            {
+                if ( attribute > 0 )
+                {
+                    if ( *i_cursor != '/' )
+                    {
+                        break;
+                    }
+
+                    ++i_cursor;
+                    if ( attribute == 1 && *i_cursor == '/' )
+                    {
+                        continue;
+                    }
+                }
+
+                char* end   = nullptr;
+                long  index = std::strtol( i_cursor, &end, 10 );
+                if ( end == i_cursor || index == 0 )
+                {
+                    return false;
+                }
+                i_cursor = end;
+
+                if ( index > 0 )
+                {
+                    corner.m_indices[ attribute ] = index - 1;
+                }
+                else
+                {
+                    corner.m_indices[ attribute ] = attributeCounts[ attribute ] + index;
+                    corner.m_relativeMask |= 1 << attribute;
+                }
+            }
+            polygon.push_back( corner );
+        }
+
+        if ( polygon.size() < 3 )
+        {
+            return false;
+        }
+
+        for ( size_t cornerIndex = 2; cornerIndex < polygon.size(); ++cornerIndex )
+        {
+            io_chunk.m_corners.push_back( polygon[ 0 ] );
+            io_chunk.m_corners.push_back( polygon[ cornerIndex - 1 ] );
+            io_chunk.m_corners.push_back( polygon[ cornerIndex ] );
+        }
+
+        return true;
+    }
+
+    TileRenderer m_chunkRenderer;
+};
+
+/// Read the triangles of the Wavefront OBJ file at file location \p i_filePath into \p o_meshData.
+///
+/// The file is read into memory at once, then parsed in parallel, see \ref OBJParser.
+///
+/// \param i_filePath file location of the OBJ file.
+/// \param o_meshData the mesh buffers to read into.
+/// \param i_threadCount The number of threads to parse with.  Zero uses all the hardware threads.
+///
+/// \return success of reading the mesh.
+inline bool ReadOBJMesh( const std::string& i_filePath, TriangleMeshData& o_meshData, int i_threadCount = 0 )
+{
+    std::string contents;
+    if ( !ReadMeshFile( i_filePath, contents ) )
+    {
+        return false;
+    }
+
+    std::string error;
+    if ( !OBJParser( i_threadCount ).Parse( contents, o_meshData, error ) )
+    {
+        fprintf( stderr, "%s in mesh '%s'!\n", error.c_str(), i_filePath.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+RAYTRACE_NS_CLOSE
@@ -11,33 +11,15 @@
 
 #include <gm/functions/expand.h>
 #include <gm/functions/intersection.h>
+#include <gm/functions/randomNumber.h>
 #include <gm/functions/rayAABBIntersection.h>
 
-#include <iostream>
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 RAYTRACE_NS_OPEN
 
-/// Functor for comparing two objects based on their computed extents minima for a
-/// specified axis \p axis.
-class ObjectExtentComparison
-{
-public:
-    ObjectExtentComparison( int i_axis, const std::vector< float >& i_times )
-        : m_axis( i_axis )
-        , m_times( i_times )
-    {
-    }
-
-    bool operator()( const SceneObjectPtr& i_objectA, const SceneObjectPtr& i_objectB )
-    {
-        return i_objectA->Extent( m_times ).Min()[ m_axis ] < i_objectB->Extent( m_times ).Min()[ m_axis ];
-    }
-
-private:
-    int                         m_axis = 0;
-    const std::vector< float >& m_times;
-};
-
 /// \class ObjectBVHNode
 ///
 /// ObjectBVHNode is a single node in the bounding volume hierarchy.
@@ -47,8 +29,8 @@ private:
 ///
 /// BVH is represented as a binary tree, so each ObjectBVHNode has \em left & \em right children.
 ///
-/// This BVH utilizes a object-based partioning strategy, by sorting the object range
-/// based on their extent minima with respect to a randomly chosen axis then splitting down the middle.
+/// This BVH utilizes a object-based partioning strategy, by partitioning the object range about the median of
+/// their extent minima with respect to a randomly chosen axis, then splitting down the middle.
 class ObjectBVHNode : public SceneObject
 {
 public:
@@ -87,9 +69,28 @@ public:
 
         // Choose a random axis.
         int randomAxis = gm::RandomNumber( gm::IntRange( 0, 3 ) );
-        std::sort( o_sceneObjects.begin() + i_objectRange.Min(),
-                   o_sceneObjects.begin() + i_objectRange.Max(),
-                   ObjectExtentComparison( randomAxis, i_times ) );
+
+        // Compute the extent minima once per object, rather than per comparison, then partition the range
+        // about its median.  A full sort is unnecessary, as only the two halves are used.
+        std::vector< std::pair< float, SceneObjectPtr > > keyedObjects;
+        keyedObjects.reserve( objectCount );
+        for ( int objectIndex : i_objectRange )
+        {
+            const SceneObjectPtr& sceneObject = o_sceneObjects[ objectIndex ];
+            keyedObjects.push_back(
+                std::pair< float, SceneObjectPtr >( sceneObject->Extent( i_times ).Min()[ randomAxis ], sceneObject ) );
+        }
+        std::nth_element( keyedObjects.begin(),
+                          keyedObjects.begin() + objectCount / 2,
+                          keyedObjects.end(),
+                          []( const std::pair< float, SceneObjectPtr >& i_objectA,
+                              const std::pair< float, SceneObjectPtr >& i_objectB ) {
+                              return i_objectA.first < i_objectB.first;
+                          } );
+        for ( size_t keyedIndex = 0; keyedIndex < keyedObjects.size(); ++keyedIndex )
+        {
+            o_sceneObjects[ i_objectRange.Min() + keyedIndex ] = std::move( keyedObjects[ keyedIndex ].second );
+        }
 
         // Split object range into left and right parts.
         int midObjectIndex = i_objectRange.Min() + objectCount / 2;
@@ -147,6 +148,18 @@ public:
         return hitLeft || hitRight;
     }
 
+    virtual inline bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const override
+    {
+        gm::FloatRange intersections;
+        if ( !gm::RayAABBIntersection( i_ray.Origin(), i_ray.Direction(), m_extent, intersections ) ||
+             intersections.Min() > i_magnitudeRange.Max() )
+        {
+            return false;
+        }
+
+        return m_left->Occluded( i_ray, i_magnitudeRange ) || m_right->Occluded( i_ray, i_magnitudeRange );
+    }
+
     virtual gm::Vec3fRange Extent( const std::vector< float >& i_times ) const override
     {
         return m_extent;
@@ -8,6 +8,7 @@
 
 #include <gm/types/floatRange.h>
 #include <gm/types/intRange.h>
+#include <gm/types/vec3i.h>
 
 #include <gm/functions/abs.h>
 #include <gm/functions/dotProduct.h>
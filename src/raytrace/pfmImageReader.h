@@ -0,0 +1,77 @@
+#pragma once
+
+/// \file raytrace/pfmImageReader.h
+///
+/// Deserialization of a high dynamic range image from a PFM file on disk.
+
+#include <raytrace/imageBuffer.h>
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec3f.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+RAYTRACE_NS_OPEN
+
+/// Read the RGB PFM image at file location \p i_filePath into \p o_image, such as one written by
+/// \ref WritePFMImage.
+///
+/// \param i_filePath file location of the PFM image.
+/// \param o_image the image buffer to read into.  It is resized to the dimensions of the image.
+///
+/// \return success of reading the image.  Fails if the file is not an RGB PFM, or is truncated.
+inline bool ReadPFMImage( const std::string& i_filePath, RGBImageBuffer& o_image )
+{
+    static_assert( sizeof( gm::Vec3f ) == 3 * sizeof( float ), "Vec3f must be tightly packed." );
+
+    std::ifstream fileInput( i_filePath.c_str(), std::ios::in | std::ios::binary );
+    if ( !fileInput.is_open() )
+    {
+        fprintf( stderr, "Cannot open file '%s' for reading!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    // The header is followed by a single whitespace character, then the pixels.
+    std::string encoding;
+    int         width  = 0;
+    int         height = 0;
+    float       scale  = 0.0f;
+    fileInput >> encoding >> width >> height >> scale;
+    fileInput.get();
+    if ( !fileInput || encoding != "PF" || width <= 0 || height <= 0 || scale == 0.0f )
+    {
+        fprintf( stderr, "Unrecognized PFM image '%s'!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    o_image.Resize( width, height );
+    fileInput.read( reinterpret_cast< char* >( o_image.Data() ),
+                    ( std::streamsize ) width * height * sizeof( gm::Vec3f ) );
+    if ( !fileInput )
+    {
+        fprintf( stderr, "Failed to read image '%s'!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    // A negative scale denotes little endian pixels.  Swap the bytes of pixels not in the byte order of the host.
+    uint16_t byteOrderProbe = 1;
+    uint8_t  lowByte        = 0;
+    std::memcpy( &lowByte, &byteOrderProbe, 1 );
+    if ( ( scale < 0.0f ) != ( lowByte == 1 ) )
+    {
+        uint8_t* bytes = reinterpret_cast< uint8_t* >( o_image.Data() );
+        for ( size_t valueIndex = 0; valueIndex < ( size_t ) width * height * 3; ++valueIndex )
+        {
+            std::reverse( bytes + valueIndex * sizeof( float ), bytes + ( valueIndex + 1 ) * sizeof( float ) );
+        }
+    }
+
+    return true;
+}
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,71 @@
+#pragma once
+
+/// \file raytrace/pfmImageWriter.h
+///
+/// Serialization of a high dynamic range image into a PFM file on disk.
+
+#include <raytrace/imageBuffer.h>
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec3f.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+RAYTRACE_NS_OPEN
+
+/// Compose the header of an RGB PFM file: the RGB encoding, dimensions, and a scale whose sign denotes the byte
+/// order of the pixels (negative for little endian).  The pixels are in the byte order of the host.
+///
+/// \param i_width width of the image.
+/// \param i_height height of the image.
+///
+/// \return The header.
+inline std::string PFMHeader( int i_width, int i_height )
+{
+    uint16_t byteOrderProbe = 1;
+    uint8_t  lowByte        = 0;
+    std::memcpy( &lowByte, &byteOrderProbe, 1 );
+    return "PF\n" + std::to_string( i_width ) + ' ' + std::to_string( i_height ) +
+           ( lowByte == 1 ? "\n-1.0\n" : "\n1.0\n" );
+}
+
+/// Write the linear, floating point image \p i_image into file location \p i_filePath, as an RGB PFM.
+///
+/// PFM stores its rows from the bottom up, in the byte order of the host, which matches the in-memory layout of
+/// \ref ImageBuffer.  The pixels are therefore written out directly, without any encoding.
+///
+/// \param i_image the image buffer to write.
+/// \param i_filePath file location to save the PFM image.
+///
+/// \return success of writing the image.
+inline bool WritePFMImage( const RGBImageBuffer& i_image, const std::string& i_filePath )
+{
+    static_assert( sizeof( gm::Vec3f ) == 3 * sizeof( float ), "Vec3f must be tightly packed." );
+
+    std::ofstream fileOutput( i_filePath.c_str(), std::ios::out | std::ios::trunc | std::ios::binary );
+    if ( !fileOutput.is_open() )
+    {
+        fprintf( stderr, "Cannot open file '%s' for writing!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    std::string header = PFMHeader( i_image.Width(), i_image.Height() );
+
+    fileOutput.write( header.data(), header.size() );
+    fileOutput.write( reinterpret_cast< const char* >( i_image.Data() ),
+                      ( std::streamsize ) i_image.Width() * i_image.Height() * sizeof( gm::Vec3f ) );
+    fileOutput.close();
+    if ( !fileOutput )
+    {
+        fprintf( stderr, "Failed to write image '%s'!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+RAYTRACE_NS_CLOSE
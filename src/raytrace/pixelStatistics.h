@@ -0,0 +1,134 @@
+#pragma once
+
+/// \file raytrace/pixelStatistics.h
+///
+/// Running statistics of the samples taken for a pixel.
+
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec3f.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+RAYTRACE_NS_OPEN
+
+/// \class PixelStatistics
+///
+/// PixelStatistics accumulates the mean color of the samples of a pixel, along with the variance of their
+/// luminance.
+///
+/// The mean and variance are updated incrementally with Welford's algorithm, which remains numerically stable
+/// over large sample counts, without storing the samples.
+class PixelStatistics
+{
+public:
+    /// The z-score of the confidence interval reported by \ref RelativeError: 95% confidence.
+    static constexpr float c_confidenceZScore = 1.96f;
+
+    /// The luminance below which the error of a pixel is measured relative to this value instead, such
+    /// that noise in nearly black pixels does not dominate.
+    static constexpr float c_minRelativeLuminance = 0.01f;
+
+    /// Default constructor, with no accumulated samples.
+    PixelStatistics() = default;
+
+    /// Explicit constructor, restoring previously accumulated statistics.
+    ///
+    /// \param i_sampleCount The number of accumulated samples.
+    /// \param i_mean The mean color of the accumulated samples.
+    /// \param i_meanLuminance The mean luminance of the accumulated samples.
+    /// \param i_luminanceM2 The sum of squared luminance differences from the mean.
+    inline explicit PixelStatistics( int              i_sampleCount,
+                                     const gm::Vec3f& i_mean,
+                                     float            i_meanLuminance,
+                                     float            i_luminanceM2 )
+        : m_sampleCount( i_sampleCount )
+        , m_mean( i_mean )
+        , m_meanLuminance( i_meanLuminance )
+        , m_luminanceM2( i_luminanceM2 )
+    {
+    }
+
+    /// Accumulate a sample.
+    ///
+    /// \param i_color The color of the sample.
+    inline void AddSample( const gm::Vec3f& i_color )
+    {
+        m_sampleCount++;
+        float inverseCount = 1.0f / ( float ) m_sampleCount;
+
+        m_mean += ( i_color - m_mean ) * inverseCount;
+
+        float luminance      = Luminance( i_color );
+        float deltaLuminance = luminance - m_meanLuminance;
+        m_meanLuminance += deltaLuminance * inverseCount;
+        m_luminanceM2 += deltaLuminance * ( luminance - m_meanLuminance );
+    }
+
+    /// Get the number of accumulated samples.
+    inline int SampleCount() const
+    {
+        return m_sampleCount;
+    }
+
+    /// Get the mean color of the accumulated samples.
+    inline const gm::Vec3f& Mean() const
+    {
+        return m_mean;
+    }
+
+    /// Get the mean luminance of the accumulated samples.
+    inline float MeanLuminance() const
+    {
+        return m_meanLuminance;
+    }
+
+    /// Get the sum of squared differences between the luminance of each sample and the mean luminance.
+    inline float LuminanceM2() const
+    {
+        return m_luminanceM2;
+    }
+
+    /// Compute the unbiased sample variance of the luminance of the accumulated samples.
+    ///
+    /// \return The variance, or zero if fewer than two samples were accumulated.
+    inline float LuminanceVariance() const
+    {
+        return m_sampleCount > 1 ? m_luminanceM2 / ( float ) ( m_sampleCount - 1 ) : 0.0f;
+    }
+
+    /// Estimate the error of the mean luminance, as the half-width of its confidence interval relative to the
+    /// mean luminance.
+    ///
+    /// \return The relative error, or infinity if fewer than two samples were accumulated.
+    inline float RelativeError() const
+    {
+        if ( m_sampleCount < 2 )
+        {
+            return std::numeric_limits< float >::infinity();
+        }
+
+        float halfWidth = c_confidenceZScore * std::sqrt( LuminanceVariance() / ( float ) m_sampleCount );
+        return halfWidth / std::max( m_meanLuminance, c_minRelativeLuminance );
+    }
+
+    /// Compute the luminance of a linear RGB color, with the Rec. 709 weights.
+    ///
+    /// \param i_color The color.
+    ///
+    /// \return The luminance.
+    static inline float Luminance( const gm::Vec3f& i_color )
+    {
+        return 0.2126f * i_color[ 0 ] + 0.7152f * i_color[ 1 ] + 0.0722f * i_color[ 2 ];
+    }
+
+private:
+    int       m_sampleCount   = 0;
+    gm::Vec3f m_mean          = gm::Vec3f( 0, 0, 0 );
+    float     m_meanLuminance = 0.0f;
+    float     m_luminanceM2   = 0.0f;
+};
+
+RAYTRACE_NS_CLOSE
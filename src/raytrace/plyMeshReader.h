@@ -0,0 +1,854 @@
+#pragma once
+
+/// \file raytrace/plyMeshReader.h
+///
+/// Deserialization of a triangle mesh from a Stanford PLY file on disk.
+
+#include <raytrace/meshFile.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/tileRenderer.h>
+#include <raytrace/triangleMeshData.h>
+
+#include <gm/types/vec2f.h>
+#include <gm/types/vec3f.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class PLYParser
+///
+/// PLYParser parses the contents of a Stanford PLY file, in the ASCII or either of the binary formats, into
+/// triangle mesh buffers.
+///
+/// The header is parsed first, to lay out the elements.  The body is then split into chunks of whole records,
+/// which are parsed in parallel.  Vertices are written in place, as the index of each is known from its record,
+/// while the faces of the chunks are concatenated in order.
+///
+/// The "vertex" element provides the positions (x, y, z), and optionally the normals (nx, ny, nz) and texture
+/// coordinates (u, v, or s, t).  The "face" element provides the polygons, as a list of vertex indices
+/// ("vertex_indices" or "vertex_index"), which are triangulated as fans.  Other elements & properties are skipped.
+class PLYParser
+{
+public:
+    /// Explicit constructor with the number of threads to parse with.
+    ///
+    /// \param i_threadCount The number of threads to parse with.  Zero uses all the hardware threads.
+    inline explicit PLYParser( int i_threadCount = 0 )
+        : m_chunkRenderer( i_threadCount, 1 )
+    {
+    }
+
+    /// Parse the contents of a PLY file into \p o_meshData.
+    ///
+    /// \param i_contents The contents of the PLY file.
+    /// \param o_meshData The mesh buffers to parse into.
+    /// \param o_error Description of the failure, if any.
+    ///
+    /// \return success of parsing.  Fails if the header is malformed, the data ends early, or a face is malformed
+    /// or references a missing vertex.
+    inline bool Parse( const std::string& i_contents, TriangleMeshData& o_meshData, std::string& o_error ) const
+    {
+        _Header     header;
+        const char* body = nullptr;
+        if ( !_ParseHeader( i_contents, header, body, o_error ) )
+        {
+            return false;
+        }
+
+        const char*           contentsEnd = i_contents.data() + i_contents.size();
+        std::vector< _Chunk > chunks;
+        bool                  split       = false;
+        if ( header.m_format == _Format::ASCII )
+        {
+            split = _SplitASCIIChunks( header, body, contentsEnd, chunks, o_error );
+        }
+        else
+        {
+            split = _SplitBinaryChunks( header, body, contentsEnd, chunks, o_error );
+        }
+        if ( !split )
+        {
+            return false;
+        }
+
+        int vertexCount = header.m_elements[ header.m_vertexElement ].m_count;
+        o_meshData.m_positions.assign( vertexCount, gm::Vec3f() );
+        o_meshData.m_normals.assign( header.m_normalProperties[ 0 ] >= 0 ? vertexCount : 0, gm::Vec3f() );
+        o_meshData.m_uvs.assign( header.m_uvProperties[ 0 ] >= 0 ? vertexCount : 0, gm::Vec2f() );
+        o_meshData.m_indices.clear();
+
+        m_chunkRenderer.ForEachRowBand( chunks.size(), [&]( int i_beginChunk, int i_endChunk ) {
+            for ( int chunkIndex = i_beginChunk; chunkIndex < i_endChunk; ++chunkIndex )
+            {
+                _ParseChunk( header, o_meshData, chunks[ chunkIndex ] );
+            }
+        } );
+
+        // Concatenate the triangles of the chunks.
+        for ( const _Chunk& chunk : chunks )
+        {
+            if ( !chunk.m_error.empty() )
+            {
+                o_error = chunk.m_error;
+                return false;
+            }
+
+            o_meshData.m_indices.insert( o_meshData.m_indices.end(), chunk.m_indices.begin(), chunk.m_indices.end() );
+        }
+
+        return true;
+    }
+
+private:
+    // The approximate number of bytes per chunk.
+    static constexpr size_t c_chunkSize = 1 << 18;
+
+    // The encoding of the body.
+    enum class _Format
+    {
+        ASCII,
+        BinaryLittleEndian,
+        BinaryBigEndian
+    };
+
+    // The type of a property value.
+    enum class _ScalarType
+    {
+        Int8,
+        UInt8,
+        Int16,
+        UInt16,
+        Int32,
+        UInt32,
+        Float32,
+        Float64
+    };
+
+    // A property of an element: a single value, or a list of values preceded by their count.
+    class _Property
+    {
+    public:
+        std::string m_name;
+        _ScalarType m_type      = _ScalarType::Float32;
+        _ScalarType m_countType = _ScalarType::UInt8;
+        bool        m_isList    = false;
+    };
+
+    // An element, such as the vertices or the faces, which is a sequence of records of the same properties.
+    class _Element
+    {
+    public:
+        std::string              m_name;
+        int64_t                  m_count = 0;
+        std::vector< _Property > m_properties;
+
+        // The index of the first record of this element, counting the records of all the elements.
+        int64_t m_firstRecord = 0;
+
+        // The number of bytes of a binary record, or -1 if it varies, due to a list property.
+        int64_t m_recordSize = 0;
+    };
+
+    // The layout of the body, and the properties which the mesh is read from.
+    class _Header
+    {
+    public:
+        _Format                 m_format = _Format::ASCII;
+        std::vector< _Element > m_elements;
+        int64_t                 m_recordCount = 0;
+
+        int m_vertexElement           = -1;
+        int m_positionProperties[ 3 ] = {-1, -1, -1};
+        int m_normalProperties[ 3 ]   = {-1, -1, -1};
+        int m_uvProperties[ 2 ]       = {-1, -1};
+
+        int m_faceElement   = -1;
+        int m_indexProperty = -1;
+    };
+
+    // A range of whole records of the body, and the triangles parsed from it.
+    class _Chunk
+    {
+    public:
+        const char* m_begin       = nullptr;
+        const char* m_end         = nullptr;
+        int64_t     m_firstRecord = 0;
+
+        std::vector< int > m_indices;
+
+        // Description of the failure to parse the chunk, if any.
+        std::string m_error;
+    };
+
+    // The values of a single record.
+    class _Record
+    {
+    public:
+        // The value of each single value property.  The count, for list properties.
+        std::vector< double > m_values;
+
+        // The values of the list property which is read, such as the vertex indices of a face.
+        std::vector< int64_t > m_list;
+    };
+
+    // Parse the header at the start of \p i_contents into \p o_header, and locate the start of the body.
+    static inline bool
+    _ParseHeader( const std::string& i_contents, _Header& o_header, const char*& o_body, std::string& o_error )
+    {
+        size_t lineBegin = 0;
+        bool   firstLine = true;
+        while ( true )
+        {
+            size_t lineEnd = i_contents.find( '\n', lineBegin );
+            if ( lineEnd == std::string::npos )
+            {
+                o_error = "Missing end of header";
+                return false;
+            }
+
+            std::string        line = i_contents.substr( lineBegin, lineEnd - lineBegin );
+            std::istringstream lineStream( line );
+            lineBegin = lineEnd + 1;
+
+            std::string keyword;
+            lineStream >> keyword;
+            if ( firstLine )
+            {
+                if ( keyword != "ply" )
+                {
+                    o_error = "Missing PLY signature";
+                    return false;
+                }
+                firstLine = false;
+            }
+            else if ( keyword == "end_header" )
+            {
+                break;
+            }
+            else if ( keyword == "format" )
+            {
+                std::string format;
+                lineStream >> format;
+                if ( format == "ascii" )
+                {
+                    o_header.m_format = _Format::ASCII;
+                }
+                else if ( format == "binary_little_endian" )
+                {
+                    o_header.m_format = _Format::BinaryLittleEndian;
+                }
+                else if ( format == "binary_big_endian" )
+                {
+                    o_header.m_format = _Format::BinaryBigEndian;
+                }
+                else
+                {
+                    o_error = "Unsupported format '" + line + "'";
+                    return false;
+                }
+            }
+            else if ( keyword == "element" )
+            {
+                _Element element;
+                lineStream >> element.m_name >> element.m_count;
+                if ( !lineStream || element.m_count < 0 )
+                {
+                    o_error = "Malformed header statement '" + line + "'";
+                    return false;
+                }
+                o_header.m_elements.push_back( element );
+            }
+            else if ( keyword == "property" )
+            {
+                _Property   property;
+                std::string typeName;
+                lineStream >> typeName;
+                if ( typeName == "list" )
+                {
+                    std::string countTypeName;
+                    lineStream >> countTypeName >> typeName;
+                    property.m_isList = _ParseScalarType( countTypeName, property.m_countType );
+                    if ( !property.m_isList )
+                    {
+                        lineStream.setstate( std::ios::failbit );
+                    }
+                }
+                lineStream >> property.m_name;
+                if ( !lineStream || o_header.m_elements.empty() || !_ParseScalarType( typeName, property.m_type ) )
+                {
+                    o_error = "Malformed header statement '" + line + "'";
+                    return false;
+                }
+                o_header.m_elements.back().m_properties.push_back( property );
+            }
+            else if ( !keyword.empty() && keyword != "comment" && keyword != "obj_info" )
+            {
+                o_error = "Malformed header statement '" + line + "'";
+                return false;
+            }
+        }
+        o_body = i_contents.data() + lineBegin;
+
+        // Lay out the records, and find the properties which the mesh is read from.
+        for ( size_t elementIndex = 0; elementIndex < o_header.m_elements.size(); ++elementIndex )
+        {
+            _Element& element     = o_header.m_elements[ elementIndex ];
+            element.m_firstRecord = o_header.m_recordCount;
+            o_header.m_recordCount += element.m_count;
+
+            element.m_recordSize = 0;
+            for ( const _Property& property : element.m_properties )
+            {
+                element.m_recordSize = property.m_isList || element.m_recordSize < 0
+                                           ? -1
+                                           : element.m_recordSize + _ScalarSize( property.m_type );
+            }
+
+            if ( element.m_name == "vertex" && o_header.m_vertexElement < 0 )
+            {
+                o_header.m_vertexElement = elementIndex;
+                _FindProperties( element, {"x", "y", "z"}, o_header.m_positionProperties );
+                _FindProperties( element, {"nx", "ny", "nz"}, o_header.m_normalProperties );
+                _FindProperties( element, {"u", "v"}, o_header.m_uvProperties );
+                if ( o_header.m_uvProperties[ 0 ] < 0 )
+                {
+                    _FindProperties( element, {"s", "t"}, o_header.m_uvProperties );
+                }
+            }
+            else if ( element.m_name == "face" && o_header.m_faceElement < 0 )
+            {
+                o_header.m_faceElement = elementIndex;
+                _FindProperties( element, {"vertex_indices"}, &o_header.m_indexProperty );
+                if ( o_header.m_indexProperty < 0 )
+                {
+                    _FindProperties( element, {"vertex_index"}, &o_header.m_indexProperty );
+                }
+            }
+        }
+
+        if ( o_header.m_vertexElement < 0 || o_header.m_positionProperties[ 0 ] < 0 )
+        {
+            o_error = "Missing vertex positions";
+            return false;
+        }
+        if ( o_header.m_elements[ o_header.m_vertexElement ].m_count > INT_MAX )
+        {
+            o_error = "Too many vertices";
+            return false;
+        }
+        if ( o_header.m_faceElement < 0 || o_header.m_indexProperty < 0 ||
+             !o_header.m_elements[ o_header.m_faceElement ].m_properties[ o_header.m_indexProperty ].m_isList )
+        {
+            o_error = "Missing face vertex indices";
+            return false;
+        }
+
+        return true;
+    }
+
+    // Find the properties of \p i_element named \p i_names, and write their indices to \p o_propertyIndices.  If
+    // any is missing, all the indices are set to -1.
+    static inline void _FindProperties( const _Element&                      i_element,
+                                        std::initializer_list< const char* > i_names,
+                                        int*                                 o_propertyIndices )
+    {
+        int  nameCount = 0;
+        bool found     = true;
+        for ( const char* name : i_names )
+        {
+            o_propertyIndices[ nameCount ] = -1;
+            for ( size_t propertyIndex = 0; propertyIndex < i_element.m_properties.size(); ++propertyIndex )
+            {
+                if ( i_element.m_properties[ propertyIndex ].m_name == name )
+                {
+                    o_propertyIndices[ nameCount ] = propertyIndex;
+                }
+            }
+            found = found && o_propertyIndices[ nameCount ] >= 0;
+            ++nameCount;
+        }
+
+        if ( !found )
+        {
+            std::fill( o_propertyIndices, o_propertyIndices + nameCount, -1 );
+        }
+    }
+
+    // Parse the name of a scalar type, including the sized aliases.
+    static inline bool _ParseScalarType( const std::string& i_name, _ScalarType& o_type )
+    {
+        static const std::pair< const char*, _ScalarType > c_typeNames[] = {{"char", _ScalarType::Int8},
+                                                                             {"int8", _ScalarType::Int8},
+                                                                             {"uchar", _ScalarType::UInt8},
+                                                                             {"uint8", _ScalarType::UInt8},
+                                                                             {"short", _ScalarType::Int16},
+                                                                             {"int16", _ScalarType::Int16},
+                                                                             {"ushort", _ScalarType::UInt16},
+                                                                             {"uint16", _ScalarType::UInt16},
+                                                                             {"int", _ScalarType::Int32},
+                                                                             {"int32", _ScalarType::Int32},
+                                                                             {"uint", _ScalarType::UInt32},
+                                                                             {"uint32", _ScalarType::UInt32},
+                                                                             {"float", _ScalarType::Float32},
+                                                                             {"float32", _ScalarType::Float32},
+                                                                             {"double", _ScalarType::Float64},
+                                                                             {"float64", _ScalarType::Float64}};
+        for ( const auto& typeName : c_typeNames )
+        {
+            if ( i_name == typeName.first )
+            {
+                o_type = typeName.second;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // The number of bytes of a binary value of type \p i_type.
+    static inline int _ScalarSize( _ScalarType i_type )
+    {
+        switch ( i_type )
+        {
+        case _ScalarType::Int8:
+        case _ScalarType::UInt8:
+            return 1;
+        case _ScalarType::Int16:
+        case _ScalarType::UInt16:
+            return 2;
+        case _ScalarType::Int32:
+        case _ScalarType::UInt32:
+        case _ScalarType::Float32:
+            return 4;
+        default:
+            return 8;
+        }
+    }
+
+    // Split the lines of an ASCII body into chunks, each starting with the record of its first non-blank line.
+    inline bool _SplitASCIIChunks( const _Header&         i_header,
+                                   const char*            i_body,
+                                   const char*            i_end,
+                                   std::vector< _Chunk >& o_chunks,
+                                   std::string&           o_error ) const
+    {
+        std::vector< const char* > chunkBounds;
+        SplitLineChunks( i_body, i_end, c_chunkSize, chunkBounds );
+
+        // Count the records within each chunk, in parallel, to find the first record of the next.
+        int                    chunkCount = chunkBounds.size() - 1;
+        std::vector< int64_t > recordCounts( chunkCount );
+        m_chunkRenderer.ForEachRowBand( chunkCount, [&]( int i_beginChunk, int i_endChunk ) {
+            for ( int chunkIndex = i_beginChunk; chunkIndex < i_endChunk; ++chunkIndex )
+            {
+                int64_t recordCount = 0;
+                bool    blankLine   = true;
+                for ( const char* cursor = chunkBounds[ chunkIndex ]; cursor < chunkBounds[ chunkIndex + 1 ]; ++cursor )
+                {
+                    if ( *cursor == '\n' )
+                    {
+                        recordCount += blankLine ? 0 : 1;
+                        blankLine = true;
+                    }
+                    else if ( !_IsBlank( *cursor ) )
+                    {
+                        blankLine = false;
+                    }
+                }
+                recordCounts[ chunkIndex ] = recordCount + ( blankLine ? 0 : 1 );
+            }
+        } );
+
+        o_chunks.resize( chunkCount );
+        int64_t firstRecord = 0;
+        for ( int chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex )
+        {
+            o_chunks[ chunkIndex ].m_begin       = chunkBounds[ chunkIndex ];
+            o_chunks[ chunkIndex ].m_end         = chunkBounds[ chunkIndex + 1 ];
+            o_chunks[ chunkIndex ].m_firstRecord = firstRecord;
+            firstRecord += recordCounts[ chunkIndex ];
+        }
+
+        if ( firstRecord < i_header.m_recordCount )
+        {
+            o_error = "Unexpected end of data";
+            return false;
+        }
+
+        return true;
+    }
+
+    // Split a binary body into chunks of whole records.  The size of each record is either fixed by its element,
+    // or found by skipping over its lists, which also checks that the body holds every record.
+    static inline bool _SplitBinaryChunks( const _Header&         i_header,
+                                           const char*            i_body,
+                                           const char*            i_end,
+                                           std::vector< _Chunk >& o_chunks,
+                                           std::string&           o_error )
+    {
+        bool swapBytes = _IsHostBigEndian() != ( i_header.m_format == _Format::BinaryBigEndian );
+
+        _Chunk      chunk;
+        const char* cursor = i_body;
+        int64_t     record = 0;
+        chunk.m_begin      = i_body;
+        for ( const _Element& element : i_header.m_elements )
+        {
+            int64_t remainingCount = element.m_count;
+            while ( remainingCount > 0 )
+            {
+                if ( element.m_recordSize >= 0 )
+                {
+                    // Advance by as many records of fixed size as fit in the chunk, and at least one.
+                    int64_t recordSize     = std::max< int64_t >( element.m_recordSize, 1 );
+                    int64_t chunkRemainder = ( int64_t ) c_chunkSize - ( cursor - chunk.m_begin );
+                    int64_t recordCount =
+                        std::min( remainingCount, std::max< int64_t >( 1, chunkRemainder / recordSize ) );
+                    if ( element.m_recordSize * recordCount > i_end - cursor )
+                    {
+                        o_error = "Unexpected end of data";
+                        return false;
+                    }
+                    cursor += element.m_recordSize * recordCount;
+                    record += recordCount;
+                    remainingCount -= recordCount;
+                }
+                else
+                {
+                    if ( !_SkipBinaryRecord( element, swapBytes, cursor, i_end ) )
+                    {
+                        o_error = "Unexpected end of data";
+                        return false;
+                    }
+                    ++record;
+                    --remainingCount;
+                }
+
+                if ( cursor - chunk.m_begin >= ( int64_t ) c_chunkSize )
+                {
+                    chunk.m_end = cursor;
+                    o_chunks.push_back( chunk );
+                    chunk.m_begin       = cursor;
+                    chunk.m_firstRecord = record;
+                }
+            }
+        }
+
+        if ( record > chunk.m_firstRecord || o_chunks.empty() )
+        {
+            chunk.m_end = cursor;
+            o_chunks.push_back( chunk );
+        }
+
+        return true;
+    }
+
+    // Parse the records of \p io_chunk, writing the vertices into \p io_meshData, and the triangles of the faces
+    // into \p io_chunk.
+    static inline void _ParseChunk( const _Header& i_header, TriangleMeshData& io_meshData, _Chunk& io_chunk )
+    {
+        bool swapBytes   = _IsHostBigEndian() != ( i_header.m_format == _Format::BinaryBigEndian );
+        int  vertexCount = io_meshData.m_positions.size();
+
+        _Record     record;
+        std::string line;
+        int         elementIndex = 0;
+        int64_t     recordIndex  = io_chunk.m_firstRecord;
+        const char* cursor       = io_chunk.m_begin;
+        while ( cursor < io_chunk.m_end && recordIndex < i_header.m_recordCount )
+        {
+            while ( recordIndex >= i_header.m_elements[ elementIndex ].m_firstRecord +
+                                       i_header.m_elements[ elementIndex ].m_count )
+            {
+                ++elementIndex;
+            }
+
+            const _Element& element      = i_header.m_elements[ elementIndex ];
+            int             listProperty = elementIndex == i_header.m_faceElement ? i_header.m_indexProperty : -1;
+            if ( i_header.m_format == _Format::ASCII )
+            {
+                // Parse a copy of the line, such that number parsing stops at its end.
+                const char* lineEnd = std::find( cursor, io_chunk.m_end, '\n' );
+                line.assign( cursor, lineEnd );
+                cursor = lineEnd == io_chunk.m_end ? lineEnd : lineEnd + 1;
+                if ( std::all_of( line.begin(), line.end(), _IsBlank ) )
+                {
+                    continue;
+                }
+
+                if ( !_ReadASCIIRecord( element, listProperty, line.c_str(), record ) )
+                {
+                    io_chunk.m_error = "Malformed record '" + line + "'";
+                    return;
+                }
+            }
+            else
+            {
+                _ReadBinaryRecord( element, listProperty, swapBytes, cursor, record );
+            }
+
+            if ( elementIndex == i_header.m_vertexElement )
+            {
+                _StoreVertex( i_header, record, recordIndex - element.m_firstRecord, io_meshData );
+            }
+            else if ( elementIndex == i_header.m_faceElement )
+            {
+                if ( record.m_list.size() < 3 )
+                {
+                    io_chunk.m_error = "Face with fewer than 3 vertices";
+                    return;
+                }
+                for ( int64_t vertexIndex : record.m_list )
+                {
+                    if ( vertexIndex < 0 || vertexIndex >= vertexCount )
+                    {
+                        io_chunk.m_error = "Face references a missing vertex";
+                        return;
+                    }
+                }
+
+                for ( size_t cornerIndex = 2; cornerIndex < record.m_list.size(); ++cornerIndex )
+                {
+                    io_chunk.m_indices.push_back( record.m_list[ 0 ] );
+                    io_chunk.m_indices.push_back( record.m_list[ cornerIndex - 1 ] );
+                    io_chunk.m_indices.push_back( record.m_list[ cornerIndex ] );
+                }
+            }
+
+            ++recordIndex;
+        }
+    }
+
+    // Write the attributes of the vertex \p i_vertexIndex, read as \p i_record, into \p io_meshData.
+    static inline void _StoreVertex( const _Header&    i_header,
+                                     const _Record&    i_record,
+                                     int64_t           i_vertexIndex,
+                                     TriangleMeshData& io_meshData )
+    {
+        const int* positionProperties            = i_header.m_positionProperties;
+        io_meshData.m_positions[ i_vertexIndex ] = gm::Vec3f( i_record.m_values[ positionProperties[ 0 ] ],
+                                                              i_record.m_values[ positionProperties[ 1 ] ],
+                                                              i_record.m_values[ positionProperties[ 2 ] ] );
+        if ( !io_meshData.m_normals.empty() )
+        {
+            const int* normalProperties            = i_header.m_normalProperties;
+            io_meshData.m_normals[ i_vertexIndex ] = gm::Vec3f( i_record.m_values[ normalProperties[ 0 ] ],
+                                                                i_record.m_values[ normalProperties[ 1 ] ],
+                                                                i_record.m_values[ normalProperties[ 2 ] ] );
+        }
+        if ( !io_meshData.m_uvs.empty() )
+        {
+            const int* uvProperties            = i_header.m_uvProperties;
+            io_meshData.m_uvs[ i_vertexIndex ] = gm::Vec2f( i_record.m_values[ uvProperties[ 0 ] ],
+                                                            i_record.m_values[ uvProperties[ 1 ] ] );
+        }
+    }
+
+    // Read a record of \p i_element from the line \p i_cursor.  Only the values of the list property
+    // \p i_listProperty are kept.
+    static inline bool
+    _ReadASCIIRecord( const _Element& i_element, int i_listProperty, const char* i_cursor, _Record& o_record )
+    {
+        o_record.m_values.resize( i_element.m_properties.size() );
+        o_record.m_list.clear();
+        for ( size_t propertyIndex = 0; propertyIndex < i_element.m_properties.size(); ++propertyIndex )
+        {
+            char*  end   = nullptr;
+            double value = std::strtod( i_cursor, &end );
+            if ( end == i_cursor )
+            {
+                return false;
+            }
+            i_cursor                           = end;
+            o_record.m_values[ propertyIndex ] = value;
+            if ( !i_element.m_properties[ propertyIndex ].m_isList )
+            {
+                continue;
+            }
+
+            if ( !( value >= 0.0 ) || value != std::floor( value ) )
+            {
+                return false;
+            }
+            for ( int64_t listIndex = 0; listIndex < ( int64_t ) value; ++listIndex )
+            {
+                double listValue = std::strtod( i_cursor, &end );
+                if ( end == i_cursor )
+                {
+                    return false;
+                }
+                i_cursor = end;
+                if ( ( int ) propertyIndex == i_listProperty )
+                {
+                    o_record.m_list.push_back( ( int64_t ) listValue );
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Read a binary record of \p i_element at \p io_cursor, which is known to be within the body.  Only the values
+    // of the list property \p i_listProperty are kept.
+    static inline void _ReadBinaryRecord( const _Element& i_element,
+                                          int             i_listProperty,
+                                          bool            i_swapBytes,
+                                          const char*&    io_cursor,
+                                          _Record&        o_record )
+    {
+        o_record.m_values.resize( i_element.m_properties.size() );
+        o_record.m_list.clear();
+        for ( size_t propertyIndex = 0; propertyIndex < i_element.m_properties.size(); ++propertyIndex )
+        {
+            const _Property& property = i_element.m_properties[ propertyIndex ];
+            if ( !property.m_isList )
+            {
+                o_record.m_values[ propertyIndex ] = _ReadBinaryScalar( property.m_type, i_swapBytes, io_cursor );
+                continue;
+            }
+
+            int64_t count = _ReadBinaryScalar( property.m_countType, i_swapBytes, io_cursor );
+            if ( ( int ) propertyIndex != i_listProperty )
+            {
+                io_cursor += count * _ScalarSize( property.m_type );
+                continue;
+            }
+            for ( int64_t listIndex = 0; listIndex < count; ++listIndex )
+            {
+                o_record.m_list.push_back( _ReadBinaryScalar( property.m_type, i_swapBytes, io_cursor ) );
+            }
+        }
+    }
+
+    // Skip over a binary record of \p i_element at \p io_cursor, checking that it ends before \p i_end.
+    static inline bool
+    _SkipBinaryRecord( const _Element& i_element, bool i_swapBytes, const char*& io_cursor, const char* i_end )
+    {
+        for ( const _Property& property : i_element.m_properties )
+        {
+            int64_t valueCount = 1;
+            if ( property.m_isList )
+            {
+                if ( _ScalarSize( property.m_countType ) > i_end - io_cursor )
+                {
+                    return false;
+                }
+
+                double count = _ReadBinaryScalar( property.m_countType, i_swapBytes, io_cursor );
+                if ( !( count >= 0.0 ) || count != std::floor( count ) )
+                {
+                    return false;
+                }
+                valueCount = count;
+            }
+
+            if ( valueCount * _ScalarSize( property.m_type ) > i_end - io_cursor )
+            {
+                return false;
+            }
+            io_cursor += valueCount * _ScalarSize( property.m_type );
+        }
+
+        return true;
+    }
+
+    // Read a binary value of type \p i_type at \p io_cursor, and advance past it.
+    static inline double _ReadBinaryScalar( _ScalarType i_type, bool i_swapBytes, const char*& io_cursor )
+    {
+        int  size = _ScalarSize( i_type );
+        char bytes[ 8 ];
+        std::memcpy( bytes, io_cursor, size );
+        io_cursor += size;
+        if ( i_swapBytes )
+        {
+            std::reverse( bytes, bytes + size );
+        }
+
+        switch ( i_type )
+        {
+        case _ScalarType::Int8:
+            return _FromBytes< int8_t >( bytes );
+        case _ScalarType::UInt8:
+            return _FromBytes< uint8_t >( bytes );
+        case _ScalarType::Int16:
+            return _FromBytes< int16_t >( bytes );
+        case _ScalarType::UInt16:
+            return _FromBytes< uint16_t >( bytes );
+        case _ScalarType::Int32:
+            return _FromBytes< int32_t >( bytes );
+        case _ScalarType::UInt32:
+            return _FromBytes< uint32_t >( bytes );
+        case _ScalarType::Float32:
+            return _FromBytes< float >( bytes );
+        default:
+            return _FromBytes< double >( bytes );
+        }
+    }
+
+    // Reinterpret \p i_bytes, in host byte order, as a value of type \p ValueT.
+    template < typename ValueT >
+    static inline ValueT _FromBytes( const char* i_bytes )
+    {
+        ValueT value;
+        std::memcpy( &value, i_bytes, sizeof( ValueT ) );
+        return value;
+    }
+
+    // Check if the host stores values with the most significant byte first.
+    static inline bool _IsHostBigEndian()
+    {
+        const uint16_t value = 1;
+        char           firstByte;
+        std::memcpy( &firstByte, &value, 1 );
+        return firstByte == 0;
+    }
+
+    // Check if \p i_character is white space within a line.
+    static inline bool _IsBlank( char i_character )
+    {
+        return i_character == ' ' || i_character == '\t' || i_character == '\r';
+    }
+
+    TileRenderer m_chunkRenderer;
+};
+
+/// Read the triangles of the Stanford PLY file at file location \p i_filePath into \p o_meshData.
+///
+/// The file is read into memory at once, then parsed in parallel, see \ref PLYParser.
+///
+/// \param i_filePath file location of the PLY file.
+/// \param o_meshData the mesh buffers to read into.
+/// \param i_threadCount The number of threads to parse with.  Zero uses all the hardware threads.
+///
+/// \return success of reading the mesh.
+inline bool ReadPLYMesh( const std::string& i_filePath, TriangleMeshData& o_meshData, int i_threadCount = 0 )
+{
+    std::string contents;
+    if ( !ReadMeshFile( i_filePath, contents ) )
+    {
+        return false;
+    }
+
+    std::string error;
+    if ( !PLYParser( i_threadCount ).Parse( contents, o_meshData, error ) )
+    {
+        fprintf( stderr, "%s in mesh '%s'!\n", error.c_str(), i_filePath.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,284 @@
+#pragma once
+
+/// \file raytrace/pngImageWriter.h
+///
+/// Serialization of an image into a PNG file on disk.
+///
+/// Reference: "Portable Network Graphics (PNG) Specification (Second Edition)".
+
+#include <raytrace/deflateEncoder.h>
+#include <raytrace/imageBuffer.h>
+#include <raytrace/quantizeColorChannel.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/tileRenderer.h>
+
+#include <gm/types/vec3f.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class PNGEncoder
+///
+/// PNGEncoder encodes an image into the contents of an 8-bit RGB PNG file.
+///
+/// Encoding runs in parallel across bands of rows.  Each row is filtered with the PNG filter type which minimizes
+/// the sum of its absolute filtered values, a common heuristic for its compressibility.  Each band is then
+/// compressed as an independent segment of the zlib stream, see \ref DeflateEncoder.
+class PNGEncoder
+{
+public:
+    /// Explicit constructor with the number of threads to encode with.
+    ///
+    /// \param i_threadCount The number of threads to encode with.  Zero uses all the hardware threads.
+    inline explicit PNGEncoder( int i_threadCount = 0 )
+        : m_bandRenderer( i_threadCount, c_rowsPerBand )
+    {
+    }
+
+    /// Encode the image \p i_image into the contents of a PNG file.
+    ///
+    /// \param i_image the image buffer to encode, with color values within [0,1].
+    ///
+    /// \return The PNG file contents.
+    inline std::vector< uint8_t > Encode( const RGBImageBuffer& i_image ) const
+    {
+        int    width     = i_image.Width();
+        int    height    = i_image.Height();
+        size_t rowSize   = ( size_t ) width * c_pixelSize;
+        int    bandCount = ( height + c_rowsPerBand - 1 ) / c_rowsPerBand;
+
+        // Quantize the image into rows of bytes, from the top row down.
+        std::vector< uint8_t > pixels( rowSize * height );
+        m_bandRenderer.ForEachRowBand( height, [&]( int i_beginRow, int i_endRow ) {
+            for ( int row = i_beginRow; row < i_endRow; ++row )
+            {
+                int      yCoord = height - 1 - row;
+                uint8_t* output = pixels.data() + row * rowSize;
+                for ( int xCoord = 0; xCoord < width; ++xCoord )
+                {
+                    const gm::Vec3f& pixel = i_image( xCoord, yCoord );
+                    *output++              = QuantizeColorChannel( pixel[ 0 ] );
+                    *output++              = QuantizeColorChannel( pixel[ 1 ] );
+                    *output++              = QuantizeColorChannel( pixel[ 2 ] );
+                }
+            }
+        } );
+
+        // Filter each row, then compress each band of filtered rows.  Rows are filtered against the quantized
+        // rows above them, so the bands are independent.
+        std::vector< uint8_t >                filteredRows( ( rowSize + 1 ) * height );
+        std::vector< std::vector< uint8_t > > compressedBands( bandCount );
+        std::vector< uint8_t >                zeroRow( rowSize, 0 );
+        m_bandRenderer.ForEachRowBand( height, [&]( int i_beginRow, int i_endRow ) {
+            std::vector< uint8_t > candidate( rowSize );
+            for ( int row = i_beginRow; row < i_endRow; ++row )
+            {
+                // The row above the top row is zero.
+                const uint8_t* previousRow = row > 0 ? pixels.data() + ( row - 1 ) * rowSize : zeroRow.data();
+                _FilterRow( pixels.data() + row * rowSize,
+                            previousRow,
+                            rowSize,
+                            candidate,
+                            filteredRows.data() + row * ( rowSize + 1 ) );
+            }
+
+            const uint8_t* bandRows = filteredRows.data() + i_beginRow * ( rowSize + 1 );
+            DeflateEncoder::EncodeSegment( bandRows,
+                                           ( i_endRow - i_beginRow ) * ( rowSize + 1 ),
+                                           compressedBands[ i_beginRow / c_rowsPerBand ] );
+        } );
+
+        // Assemble the zlib stream.  CMF: DEFLATE with a 32K window.  FLG: fast compression, with check bits.
+        std::vector< uint8_t > imageData = {0x78, 0x01};
+        for ( const std::vector< uint8_t >& compressedBand : compressedBands )
+        {
+            imageData.insert( imageData.end(), compressedBand.begin(), compressedBand.end() );
+        }
+        DeflateEncoder::FinishStream( imageData );
+        _AppendUInt32( DeflateEncoder::Adler32( filteredRows.data(), filteredRows.size() ), imageData );
+
+        // Assemble the file: signature, header, image data and end chunks.
+        std::vector< uint8_t > file = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+        std::vector< uint8_t > header;
+        _AppendUInt32( width, header );
+        _AppendUInt32( height, header );
+        header.push_back( 8 ); // Bit depth.
+        header.push_back( 2 ); // Color type: RGB.
+        header.push_back( 0 ); // Compression method: DEFLATE.
+        header.push_back( 0 ); // Filter method: adaptive.
+        header.push_back( 0 ); // Interlace method: none.
+        _AppendChunk( "IHDR", header, file );
+        _AppendChunk( "IDAT", imageData, file );
+        _AppendChunk( "IEND", std::vector< uint8_t >(), file );
+
+        return file;
+    }
+
+private:
+    // The number of rows compressed together.  Larger bands find more matches, smaller bands balance better
+    // across threads.
+    static constexpr int c_rowsPerBand = 32;
+
+    // The number of bytes per pixel.
+    static constexpr size_t c_pixelSize = 3;
+
+    // Filter the row \p i_row of \p i_rowSize bytes, against the row above it \p i_previousRow, and write the
+    // filter type followed by the filtered bytes into \p o_filteredRow.  \p io_candidate is scratch space for the
+    // filtered bytes of each filter type.
+    static inline void _FilterRow( const uint8_t*          i_row,
+                                   const uint8_t*          i_previousRow,
+                                   size_t                  i_rowSize,
+                                   std::vector< uint8_t >& io_candidate,
+                                   uint8_t*                o_filteredRow )
+    {
+        uint64_t bestCost  = UINT64_MAX;
+        auto     tryFilter = [&]( uint8_t i_filterType, auto i_predictor ) {
+            uint64_t cost = _ApplyFilter( i_row, i_previousRow, i_rowSize, i_predictor, io_candidate.data() );
+            if ( cost < bestCost )
+            {
+                bestCost           = cost;
+                o_filteredRow[ 0 ] = i_filterType;
+                std::copy( io_candidate.begin(), io_candidate.end(), o_filteredRow + 1 );
+            }
+        };
+
+        tryFilter( 0, []( int, int, int ) { return 0; } );                                 // None.
+        tryFilter( 1, []( int i_left, int, int ) { return i_left; } );                     // Sub.
+        tryFilter( 2, []( int, int i_up, int ) { return i_up; } );                         // Up.
+        tryFilter( 3, []( int i_left, int i_up, int ) { return ( i_left + i_up ) / 2; } ); // Average.
+        tryFilter( 4, _PaethPredictor );                                                   // Paeth.
+    }
+
+    // Filter the row \p i_row into \p o_filteredRow, by subtracting the prediction of each byte from its left, up
+    // and upper left neighbours.  Returns the sum of the absolute filtered values.
+    template < typename PredictorT >
+    static inline uint64_t _ApplyFilter( const uint8_t* i_row,
+                                         const uint8_t* i_previousRow,
+                                         size_t         i_rowSize,
+                                         PredictorT     i_predictor,
+                                         uint8_t*       o_filteredRow )
+    {
+        uint64_t cost = 0;
+        for ( size_t byteIndex = 0; byteIndex < i_rowSize; ++byteIndex )
+        {
+            // The neighbours to the left of the first pixel are zero.
+            bool hasLeft   = byteIndex >= c_pixelSize;
+            int  left      = hasLeft ? i_row[ byteIndex - c_pixelSize ] : 0;
+            int  upLeft    = hasLeft ? i_previousRow[ byteIndex - c_pixelSize ] : 0;
+            int  predicted = i_predictor( left, i_previousRow[ byteIndex ], upLeft );
+
+            uint8_t filtered           = ( uint8_t )( i_row[ byteIndex ] - predicted );
+            o_filteredRow[ byteIndex ] = filtered;
+            cost += std::abs( ( int8_t ) filtered );
+        }
+        return cost;
+    }
+
+    // Predict a byte from its left, up, and upper left neighbours, whichever is closest to left + up - upLeft.
+    static inline int _PaethPredictor( int i_left, int i_up, int i_upLeft )
+    {
+        int estimate       = i_left + i_up - i_upLeft;
+        int leftDistance   = std::abs( estimate - i_left );
+        int upDistance     = std::abs( estimate - i_up );
+        int upLeftDistance = std::abs( estimate - i_upLeft );
+        if ( leftDistance <= upDistance && leftDistance <= upLeftDistance )
+        {
+            return i_left;
+        }
+        else if ( upDistance <= upLeftDistance )
+        {
+            return i_up;
+        }
+        else
+        {
+            return i_upLeft;
+        }
+    }
+
+    // Append a chunk of type \p i_type, with the contents \p i_data, to \p io_file.
+    static inline void
+    _AppendChunk( const char* i_type, const std::vector< uint8_t >& i_data, std::vector< uint8_t >& io_file )
+    {
+        _AppendUInt32( ( uint32_t ) i_data.size(), io_file );
+        size_t typeOffset = io_file.size();
+        io_file.insert( io_file.end(), i_type, i_type + 4 );
+        io_file.insert( io_file.end(), i_data.begin(), i_data.end() );
+        _AppendUInt32( _CRC32( io_file.data() + typeOffset, io_file.size() - typeOffset ), io_file );
+    }
+
+    // Append \p i_value to \p io_output, in big endian byte order.
+    static inline void _AppendUInt32( uint32_t i_value, std::vector< uint8_t >& io_output )
+    {
+        for ( int shift = 24; shift >= 0; shift -= 8 )
+        {
+            io_output.push_back( ( uint8_t )( i_value >> shift ) );
+        }
+    }
+
+    // Compute the CRC-32 of \p i_size bytes of \p i_data.
+    static inline uint32_t _CRC32( const uint8_t* i_data, size_t i_size )
+    {
+        static const std::vector< uint32_t > table = []() {
+            std::vector< uint32_t > entries( 256 );
+            for ( uint32_t entryIndex = 0; entryIndex < 256; ++entryIndex )
+            {
+                uint32_t entry = entryIndex;
+                for ( int bitIndex = 0; bitIndex < 8; ++bitIndex )
+                {
+                    entry = ( entry & 1 ) ? 0xedb88320u ^ ( entry >> 1 ) : entry >> 1;
+                }
+                entries[ entryIndex ] = entry;
+            }
+            return entries;
+        }();
+
+        uint32_t crc = 0xffffffffu;
+        for ( size_t byteIndex = 0; byteIndex < i_size; ++byteIndex )
+        {
+            crc = table[ ( crc ^ i_data[ byteIndex ] ) & 0xff ] ^ ( crc >> 8 );
+        }
+        return crc ^ 0xffffffffu;
+    }
+
+    TileRenderer m_bandRenderer;
+};
+
+/// Write the image \p i_image into file location \p i_filePath, as an 8-bit RGB PNG.
+///
+/// The image is encoded in parallel into a single buffer, see \ref PNGEncoder, which is then written out at once.
+///
+/// \param i_image the image buffer to write, with color values within [0,1].
+/// \param i_filePath file location to save the PNG image.
+/// \param i_threadCount The number of threads to encode with.  Zero uses all the hardware threads.
+///
+/// \return success of writing the image.
+inline bool WritePNGImage( const RGBImageBuffer& i_image, const std::string& i_filePath, int i_threadCount = 0 )
+{
+    std::ofstream fileOutput( i_filePath.c_str(), std::ios::out | std::ios::trunc | std::ios::binary );
+    if ( !fileOutput.is_open() )
+    {
+        fprintf( stderr, "Cannot open file '%s' for writing!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    std::vector< uint8_t > file = PNGEncoder( i_threadCount ).Encode( i_image );
+    fileOutput.write( reinterpret_cast< const char* >( file.data() ), file.size() );
+    fileOutput.close();
+    if ( !fileOutput )
+    {
+        fprintf( stderr, "Failed to write image '%s'!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+RAYTRACE_NS_CLOSE
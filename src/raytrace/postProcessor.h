@@ -0,0 +1,232 @@
+#pragma once
+
+/// \file raytrace/postProcessor.h
+///
+/// Conversion of the linear radiance of a render into displayable colors.
+///
+/// The conversion is vectorized with SSE instructions when available, otherwise a scalar implementation is used.
+
+#include <raytrace/imageBuffer.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/renderSettings.h>
+
+#include <gm/types/vec3f.h>
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+RAYTRACE_NS_OPEN
+
+/// \class PostProcessor
+///
+/// PostProcessor grades an image of linear radiance into displayable colors within [0,1], by applying, in order:
+/// - An exposure adjustment, in stops.
+/// - A tone mapping curve, compressing high dynamic range radiance.
+/// - Gamma correction, by raising to 1/gamma.
+///
+/// The radiance of a render is kept separate from its graded image, so the grade can be changed without
+/// rendering again.
+///
+/// Each color channel is graded independently, so the image is processed as a flat array of floats, 4 at a
+/// time.
+class PostProcessor
+{
+public:
+    /// \enum ToneMapping
+    ///
+    /// The tone mapping curves.
+    enum class ToneMapping
+    {
+        None,     ///< Radiance is clamped to [0,1].
+        Reinhard, ///< x / (1 + x).
+        ACES      ///< Narkowicz's fit of the ACES filmic curve.
+    };
+
+    /// Explicit constructor with the grading parameters.
+    ///
+    /// \param i_exposure The exposure adjustment, in stops.
+    /// \param i_toneMapping The tone mapping curve.
+    /// \param i_gamma The gamma of the display.
+    inline explicit PostProcessor( float i_exposure, ToneMapping i_toneMapping, float i_gamma )
+        : m_exposureScale( std::exp2( i_exposure ) )
+        , m_toneMapping( i_toneMapping )
+        , m_gamma( i_gamma )
+    {
+    }
+
+    /// Grade the linear radiance \p i_radiance into displayable colors.
+    ///
+    /// \param i_radiance The linear radiance of each pixel.
+    /// \param o_image The image buffer to write the graded colors into.  Resized to match \p i_radiance.
+    inline void Apply( const RGBImageBuffer& i_radiance, RGBImageBuffer& o_image ) const
+    {
+        static_assert( sizeof( gm::Vec3f ) == 3 * sizeof( float ), "Vec3f must be tightly packed." );
+
+        o_image.Resize( i_radiance.Width(), i_radiance.Height() );
+        const float* input  = reinterpret_cast< const float* >( i_radiance.Data() );
+        float*       output = reinterpret_cast< float* >( o_image.Data() );
+        size_t       count  = ( size_t ) i_radiance.Width() * i_radiance.Height() * 3;
+
+        // Select the tone mapping curve once, outside of the per-value loop.
+        switch ( m_toneMapping )
+        {
+        case ToneMapping::None:
+            _Apply< _NoToneMapping >( input, output, count );
+            break;
+        case ToneMapping::Reinhard:
+            _Apply< _ReinhardToneMapping >( input, output, count );
+            break;
+        case ToneMapping::ACES:
+            _Apply< _ACESToneMapping >( input, output, count );
+            break;
+        }
+    }
+
+private:
+    // Grade \p i_count values of \p i_input into \p o_output, with the tone mapping curve \p ToneMappingT.
+    template < typename ToneMappingT >
+    inline void _Apply( const float* i_input, float* o_output, size_t i_count ) const
+    {
+        // Gamma 2 is the common case, and has a vectorized square root.
+        bool  isSquareRoot = m_gamma == 2.0f;
+        float inverseGamma = 1.0f / m_gamma;
+
+        size_t index = 0;
+#if defined( __SSE2__ )
+        __m128 exposureScale = _mm_set1_ps( m_exposureScale );
+        __m128 zero          = _mm_setzero_ps();
+        __m128 one           = _mm_set1_ps( 1.0f );
+        for ( ; index + 4 <= i_count; index += 4 )
+        {
+            // The clamped value is passed as the second operand of max, such that NaN becomes zero.
+            __m128 value = ToneMappingT::Apply( _mm_mul_ps( _mm_loadu_ps( i_input + index ), exposureScale ) );
+            value        = _mm_max_ps( value, zero );
+            if ( isSquareRoot )
+            {
+                value = _mm_sqrt_ps( value );
+            }
+            else
+            {
+                alignas( 16 ) float lanes[ 4 ];
+                _mm_store_ps( lanes, value );
+                for ( float& lane : lanes )
+                {
+                    lane = std::pow( lane, inverseGamma );
+                }
+                value = _mm_load_ps( lanes );
+            }
+
+            _mm_storeu_ps( o_output + index, _mm_min_ps( value, one ) );
+        }
+#endif
+
+        for ( ; index < i_count; ++index )
+        {
+            float value = ToneMappingT::Apply( i_input[ index ] * m_exposureScale );
+            value       = value > 0.0f ? value : 0.0f;
+            value       = isSquareRoot ? std::sqrt( value ) : std::pow( value, inverseGamma );
+
+            o_output[ index ] = value < 1.0f ? value : 1.0f;
+        }
+    }
+
+    // Tone mapping curves, each applied to a single value, or to 4 values at once.
+    struct _NoToneMapping
+    {
+        static inline float Apply( float i_value )
+        {
+            return i_value;
+        }
+
+#if defined( __SSE2__ )
+        static inline __m128 Apply( __m128 i_value )
+        {
+            return i_value;
+        }
+#endif
+    };
+
+    struct _ReinhardToneMapping
+    {
+        static inline float Apply( float i_value )
+        {
+            return i_value / ( 1.0f + i_value );
+        }
+
+#if defined( __SSE2__ )
+        static inline __m128 Apply( __m128 i_value )
+        {
+            return _mm_div_ps( i_value, _mm_add_ps( _mm_set1_ps( 1.0f ), i_value ) );
+        }
+#endif
+    };
+
+    // Reference: K. Narkowicz, "ACES Filmic Tone Mapping Curve".
+    struct _ACESToneMapping
+    {
+        static inline float Apply( float i_value )
+        {
+            return ( i_value * ( 2.51f * i_value + 0.03f ) ) / ( i_value * ( 2.43f * i_value + 0.59f ) + 0.14f );
+        }
+
+#if defined( __SSE2__ )
+        static inline __m128 Apply( __m128 i_value )
+        {
+            __m128 numerator   = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( 2.51f ), i_value ), _mm_set1_ps( 0.03f ) );
+            __m128 denominator = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( 2.43f ), i_value ), _mm_set1_ps( 0.59f ) );
+            numerator          = _mm_mul_ps( i_value, numerator );
+            denominator        = _mm_add_ps( _mm_mul_ps( i_value, denominator ), _mm_set1_ps( 0.14f ) );
+            return _mm_div_ps( numerator, denominator );
+        }
+#endif
+    };
+
+    float       m_exposureScale = 1.0f;
+    ToneMapping m_toneMapping   = ToneMapping::None;
+    float       m_gamma         = 2.0f;
+};
+
+/// \typedef PostProcessorPtr
+///
+/// Unique pointer to a post processor.
+using PostProcessorPtr = std::unique_ptr< PostProcessor >;
+
+/// Create the post processor described by \p i_settings.
+///
+/// Supported values of \ref RenderSettings::m_toneMapping are "none", "reinhard" and "aces".
+///
+/// \param i_settings The render settings.
+///
+/// \return The post processor, or null if the tone mapping curve is not recognized.
+inline PostProcessorPtr CreatePostProcessor( const RenderSettings& i_settings )
+{
+    PostProcessor::ToneMapping toneMapping;
+    if ( i_settings.m_toneMapping == "none" )
+    {
+        toneMapping = PostProcessor::ToneMapping::None;
+    }
+    else if ( i_settings.m_toneMapping == "reinhard" )
+    {
+        toneMapping = PostProcessor::ToneMapping::Reinhard;
+    }
+    else if ( i_settings.m_toneMapping == "aces" )
+    {
+        toneMapping = PostProcessor::ToneMapping::ACES;
+    }
+    else
+    {
+        std::cerr << "Unrecognized tone mapping: " << i_settings.m_toneMapping << std::endl;
+        return nullptr;
+    }
+
+    return PostProcessorPtr( new PostProcessor( i_settings.m_exposure, toneMapping, i_settings.m_gamma ) );
+}
+
+RAYTRACE_NS_CLOSE
@@ -2,48 +2,80 @@
 
 /// \file raytrace/ppmImageWriter.h
 ///
-/// Serialization of an image into a PPM file on disk.
-
-#include <gm/types/intRange.h>
+/// Serialization of an image into a binary PPM file on disk.
 
 #include <raytrace/imageBuffer.h>
+#include <raytrace/quantizeColorChannel.h>
 #include <raytrace/raytrace.h>
+#include <raytrace/tileRenderer.h>
+
+#include <gm/types/vec3f.h>
 
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
-#include <iostream>
+#include <string>
+#include <vector>
 
 RAYTRACE_NS_OPEN
 
-/// A simple function for writing an image \p i_image into file location \p i_filePath.
+/// Compose the header of a binary PPM file: the binary encoding, dimensions, and maximum color channel value.
+///
+/// \param i_width width of the image.
+/// \param i_height height of the image.
+///
+/// \return The header.
+inline std::string PPMHeader( int i_width, int i_height )
+{
+    return "P6\n" + std::to_string( i_width ) + ' ' + std::to_string( i_height ) + "\n255\n";
+}
+
+/// A simple function for writing an image \p i_image into file location \p i_filePath, as a binary (P6) PPM.
+///
+/// The rows are encoded in parallel into a single buffer, which is then written out at once.
 ///
-/// \param i_image the image buffer to write.
+/// \param i_image the image buffer to write, with color values within [0,1].
 /// \param i_filePath file location to save the PPM image.
+/// \param i_threadCount The number of threads to encode with.  Zero uses all the hardware threads.
 ///
 /// \return success of writing the image.
-inline bool WritePPMImage( const RGBImageBuffer& i_image, const std::string& i_filePath )
+inline bool WritePPMImage( const RGBImageBuffer& i_image, const std::string& i_filePath, int i_threadCount = 0 )
 {
-    std::ofstream fileOutput( i_filePath.c_str(), std::ios::out | std::ios::trunc );
+    std::ofstream fileOutput( i_filePath.c_str(), std::ios::out | std::ios::trunc | std::ios::binary );
     if ( !fileOutput.is_open() )
     {
         fprintf( stderr, "Cannot open file '%s' for writing!\n", i_filePath.c_str() );
         return false;
     }
 
-    // PPM header.
-    fileOutput << "P3\n"                                                   // Ascii encoding.
-               << i_image.Width() << ' ' << i_image.Height() << "\n255\n"; // Maximum color channel value.
+    std::string header = PPMHeader( i_image.Width(), i_image.Height() );
 
-    // PPM body.
-    for ( int yCoord = i_image.Height() - 1; yCoord >= 0; yCoord-- )
-    {
-        for ( int xCoord : gm::IntRange( 0, i_image.Width() ) )
+    // PPM body, from the top row down.
+    size_t                 rowSize = ( size_t ) i_image.Width() * 3;
+    std::vector< uint8_t > body( rowSize * i_image.Height() );
+    TileRenderer           bandRenderer( i_threadCount, /* tileSize */ 64 );
+    bandRenderer.ForEachRowBand( i_image.Height(), [&]( int i_beginRow, int i_endRow ) {
+        for ( int row = i_beginRow; row < i_endRow; ++row )
         {
-            gm::Vec3f pixel = i_image( xCoord, yCoord );
-            int       r     = static_cast< int >( 255.999 * pixel[ 0 ] );
-            int       g     = static_cast< int >( 255.999 * pixel[ 1 ] );
-            int       b     = static_cast< int >( 255.999 * pixel[ 2 ] );
-            fileOutput << r << ' ' << g << ' ' << b << '\n';
+            int      yCoord = i_image.Height() - 1 - row;
+            uint8_t* output = body.data() + row * rowSize;
+            for ( int xCoord = 0; xCoord < i_image.Width(); ++xCoord )
+            {
+                const gm::Vec3f& pixel = i_image( xCoord, yCoord );
+                *output++              = QuantizeColorChannel( pixel[ 0 ] );
+                *output++              = QuantizeColorChannel( pixel[ 1 ] );
+                *output++              = QuantizeColorChannel( pixel[ 2 ] );
+            }
         }
+    } );
+
+    fileOutput.write( header.data(), header.size() );
+    fileOutput.write( reinterpret_cast< const char* >( body.data() ), body.size() );
+    fileOutput.close();
+    if ( !fileOutput )
+    {
+        fprintf( stderr, "Failed to write image '%s'!\n", i_filePath.c_str() );
+        return false;
     }
 
     return true;
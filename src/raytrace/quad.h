@@ -0,0 +1,157 @@
+#pragma once
+
+/// \file raytrace/quad.h
+///
+/// Representation of an arbitrarily oriented parallelogram.
+
+#include <raytrace/hitRecord.h>
+#include <raytrace/material.h>
+#include <raytrace/ray.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/functions/contains.h>
+#include <gm/functions/crossProduct.h>
+#include <gm/functions/dotProduct.h>
+#include <gm/functions/expand.h>
+#include <gm/functions/faceForward.h>
+#include <gm/functions/length.h>
+#include <gm/functions/normalize.h>
+
+#include <gm/types/vec2f.h>
+#include <gm/types/vec3f.h>
+#include <gm/types/vec3fRange.h>
+
+RAYTRACE_NS_OPEN
+
+/// \class Quad
+///
+/// Quad is a planar parallelogram described by a \em corner and two \em edges spanning from it.
+///
+/// It is the oriented counterpart of \ref AxisAlignedRect, for walls and area lights which are not perpendicular
+/// to a coordinate axis.  The quad has no inside: its normal faces the incident ray.
+class Quad : public SceneObject
+{
+public:
+    /// Construct a static quad.
+    ///
+    /// \param i_corner The position of one corner of the quad.
+    /// \param i_edgeU The first edge, from \p i_corner to the adjacent corner.
+    /// \param i_edgeV The second edge, from \p i_corner to the other adjacent corner.
+    /// \param i_material Optional material assigned to the quad.
+    inline explicit Quad( const gm::Vec3f&  i_corner,
+                          const gm::Vec3f&  i_edgeU,
+                          const gm::Vec3f&  i_edgeV,
+                          MaterialSharedPtr i_material = nullptr )
+        : m_corner( i_corner )
+        , m_edgeU( i_edgeU )
+        , m_edgeV( i_edgeV )
+        , m_material( i_material )
+    {
+        gm::Vec3f edgeNormal = gm::CrossProduct( m_edgeU, m_edgeV );
+        m_area               = gm::Length( edgeNormal );
+        m_normal             = gm::Normalize( edgeNormal );
+        m_planeOffset        = gm::DotProduct( m_normal, m_corner );
+        m_planeBasis         = edgeNormal / gm::DotProduct( edgeNormal, edgeNormal );
+    }
+
+    virtual inline bool
+    Hit( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const override
+    {
+        float     magnitude;
+        gm::Vec2f uv;
+        if ( !_Intersect( i_ray, i_magnitudeRange, magnitude, uv ) )
+        {
+            return false;
+        }
+
+        o_record.m_magnitude = magnitude;
+        o_record.m_uv        = uv;
+        o_record.m_material  = m_material.get();
+        o_record.m_object    = this;
+        return true;
+    }
+
+    virtual inline bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const override
+    {
+        float     magnitude;
+        gm::Vec2f uv;
+        return _Intersect( i_ray, i_magnitudeRange, magnitude, uv );
+    }
+
+    virtual inline void ComputeSurfaceInteraction( const raytrace::Ray& i_ray, HitRecord& io_record ) const override
+    {
+        // The texture coordinates are already computed by Hit, as the edge coordinates of the hit.
+        io_record.m_position = m_corner + m_edgeU * io_record.m_uv[ 0 ] + m_edgeV * io_record.m_uv[ 1 ];
+        io_record.m_normal   = gm::FaceForward( m_normal, -i_ray.Direction() );
+    }
+
+    virtual inline gm::Vec3fRange Extent( const std::vector< float >& i_times ) const override
+    {
+        gm::Vec3fRange extent( m_corner, m_corner );
+        extent = gm::Expand( extent, m_corner + m_edgeU );
+        extent = gm::Expand( extent, m_corner + m_edgeV );
+        extent = gm::Expand( extent, m_corner + m_edgeU + m_edgeV );
+
+        // Pad the extent, such that it is not degenerate along an axis the quad is perpendicular to.
+        return gm::Vec3fRange( extent.Min() - gm::Vec3f( c_extentPadding, c_extentPadding, c_extentPadding ),
+                               extent.Max() + gm::Vec3f( c_extentPadding, c_extentPadding, c_extentPadding ) );
+    }
+
+    virtual inline const Material* SurfaceMaterial() const override
+    {
+        return m_material.get();
+    }
+
+    virtual inline float Area( float i_time ) const override
+    {
+        return m_area;
+    }
+
+    virtual inline bool SampleSurface( const gm::Vec2f& i_sample, float i_time, HitRecord& o_record ) const override
+    {
+        o_record.m_position = m_corner + m_edgeU * i_sample[ 0 ] + m_edgeV * i_sample[ 1 ];
+        o_record.m_normal   = m_normal;
+        o_record.m_uv       = i_sample;
+        o_record.m_material = m_material.get();
+        o_record.m_object   = this;
+        return true;
+    }
+
+private:
+    // Half of the minimum thickness of the extent of the quad.
+    static constexpr float c_extentPadding = 0.0001f;
+
+    // Intersect \p i_ray with the plane of the quad, and check that the hit lies within the quad, and
+    // \p i_magnitudeRange.  The hit is expressed as coordinates \p o_uv along the two edges.
+    inline bool _Intersect( const raytrace::Ray&  i_ray,
+                            const gm::FloatRange& i_magnitudeRange,
+                            float&                o_magnitude,
+                            gm::Vec2f&            o_uv ) const
+    {
+        // A ray parallel to the plane produces an infinite or undefined magnitude, which is not contained.
+        o_magnitude = ( m_planeOffset - gm::DotProduct( m_normal, i_ray.Origin() ) ) /
+                      gm::DotProduct( m_normal, i_ray.Direction() );
+        if ( !gm::Contains( i_magnitudeRange, o_magnitude ) )
+        {
+            return false;
+        }
+
+        gm::Vec3f planarOffset = i_ray.Origin() + i_ray.Direction() * o_magnitude - m_corner;
+        o_uv = gm::Vec2f( gm::DotProduct( m_planeBasis, gm::CrossProduct( planarOffset, m_edgeV ) ),
+                          gm::DotProduct( m_planeBasis, gm::CrossProduct( m_edgeU, planarOffset ) ) );
+        return o_uv[ 0 ] >= 0.0f && o_uv[ 0 ] <= 1.0f && o_uv[ 1 ] >= 0.0f && o_uv[ 1 ] <= 1.0f;
+    }
+
+    gm::Vec3f         m_corner;
+    gm::Vec3f         m_edgeU;
+    gm::Vec3f         m_edgeV;
+    MaterialSharedPtr m_material;
+
+    // Derived from the edges, for intersection and sampling.
+    gm::Vec3f m_normal;
+    float     m_planeOffset = 0.0f;
+    gm::Vec3f m_planeBasis;
+    float     m_area = 0.0f;
+};
+
+RAYTRACE_NS_CLOSE
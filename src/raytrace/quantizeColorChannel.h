@@ -0,0 +1,23 @@
+#pragma once
+
+/// \file raytrace/quantizeColorChannel.h
+///
+/// Utility for quantizing a color channel into a byte.
+
+#include <raytrace/raytrace.h>
+
+#include <cstdint>
+
+RAYTRACE_NS_OPEN
+
+/// Quantize a displayable color channel value \p i_value into an 8-bit value.
+///
+/// \param i_value The color channel value, within [0,1].
+///
+/// \return The quantized value, within [0,255].
+inline uint8_t QuantizeColorChannel( float i_value )
+{
+    return static_cast< uint8_t >( 255.999 * i_value );
+}
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,157 @@
+#pragma once
+
+/// \file raytrace/randomNumberGenerator.h
+///
+/// Fast, seekable pseudo-random number generation for rendering.
+
+#include <raytrace/raytrace.h>
+
+#include <gm/types/floatRange.h>
+#include <gm/types/intRange.h>
+
+#include <algorithm>
+#include <cstdint>
+
+RAYTRACE_NS_OPEN
+
+/// \class RandomNumberGenerator
+///
+/// RandomNumberGenerator is a PCG32 pseudo-random number generator, with 16 bytes of state.
+///
+/// Each generator follows one of 2^63 independent sequences, and can be advanced along its sequence in
+/// logarithmic time.  Renders use this to give every (pixel, sample) pair its own deterministic block of
+/// numbers, indexed by dimension, via \ref ForSample.  The numbers drawn by a sample therefore do not depend
+/// on which thread renders it, nor on the order in which pixels are rendered, and parallel renders are
+/// bit-reproducible.
+///
+/// Reference: M.E. O'Neill, "PCG: A Family of Simple Fast Space-Efficient Statistically Good Algorithms for
+/// Random Number Generation".
+class RandomNumberGenerator
+{
+public:
+    /// The number of dimensions reserved for each sample, by \ref ForSample.
+    static constexpr uint64_t c_dimensionsPerSample = uint64_t( 1 ) << 16;
+
+    /// Explicit constructor with the sequence to follow.
+    ///
+    /// \param i_sequenceIndex The index of the sequence.
+    /// \param i_seed The seed, which selects the starting point within every sequence.
+    inline explicit RandomNumberGenerator( uint64_t i_sequenceIndex = 0, uint64_t i_seed = c_defaultSeed )
+    {
+        SetSequence( i_sequenceIndex, i_seed );
+    }
+
+    /// Create the generator for the numbers of a single pixel sample.
+    ///
+    /// \param i_pixelIndex The index of the pixel.
+    /// \param i_sampleIndex The index of the sample, within the pixel.
+    /// \param i_seed The seed of the render.
+    /// \param i_dimension The dimension of the first number to draw.
+    ///
+    /// \return The generator, positioned at dimension \p i_dimension of the sample.
+    static inline RandomNumberGenerator
+    ForSample( uint64_t i_pixelIndex, uint64_t i_sampleIndex, uint64_t i_seed = 0, uint64_t i_dimension = 0 )
+    {
+        RandomNumberGenerator generator( i_pixelIndex, c_defaultSeed ^ _Mix( i_seed ) );
+        generator.Advance( i_sampleIndex * c_dimensionsPerSample + i_dimension );
+        return generator;
+    }
+
+    /// Restart the generator, at the beginning of a sequence.
+    ///
+    /// \param i_sequenceIndex The index of the sequence.
+    /// \param i_seed The seed, which selects the starting point within every sequence.
+    inline void SetSequence( uint64_t i_sequenceIndex, uint64_t i_seed = c_defaultSeed )
+    {
+        m_state     = 0;
+        m_increment = ( i_sequenceIndex << 1 ) | 1;
+        UniformUInt32();
+        m_state += i_seed;
+        UniformUInt32();
+    }
+
+    /// Skip \p i_delta numbers ahead, in O(log( \p i_delta )) time.
+    ///
+    /// \param i_delta The number of numbers to skip.
+    inline void Advance( uint64_t i_delta )
+    {
+        // Compose the affine state transition with itself, by repeated squaring.
+        uint64_t multiplier         = c_multiplier;
+        uint64_t increment          = m_increment;
+        uint64_t composedMultiplier = 1;
+        uint64_t composedIncrement  = 0;
+        while ( i_delta > 0 )
+        {
+            if ( i_delta & 1 )
+            {
+                composedMultiplier *= multiplier;
+                composedIncrement = composedIncrement * multiplier + increment;
+            }
+            increment = ( multiplier + 1 ) * increment;
+            multiplier *= multiplier;
+            i_delta >>= 1;
+        }
+
+        m_state = composedMultiplier * m_state + composedIncrement;
+    }
+
+    /// Draw a uniformly distributed 32-bit unsigned integer.
+    inline uint32_t UniformUInt32()
+    {
+        uint64_t previousState = m_state;
+        m_state                = previousState * c_multiplier + m_increment;
+
+        // Permute the previous state, with a xorshift and random rotation.
+        uint32_t xorShifted = ( uint32_t )( ( ( previousState >> 18u ) ^ previousState ) >> 27u );
+        uint32_t rotation   = ( uint32_t )( previousState >> 59u );
+        return ( xorShifted >> rotation ) | ( xorShifted << ( ( ~rotation + 1u ) & 31 ) );
+    }
+
+    /// Draw a uniformly distributed float in [0, 1).
+    inline float UniformFloat()
+    {
+        // Use the upper 24 bits, which a float represents exactly.
+        return ( float ) ( UniformUInt32() >> 8 ) * c_floatScale;
+    }
+
+    /// Draw a uniformly distributed float within \p i_range.
+    ///
+    /// \param i_range The range to draw from.
+    inline float UniformFloat( const gm::FloatRange& i_range )
+    {
+        return i_range.Min() + UniformFloat() * ( i_range.Max() - i_range.Min() );
+    }
+
+    /// Draw a uniformly distributed integer in [\p i_range.Min(), \p i_range.Max()).
+    ///
+    /// \param i_range The range to draw from.
+    inline int UniformInt( const gm::IntRange& i_range )
+    {
+        uint32_t count = ( uint32_t ) std::max( i_range.Max() - i_range.Min(), 1 );
+        return i_range.Min() + ( int ) ( ( ( uint64_t ) UniformUInt32() * count ) >> 32 );
+    }
+
+private:
+    // PCG32 constants.
+    static constexpr uint64_t c_multiplier  = 0x5851f42d4c957f2dULL;
+    static constexpr uint64_t c_defaultSeed = 0x853c49e6748fea9bULL;
+
+    // 2^-24.
+    static constexpr float c_floatScale = 1.0f / 16777216.0f;
+
+    // Scramble the bits of \p i_value, such that nearby seeds select unrelated starting points.
+    static inline uint64_t _Mix( uint64_t i_value )
+    {
+        i_value ^= i_value >> 31;
+        i_value *= 0x7fb5d329728ea185ULL;
+        i_value ^= i_value >> 27;
+        i_value *= 0x81dadef4bc2dd44dULL;
+        i_value ^= i_value >> 33;
+        return i_value;
+    }
+
+    uint64_t m_state     = 0;
+    uint64_t m_increment = 1;
+};
+
+RAYTRACE_NS_CLOSE
@@ -10,20 +10,21 @@
 #include <raytrace/raytrace.h>
 
 #include <gm/base/constants.h>
-#include <gm/functions/randomNumber.h>
-#include <gm/types/floatRange.h>
+#include <gm/types/vec2f.h>
 #include <gm/types/vec3f.h>
 
 RAYTRACE_NS_OPEN
 
-/// Generate an random point in a unit disk.
+/// Generate an random point in a unit disk, from a uniformly distributed 2D sample.
+///
+/// \param i_sample The sample, in [0, 1)^2, which selects the angle and magnitude of the point.
 ///
 /// \return Random point in the unit disk.
-inline gm::Vec3f RandomPointInUnitDisk()
+inline gm::Vec3f RandomPointInUnitDisk( const gm::Vec2f& i_sample )
 {
     // Random angle & magnitude
-    float angle     = gm::RandomNumber( gm::FloatRange( 0.0f, 2.0f * gm::Pi ) );
-    float magnitude = gm::RandomNumber( gm::FloatRange( 0.0f, 1.0f ) );
+    float angle     = i_sample[ 0 ] * 2.0f * gm::Pi;
+    float magnitude = i_sample[ 1 ];
 
     // Compute the cosine and sine for the x & y coordinates based on the random angle,
     // scaled by the random magintude.
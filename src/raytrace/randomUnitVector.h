@@ -7,21 +7,22 @@
 #include <raytrace/raytrace.h>
 
 #include <gm/base/constants.h>
-#include <gm/functions/randomNumber.h>
-#include <gm/types/floatRange.h>
+#include <gm/types/vec2f.h>
 #include <gm/types/vec3f.h>
 
 RAYTRACE_NS_OPEN
 
-/// Compute a random 3D unit vector.
+/// Compute a random 3D unit vector, from a uniformly distributed 2D sample.
 ///
 /// TODO - write a proof for this.
 ///
+/// \param i_sample The sample, in [0, 1)^2, which selects the angle about and height along the Z axis.
+///
 /// \return Random unit vector.
-inline gm::Vec3f RandomUnitVector()
+inline gm::Vec3f RandomUnitVector( const gm::Vec2f& i_sample )
 {
-    float angle = gm::RandomNumber( gm::FloatRange( 0.0f, 2.0f * gm::Pi ) );
-    float z     = gm::RandomNumber( gm::FloatRange( -1.0f, 1.0f ) );
+    float angle = i_sample[ 0 ] * 2.0f * gm::Pi;
+    float z     = i_sample[ 1 ] * 2.0f - 1.0f;
     float r     = sqrt( 1.0f - z * z );
     return gm::Vec3f( r * cos( angle ), r * sin( angle ), z );
 }
@@ -0,0 +1,251 @@
+#pragma once
+
+/// \file raytrace/renderCheckpoint.h
+///
+/// Serialization of the per-pixel sample accumulation of a render, such that it can be resumed.
+///
+/// A checkpoint is a binary file, in native byte order, holding a header followed by the state of each pixel:
+///
+/// | Field            | Type         | Description                                               |
+/// |------------------|--------------|-----------------------------------------------------------|
+/// | magic            | char[ 4 ]    | "RTCK"                                                    |
+/// | version          | uint32       | \ref c_renderCheckpointVersion                            |
+/// | width, height    | int32        | Image dimensions                                          |
+/// | seed             | int32        | \ref RenderSettings::m_seed                               |
+/// | sampler          | uint32, char | Length and characters of \ref RenderSettings::m_sampler   |
+/// | samplesPerPixel  | int32        | \ref RenderSettings::m_samplesPerPixel                    |
+/// | rayBounceLimit   | int32        | \ref RenderSettings::m_rayBounceLimit                     |
+/// | rouletteDepth    | int32        | \ref RenderSettings::m_russianRouletteDepth               |
+/// | lightSampling    | int32        | \ref RenderSettings::m_lightSampling, as 0 or 1           |
+/// | pixels           | 24 bytes     | Per pixel, in row-major order: sample count (int32), mean |
+/// |                  |              | color (3 x float32), mean luminance, luminance M2 (float) |
+///
+/// The sample values of a pixel are a function of its sample index, so the sample count of a pixel also
+/// serves as the position of its sample stream.
+///
+/// The settings which change the estimate of a sample are recorded, such that a render is not resumed with a
+/// different estimator.  The samples per pixel may only grow a resumed render if the samples do not depend on it,
+/// which is not the case for the "stratified" sampler, whose strata are laid out over all the samples of a pixel.
+
+#include <raytrace/imageBuffer.h>
+#include <raytrace/pixelStatistics.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/renderSettings.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+RAYTRACE_NS_OPEN
+
+/// \var c_renderCheckpointVersion
+///
+/// The version of the checkpoint file format.
+constexpr uint32_t c_renderCheckpointVersion = 2;
+
+/// Write the pixel statistics \p i_statistics of a render into file location \p i_filePath.
+///
+/// The checkpoint is written to a temporary file first, then renamed over \p i_filePath, such that a process
+/// killed mid-write leaves the previous checkpoint intact.
+///
+/// \param i_statistics The per-pixel statistics accumulated so far.
+/// \param i_settings The settings of the render.
+/// \param i_filePath file location to save the checkpoint.
+///
+/// \return success of writing the checkpoint.
+inline bool WriteRenderCheckpoint( const ImageBuffer< PixelStatistics >& i_statistics,
+                                   const RenderSettings&                 i_settings,
+                                   const std::string&                    i_filePath )
+{
+    std::string   temporaryFilePath = i_filePath + ".tmp";
+    std::ofstream fileOutput( temporaryFilePath.c_str(), std::ios::out | std::ios::trunc | std::ios::binary );
+    if ( !fileOutput.is_open() )
+    {
+        fprintf( stderr, "Cannot open file '%s' for writing!\n", temporaryFilePath.c_str() );
+        return false;
+    }
+
+    auto writeValue = [&]( const auto& i_value ) {
+        fileOutput.write( reinterpret_cast< const char* >( &i_value ), sizeof( i_value ) );
+    };
+
+    // Header.
+    fileOutput.write( "RTCK", 4 );
+    writeValue( c_renderCheckpointVersion );
+    writeValue( ( int32_t ) i_statistics.Width() );
+    writeValue( ( int32_t ) i_statistics.Height() );
+    writeValue( ( int32_t ) i_settings.m_seed );
+    writeValue( ( uint32_t ) i_settings.m_sampler.size() );
+    fileOutput.write( i_settings.m_sampler.data(), i_settings.m_sampler.size() );
+    writeValue( ( int32_t ) i_settings.m_samplesPerPixel );
+    writeValue( ( int32_t ) i_settings.m_rayBounceLimit );
+    writeValue( ( int32_t ) i_settings.m_russianRouletteDepth );
+    writeValue( ( int32_t ) i_settings.m_lightSampling );
+
+    // Pixels.
+    for ( int yCoord = 0; yCoord < i_statistics.Height(); ++yCoord )
+    {
+        for ( int xCoord = 0; xCoord < i_statistics.Width(); ++xCoord )
+        {
+            const PixelStatistics& pixelStatistics = i_statistics( xCoord, yCoord );
+            writeValue( ( int32_t ) pixelStatistics.SampleCount() );
+            writeValue( pixelStatistics.Mean()[ 0 ] );
+            writeValue( pixelStatistics.Mean()[ 1 ] );
+            writeValue( pixelStatistics.Mean()[ 2 ] );
+            writeValue( pixelStatistics.MeanLuminance() );
+            writeValue( pixelStatistics.LuminanceM2() );
+        }
+    }
+
+    fileOutput.close();
+    if ( !fileOutput )
+    {
+        fprintf( stderr, "Failed to write checkpoint '%s'!\n", temporaryFilePath.c_str() );
+        return false;
+    }
+
+    if ( std::rename( temporaryFilePath.c_str(), i_filePath.c_str() ) != 0 )
+    {
+        fprintf( stderr,
+                 "Cannot rename checkpoint '%s' to '%s': %s!\n",
+                 temporaryFilePath.c_str(),
+                 i_filePath.c_str(),
+                 std::strerror( errno ) );
+        return false;
+    }
+
+    return true;
+}
+
+/// Read the pixel statistics of a render from the checkpoint at file location \p i_filePath.
+///
+/// The checkpoint must have been written by a render with the same image dimensions, seed, sampler, ray bounce
+/// limit, russian roulette depth and light sampling as \p i_settings, otherwise resuming from it would not
+/// reproduce an uninterrupted render.  For the "stratified" sampler, the samples per pixel must match too.
+///
+/// \param i_filePath file location of the checkpoint.
+/// \param i_settings The settings of the render to resume.
+/// \param o_statistics The per-pixel statistics, resized to the image dimensions.
+///
+/// \return success of reading the checkpoint.
+inline bool ReadRenderCheckpoint( const std::string&              i_filePath,
+                                  const RenderSettings&           i_settings,
+                                  ImageBuffer< PixelStatistics >& o_statistics )
+{
+    std::ifstream fileInput( i_filePath.c_str(), std::ios::in | std::ios::binary );
+    if ( !fileInput.is_open() )
+    {
+        fprintf( stderr, "Cannot open file '%s' for reading!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    auto readValue = [&]( auto& o_value ) {
+        fileInput.read( reinterpret_cast< char* >( &o_value ), sizeof( o_value ) );
+    };
+
+    // Header.
+    char     magic[ 4 ]    = {};
+    uint32_t version       = 0;
+    int32_t  width         = 0;
+    int32_t  height        = 0;
+    int32_t  seed          = 0;
+    uint32_t samplerLength = 0;
+    fileInput.read( magic, 4 );
+    readValue( version );
+    readValue( width );
+    readValue( height );
+    readValue( seed );
+    readValue( samplerLength );
+    if ( !fileInput || std::memcmp( magic, "RTCK", 4 ) != 0 || version != c_renderCheckpointVersion ||
+         samplerLength > 256 )
+    {
+        fprintf( stderr, "File '%s' is not a supported render checkpoint!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    std::string sampler( samplerLength, '\0' );
+    int32_t     samplesPerPixel      = 0;
+    int32_t     rayBounceLimit       = 0;
+    int32_t     russianRouletteDepth = 0;
+    int32_t     lightSampling        = 0;
+    fileInput.read( &sampler[ 0 ], samplerLength );
+    readValue( samplesPerPixel );
+    readValue( rayBounceLimit );
+    readValue( russianRouletteDepth );
+    readValue( lightSampling );
+    if ( !fileInput )
+    {
+        fprintf( stderr, "Checkpoint '%s' is truncated!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    if ( width != i_settings.m_imageWidth || height != i_settings.m_imageHeight || seed != i_settings.m_seed ||
+         sampler != i_settings.m_sampler )
+    {
+        fprintf( stderr,
+                 "Checkpoint '%s' was rendered at %dx%d with seed %d and sampler '%s', which do not match the "
+                 "current settings!\n",
+                 i_filePath.c_str(),
+                 width,
+                 height,
+                 seed,
+                 sampler.c_str() );
+        return false;
+    }
+
+    if ( rayBounceLimit != i_settings.m_rayBounceLimit || russianRouletteDepth != i_settings.m_russianRouletteDepth ||
+         ( lightSampling != 0 ) != i_settings.m_lightSampling )
+    {
+        fprintf( stderr,
+                 "Checkpoint '%s' was rendered with a ray bounce limit of %d, russian roulette depth of %d and light "
+                 "sampling %s, which do not match the current settings!\n",
+                 i_filePath.c_str(),
+                 rayBounceLimit,
+                 russianRouletteDepth,
+                 lightSampling != 0 ? "on" : "off" );
+        return false;
+    }
+
+    if ( sampler == "stratified" && samplesPerPixel != i_settings.m_samplesPerPixel )
+    {
+        fprintf( stderr,
+                 "Checkpoint '%s' was rendered with %d samples per pixel, which the strata of the stratified sampler "
+                 "depend on, and do not match the current settings!\n",
+                 i_filePath.c_str(),
+                 samplesPerPixel );
+        return false;
+    }
+
+    // Pixels.
+    o_statistics.Resize( width, height );
+    for ( int yCoord = 0; yCoord < height; ++yCoord )
+    {
+        for ( int xCoord = 0; xCoord < width; ++xCoord )
+        {
+            int32_t   sampleCount   = 0;
+            gm::Vec3f mean;
+            float     meanLuminance = 0.0f;
+            float     luminanceM2   = 0.0f;
+            readValue( sampleCount );
+            readValue( mean[ 0 ] );
+            readValue( mean[ 1 ] );
+            readValue( mean[ 2 ] );
+            readValue( meanLuminance );
+            readValue( luminanceM2 );
+            o_statistics( xCoord, yCoord ) = PixelStatistics( sampleCount, mean, meanLuminance, luminanceM2 );
+        }
+    }
+
+    if ( !fileInput )
+    {
+        fprintf( stderr, "Checkpoint '%s' is truncated!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+RAYTRACE_NS_CLOSE
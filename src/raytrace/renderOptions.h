@@ -0,0 +1,258 @@
+#pragma once
+
+/// \file raytrace/renderOptions.h
+///
+/// Command line options for configuring \ref RenderSettings.
+///
+/// This header depends on cxxopts, which must be linked by the consuming program.
+
+#include <raytrace/renderSettings.h>
+
+#include <cxxopts.hpp>
+
+#include <string>
+
+RAYTRACE_NS_OPEN
+
+/// Add the command line options shared by all the rendering programs to \p o_options.
+///
+/// \param i_defaults The settings providing the default value of each option.
+/// \param o_options The command line options to extend.
+inline void AddRenderOptions( const RenderSettings& i_defaults, cxxopts::Options& o_options )
+{
+    o_options.add_options()                              // Command line options.
+        ( "w,width",
+          "Width of the image.",
+          cxxopts::value< int >()->default_value( std::to_string( i_defaults.m_imageWidth ) ) ) // Width
+        ( "h,height",
+          "Height of the image.",
+          cxxopts::value< int >()->default_value( std::to_string( i_defaults.m_imageHeight ) ) ) // Height
+        ( "o,output",
+          "Output file.  The extension selects the format: ppm, png, or pfm (linear radiance).",
+          cxxopts::value< std::string >()->default_value( i_defaults.m_outputFilePath ) ) // Output file.
+        ( "streamOutput",
+          "Stream finished tiles to the output file while rendering.  Requires ppm or pfm output.",
+          cxxopts::value< bool >()->default_value( i_defaults.m_streamOutput ? "true" : "false" ) ) // Streaming.
+        ( "s,samplesPerPixel",
+          "Number of samples per-pixel.",
+          cxxopts::value< int >()->default_value( std::to_string( i_defaults.m_samplesPerPixel ) ) ) // Samples.
+        ( "adaptive",
+          "Adapt the number of samples of each pixel to its noise, up to samplesPerPixel.",
+          cxxopts::value< bool >()->default_value( i_defaults.m_adaptiveSampling ? "true" : "false" ) ) // Adaptive.
+        ( "minSamplesPerPixel",
+          "Minimum number of samples per-pixel, under adaptive sampling.",
+          cxxopts::value< int >()->default_value(
+              std::to_string( i_defaults.m_minSamplesPerPixel ) ) ) // Adaptive param.
+        ( "adaptiveThreshold",
+          "Relative error of a pixel, at 95% confidence, below which adaptive sampling stops sampling it.",
+          cxxopts::value< float >()->default_value(
+              std::to_string( i_defaults.m_adaptiveThreshold ) ) ) // Adaptive param.
+        ( "noiseTarget",
+          "Mean relative error of the image below which adaptive sampling stops the render.  Zero disables it.",
+          cxxopts::value< float >()->default_value( std::to_string( i_defaults.m_noiseTarget ) ) ) // Adaptive param.
+        ( "b,rayBounceLimit",
+          "Number of bounces possible for a ray until termination.",
+          cxxopts::value< int >()->default_value( std::to_string( i_defaults.m_rayBounceLimit ) ) ) // Bounces.
+        ( "r,russianRouletteDepth",
+          "Number of bounces before a ray may be randomly terminated, based on its contribution.",
+          cxxopts::value< int >()->default_value(
+              std::to_string( i_defaults.m_russianRouletteDepth ) ) ) // Russian roulette.
+        ( "lightSampling",
+          "Sample the lights of the scene directly at each bounce.  Disable with --lightSampling=false.",
+          cxxopts::value< bool >()->default_value( i_defaults.m_lightSampling ? "true" : "false" ) ) // Lights.
+        ( "progressive",
+          "Refine all the pixels together, pass by pass.",
+          cxxopts::value< bool >()->default_value( i_defaults.m_progressive ? "true" : "false" ) ) // Progressive.
+        ( "samplesPerPass",
+          "Number of samples per-pixel, in each pass of a progressive render.",
+          cxxopts::value< int >()->default_value(
+              std::to_string( i_defaults.m_samplesPerPass ) ) ) // Progressive param.
+        ( "timeBudget",
+          "Wall-clock seconds which the render may take.  Zero disables the budget.",
+          cxxopts::value< float >()->default_value(
+              std::to_string( i_defaults.m_timeBudget ) ) ) // Progressive param.
+        ( "deadline",
+          "Unix time, in seconds, by which the render must finish.  Zero disables the deadline.",
+          cxxopts::value< double >()->default_value(
+              std::to_string( i_defaults.m_deadline ) ) ) // Progressive param.
+        ( "snapshotInterval",
+          "Seconds between snapshots of the image written during the render.  Zero disables them.",
+          cxxopts::value< float >()->default_value(
+              std::to_string( i_defaults.m_snapshotInterval ) ) ) // Progressive param.
+        ( "snapshotPasses",
+          "Passes between snapshots of the image written during the render.  Zero disables them.",
+          cxxopts::value< int >()->default_value(
+              std::to_string( i_defaults.m_snapshotPassInterval ) ) ) // Progressive param.
+        ( "checkpoint",
+          "File path to checkpoint the render to.  Empty disables checkpoints.",
+          cxxopts::value< std::string >()->default_value( i_defaults.m_checkpointFilePath ) ) // Checkpoint.
+        ( "checkpointInterval",
+          "Seconds between checkpoints of the render.",
+          cxxopts::value< float >()->default_value(
+              std::to_string( i_defaults.m_checkpointInterval ) ) ) // Checkpoint param.
+        ( "resume",
+          "Resume the render from the checkpoint file.",
+          cxxopts::value< bool >()->default_value( i_defaults.m_resume ? "true" : "false" ) ) // Checkpoint param.
+        ( "exposure",
+          "Exposure adjustment of the image, in stops.",
+          cxxopts::value< float >()->default_value( std::to_string( i_defaults.m_exposure ) ) ) // Post-process.
+        ( "toneMapping",
+          "Tone mapping curve of the image.  One of: none, reinhard, aces.",
+          cxxopts::value< std::string >()->default_value( i_defaults.m_toneMapping ) ) // Post-process.
+        ( "gamma",
+          "Gamma of the display which the image is corrected for.",
+          cxxopts::value< float >()->default_value( std::to_string( i_defaults.m_gamma ) ) ) // Post-process.
+        ( "aovs",
+          "Comma separated AOVs to write.  Any of: albedo, normal, depth, objectId, sampleCount, "
+          "variance.",
+          cxxopts::value< std::string >()->default_value( i_defaults.m_aovs ) ) // AOVs.
+        ( "aovOutput",
+          "File path to write the AOVs to, as an OpenEXR image.",
+          cxxopts::value< std::string >()->default_value( i_defaults.m_aovFilePath ) ) // AOVs.
+        ( "aovSamplesPerPixel",
+          "Number of camera rays cast per pixel to gather the AOVs, up to the samples per pixel.",
+          cxxopts::value< int >()->default_value( std::to_string( i_defaults.m_aovSamplesPerPixel ) ) ) // AOVs.
+        ( "denoise",
+          "Remove the noise of the image, guided by its albedo, normal, depth and variance.",
+          cxxopts::value< bool >()->default_value( i_defaults.m_denoise ? "true" : "false" ) ) // Denoising.
+        ( "denoiseIterations",
+          "Number of iterations of the denoising filter.",
+          cxxopts::value< int >()->default_value( std::to_string( i_defaults.m_denoiseIterations ) ) ) // Denoising.
+        ( "denoiseColorSigma",
+          "Luminance difference, in standard deviations of the noise, over which pixels are averaged.",
+          cxxopts::value< float >()->default_value( std::to_string( i_defaults.m_denoiseColorSigma ) ) ) // Denoising.
+        ( "denoiseDepthSigma",
+          "Depth difference, relative to the depth of a pixel, over which pixels are averaged.",
+          cxxopts::value< float >()->default_value( std::to_string( i_defaults.m_denoiseDepthSigma ) ) ) // Denoising.
+        ( "reference",
+          "File path of a reference PFM image to print the relative mean squared error of the image against.",
+          cxxopts::value< std::string >()->default_value( i_defaults.m_referenceFilePath ) ) // Denoising.
+        ( "sampler",
+          "Type of sampler generating the values of each pixel sample.  One of: sobol, halton, stratified, "
+          "independent.",
+          cxxopts::value< std::string >()->default_value( i_defaults.m_sampler ) ) // Sampler.
+        ( "seed",
+          "Seed of the random numbers drawn by the samples.",
+          cxxopts::value< int >()->default_value( std::to_string( i_defaults.m_seed ) ) ) // Seed.
+        ( "bvh",
+          "Type of bounding volume hierarchy to build.  One of: bvh8, bvh4, linear, sah, motion, spatial, none.",
+          cxxopts::value< std::string >()->default_value( i_defaults.m_bvh ) ) // BVH type.
+        ( "bvhBuilder",
+          "Algorithm to build the bounding volume hierarchy with.  One of: sah, lbvh.",
+          cxxopts::value< std::string >()->default_value( i_defaults.m_bvhBuilder ) ) // BVH builder.
+        ( "bvhBinCount",
+          "Number of bins per axis, evaluated for splitting a SAH BVH node.",
+          cxxopts::value< int >()->default_value( std::to_string( i_defaults.m_bvhBinCount ) ) ) // BVH param.
+        ( "bvhLeafSize",
+          "Maximum number of objects in a BVH leaf.",
+          cxxopts::value< int >()->default_value( std::to_string( i_defaults.m_bvhLeafSize ) ) ) // BVH param.
+        ( "motionKeyframes",
+          "Number of keyframes which the extents of motion BVH nodes are sampled at.",
+          cxxopts::value< int >()->default_value(
+              std::to_string( i_defaults.m_motionKeyframeCount ) ) ) // Motion BVH param.
+        ( "t,threads",
+          "Number of threads to build the BVH and render with.  Zero uses all the hardware threads.",
+          cxxopts::value< int >()->default_value( std::to_string( i_defaults.m_threadCount ) ) ) // Threads.
+        ( "f,verticalFov",
+          "Vertical field of view of the camera, in degrees.",
+          cxxopts::value< float >()->default_value( std::to_string( i_defaults.m_verticalFov ) ) ) // Camera param.
+        ( "a,aperture",
+          "Aperture of the camera (lens diameter).",
+          cxxopts::value< float >()->default_value( std::to_string( i_defaults.m_aperture ) ) ) // Camera param.
+        ( "shutterOpen",
+          "The time when the shutter is open.",
+          cxxopts::value< float >()->default_value(
+              std::to_string( i_defaults.m_shutterRange.Min() ) ) ) // Motion blur param.
+        ( "shutterClose",
+          "The time when the shutter is closed.",
+          cxxopts::value< float >()->default_value(
+              std::to_string( i_defaults.m_shutterRange.Max() ) ) )                               // Motion blur param.
+        ( "d,debug", "Turn on debug mode.", cxxopts::value< bool >()->default_value( "false" ) ) // Debug mode.
+        ( "x,debugXCoord",
+          "The x-coordinate of the pixel in the image to print debug information for.",
+          cxxopts::value< int >()->default_value( "0" ) ) // Xcoord.
+        ( "y,debugYCoord",
+          "The y-coordinate of the pixel in the image to print debug information for.",
+          cxxopts::value< int >()->default_value( "0" ) ); // Ycoord.
+}
+
+/// Extract render settings from parsed command line arguments.
+///
+/// \pre \p i_args must be produced by options populated through \ref AddRenderOptions.
+///
+/// \param i_args The parsed command line arguments.
+///
+/// \return The render settings.
+inline RenderSettings ParseRenderOptions( const cxxopts::ParseResult& i_args )
+{
+    RenderSettings settings;
+
+    // Imaging options.
+    settings.m_imageWidth           = i_args[ "width" ].as< int >();
+    settings.m_imageHeight          = i_args[ "height" ].as< int >();
+    settings.m_samplesPerPixel      = i_args[ "samplesPerPixel" ].as< int >();
+    settings.m_adaptiveSampling     = i_args[ "adaptive" ].as< bool >();
+    settings.m_minSamplesPerPixel   = i_args[ "minSamplesPerPixel" ].as< int >();
+    settings.m_adaptiveThreshold    = i_args[ "adaptiveThreshold" ].as< float >();
+    settings.m_noiseTarget          = i_args[ "noiseTarget" ].as< float >();
+    settings.m_rayBounceLimit       = i_args[ "rayBounceLimit" ].as< int >();
+    settings.m_russianRouletteDepth = i_args[ "russianRouletteDepth" ].as< int >();
+    settings.m_lightSampling        = i_args[ "lightSampling" ].as< bool >();
+    settings.m_sampler              = i_args[ "sampler" ].as< std::string >();
+    settings.m_seed                 = i_args[ "seed" ].as< int >();
+    settings.m_outputFilePath       = i_args[ "output" ].as< std::string >();
+    settings.m_streamOutput         = i_args[ "streamOutput" ].as< bool >();
+
+    // Progressive rendering options.
+    settings.m_progressive          = i_args[ "progressive" ].as< bool >();
+    settings.m_samplesPerPass       = i_args[ "samplesPerPass" ].as< int >();
+    settings.m_timeBudget           = i_args[ "timeBudget" ].as< float >();
+    settings.m_deadline             = i_args[ "deadline" ].as< double >();
+    settings.m_snapshotInterval     = i_args[ "snapshotInterval" ].as< float >();
+    settings.m_snapshotPassInterval = i_args[ "snapshotPasses" ].as< int >();
+    settings.m_checkpointFilePath   = i_args[ "checkpoint" ].as< std::string >();
+    settings.m_checkpointInterval   = i_args[ "checkpointInterval" ].as< float >();
+    settings.m_resume               = i_args[ "resume" ].as< bool >();
+
+    // Post-processing options.
+    settings.m_exposure    = i_args[ "exposure" ].as< float >();
+    settings.m_toneMapping = i_args[ "toneMapping" ].as< std::string >();
+    settings.m_gamma       = i_args[ "gamma" ].as< float >();
+
+    // AOV options.
+    settings.m_aovs               = i_args[ "aovs" ].as< std::string >();
+    settings.m_aovFilePath        = i_args[ "aovOutput" ].as< std::string >();
+    settings.m_aovSamplesPerPixel = i_args[ "aovSamplesPerPixel" ].as< int >();
+
+    // Denoising options.
+    settings.m_denoise           = i_args[ "denoise" ].as< bool >();
+    settings.m_denoiseIterations = i_args[ "denoiseIterations" ].as< int >();
+    settings.m_denoiseColorSigma = i_args[ "denoiseColorSigma" ].as< float >();
+    settings.m_denoiseDepthSigma = i_args[ "denoiseDepthSigma" ].as< float >();
+    settings.m_referenceFilePath = i_args[ "reference" ].as< std::string >();
+
+    // Camera options.
+    settings.m_verticalFov  = i_args[ "verticalFov" ].as< float >();
+    settings.m_aperture     = i_args[ "aperture" ].as< float >();
+    settings.m_shutterRange = gm::FloatRange( i_args[ "shutterOpen" ].as< float >(),
+                                              i_args[ "shutterClose" ].as< float >() );
+
+    // Acceleration options.
+    settings.m_bvh                 = i_args[ "bvh" ].as< std::string >();
+    settings.m_bvhBuilder          = i_args[ "bvhBuilder" ].as< std::string >();
+    settings.m_bvhBinCount         = i_args[ "bvhBinCount" ].as< int >();
+    settings.m_bvhLeafSize         = i_args[ "bvhLeafSize" ].as< int >();
+    settings.m_motionKeyframeCount = i_args[ "motionKeyframes" ].as< int >();
+
+    // Performance options.
+    settings.m_threadCount = i_args[ "threads" ].as< int >();
+
+    // Debug options.
+    settings.m_debug      = i_args[ "debug" ].as< bool >();
+    settings.m_debugPixel = gm::Vec2i( i_args[ "debugXCoord" ].as< int >(),
+                                       settings.m_imageHeight - 1 - i_args[ "debugYCoord" ].as< int >() );
+
+    return settings;
+}
+
+RAYTRACE_NS_CLOSE
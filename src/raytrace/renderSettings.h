@@ -0,0 +1,221 @@
+#pragma once
+
+/// \file raytrace/renderSettings.h
+///
+/// Settings controlling how an image is rendered.
+
+#include <raytrace/raytrace.h>
+
+#include <gm/types/floatRange.h>
+#include <gm/types/vec2i.h>
+
+#include <string>
+
+RAYTRACE_NS_OPEN
+
+/// \class RenderSettings
+///
+/// RenderSettings is a collection of parameters describing the image to render, and how to render it.
+///
+/// The default values describe a small, moderately sampled image.  Programs will typically override
+/// a subset of these values, then expose all of them as command line options.
+/// \sa AddRenderOptions
+class RenderSettings
+{
+public:
+    //-------------------------------------------------------------------------
+    /// \name Imaging.
+    //-------------------------------------------------------------------------
+
+    /// Width of the image, in pixels.
+    int m_imageWidth = 384;
+
+    /// Height of the image, in pixels.
+    int m_imageHeight = 256;
+
+    /// The number of rays cast, per pixel.  Under adaptive sampling, the maximum number of rays cast per pixel.
+    int m_samplesPerPixel = 100;
+
+    /// Adapt the number of rays cast per pixel to its noise.  Adaptive renders are progressive.
+    /// \sa Renderer::RenderProgressive
+    bool m_adaptiveSampling = false;
+
+    /// Under adaptive sampling, the minimum number of rays cast per pixel.
+    int m_minSamplesPerPixel = 16;
+
+    /// Under adaptive sampling, the relative error below which a pixel stops being sampled.
+    /// \sa PixelStatistics::RelativeError
+    float m_adaptiveThreshold = 0.05f;
+
+    /// Under adaptive sampling, the mean relative error across the image below which the render stops.
+    /// Zero disables the target.
+    float m_noiseTarget = 0.0f;
+
+    /// The number of bounces a ray can perform before it is retired.
+    int m_rayBounceLimit = 50;
+
+    /// The number of bounces a ray performs before it becomes subject to russian roulette termination.
+    int m_russianRouletteDepth = 3;
+
+    /// Sample the lights of the scene directly at each bounce, rather than only reaching them by scattered rays.
+    /// \sa LightList
+    bool m_lightSampling = true;
+
+    /// The type of sampler which generates the values of each pixel sample.
+    /// \sa CreateSampler
+    std::string m_sampler = "sobol";
+
+    /// Seed of the random numbers drawn by the samples.  Renders with the same seed are identical, regardless
+    /// of the number of threads.
+    int m_seed = 0;
+
+    /// File path to write the rendered image to.  The extension selects the file format.
+    /// \sa CreateImageWriter
+    std::string m_outputFilePath = "out.ppm";
+
+    /// Stream finished tiles to the output file while rendering, instead of holding the whole image in memory.
+    /// Requires ppm or pfm output, and is not supported by progressive renders.
+    /// \sa Renderer::RenderStreaming
+    bool m_streamOutput = false;
+
+    //-------------------------------------------------------------------------
+    /// \name Progressive rendering.
+    //-------------------------------------------------------------------------
+
+    /// Refine all the pixels together, pass by pass.  Implied by adaptive sampling, a time budget, a deadline,
+    /// or snapshots.
+    /// \sa Renderer::RenderProgressive
+    bool m_progressive = false;
+
+    /// The number of rays cast per pixel, in each pass of a progressive render.
+    int m_samplesPerPass = 4;
+
+    /// The wall-clock time, in seconds, which a progressive render may take.  Zero disables the budget.
+    float m_timeBudget = 0.0f;
+
+    /// The wall-clock time, in seconds since the Unix epoch, by which a progressive render must finish.
+    /// Zero disables the deadline.
+    double m_deadline = 0.0;
+
+    /// The interval, in seconds, between snapshots of the image written during a progressive render.
+    /// Zero disables timed snapshots.
+    float m_snapshotInterval = 0.0f;
+
+    /// The number of passes between snapshots of the image written during a progressive render.
+    /// Zero disables per-pass snapshots.
+    int m_snapshotPassInterval = 0;
+
+    /// File path to checkpoint the per-pixel sample accumulation of a progressive render to.  Empty disables
+    /// checkpoints.
+    /// \sa WriteRenderCheckpoint
+    std::string m_checkpointFilePath;
+
+    /// The interval, in seconds, between checkpoints.  A checkpoint is also written once the render stops.
+    float m_checkpointInterval = 60.0f;
+
+    /// Resume the render from the checkpoint at \ref m_checkpointFilePath.
+    bool m_resume = false;
+
+    //-------------------------------------------------------------------------
+    /// \name Post-processing.
+    //-------------------------------------------------------------------------
+
+    /// The exposure adjustment applied to the rendered radiance, in stops.
+    float m_exposure = 0.0f;
+
+    /// The tone mapping curve applied to the rendered radiance.
+    /// \sa CreatePostProcessor
+    std::string m_toneMapping = "none";
+
+    /// The gamma of the display which the image is corrected for.
+    float m_gamma = 2.0f;
+
+    //-------------------------------------------------------------------------
+    /// \name Arbitrary output variables.
+    //-------------------------------------------------------------------------
+
+    /// Comma separated list of the AOVs to write: "albedo", "normal", "depth", "objectId", "sampleCount" and
+    /// "variance".
+    /// Empty disables AOVs.
+    /// \sa ParseAOVChannels
+    std::string m_aovs;
+
+    /// File path to write the AOVs to, as a multi-channel floating point OpenEXR image.
+    std::string m_aovFilePath = "aovs.exr";
+
+    /// The number of camera rays cast per pixel to gather the AOVs, up to \ref m_samplesPerPixel.
+    int m_aovSamplesPerPixel = 16;
+
+    //-------------------------------------------------------------------------
+    /// \name Denoising.
+    //-------------------------------------------------------------------------
+
+    /// Remove the noise of the image with a \ref Denoiser, guided by the albedo, normal, depth and variance AOVs.
+    bool m_denoise = false;
+
+    /// The number of iterations of the denoising filter.  Each doubles the filter footprint.
+    int m_denoiseIterations = 5;
+
+    /// The luminance difference, in standard deviations of the noise, over which pixels are averaged by denoising.
+    float m_denoiseColorSigma = 4.0f;
+
+    /// The depth difference, relative to the depth of a pixel, over which pixels are averaged by denoising.
+    float m_denoiseDepthSigma = 0.1f;
+
+    /// File path of a reference PFM image, such as a render with a high sample count.  If set, the relative mean
+    /// squared error of the image against it is printed, before and after denoising.
+    std::string m_referenceFilePath;
+
+    //-------------------------------------------------------------------------
+    /// \name Camera.
+    //-------------------------------------------------------------------------
+
+    /// Vertical field of view of the camera, in degrees.
+    float m_verticalFov = 20.0f;
+
+    /// Aperture of the camera (lens diameter).
+    float m_aperture = 0.2f;
+
+    /// The time range where the shutter opens and closes.
+    gm::FloatRange m_shutterRange = gm::FloatRange( 0.0f, 1.0f );
+
+    //-------------------------------------------------------------------------
+    /// \name Acceleration.
+    //-------------------------------------------------------------------------
+
+    /// The type of bounding volume hierarchy to build over the scene objects.
+    /// \sa BuildBVH
+    std::string m_bvh = "bvh8";
+
+    /// The algorithm used to build the bounding volume hierarchy.  Builds use \ref m_threadCount threads.
+    /// \sa CreateBVHBuilder
+    std::string m_bvhBuilder = "sah";
+
+    /// The number of bins, per axis, which split candidates are evaluated for in the SAH BVH builder.
+    int m_bvhBinCount = 16;
+
+    /// The maximum number of objects which a BVH leaf node may hold.
+    int m_bvhLeafSize = 4;
+
+    /// The number of keyframes, across each time range, which the extents of motion BVH nodes are sampled at.
+    int m_motionKeyframeCount = 2;
+
+    //-------------------------------------------------------------------------
+    /// \name Performance.
+    //-------------------------------------------------------------------------
+
+    /// Number of threads to build the BVH and render with.  Zero uses all the hardware threads.
+    int m_threadCount = 0;
+
+    //-------------------------------------------------------------------------
+    /// \name Debugging.
+    //-------------------------------------------------------------------------
+
+    /// Print shading and ray information for a single pixel, \ref m_debugPixel.
+    bool m_debug = false;
+
+    /// The pixel coordinate to print debug information for.
+    gm::Vec2i m_debugPixel;
+};
+
+RAYTRACE_NS_CLOSE
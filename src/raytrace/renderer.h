@@ -0,0 +1,715 @@
+#pragma once
+
+/// \file raytrace/renderer.h
+///
+/// The render engine, turning a camera and a scene into an image.
+
+#include <raytrace/aovImage.h>
+#include <raytrace/aovSample.h>
+#include <raytrace/camera.h>
+#include <raytrace/computeRelativeMSE.h>
+#include <raytrace/createSampler.h>
+#include <raytrace/denoiser.h>
+#include <raytrace/imageBuffer.h>
+#include <raytrace/imageWriter.h>
+#include <raytrace/integrator.h>
+#include <raytrace/lightList.h>
+#include <raytrace/pfmImageReader.h>
+#include <raytrace/pixelStatistics.h>
+#include <raytrace/randomPointInUnitDisk.h>
+#include <raytrace/ray.h>
+#include <raytrace/renderCheckpoint.h>
+#include <raytrace/renderSettings.h>
+#include <raytrace/sampler.h>
+#include <raytrace/sceneObject.h>
+#include <raytrace/texture.h>
+#include <raytrace/tileRenderer.h>
+#include <raytrace/tileStreamWriter.h>
+
+#include <gm/functions/normalize.h>
+
+#include <gm/types/floatRange.h>
+#include <gm/types/vec2f.h>
+#include <gm/types/vec2i.h>
+#include <gm/types/vec2iRange.h>
+#include <gm/types/vec3f.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+
+RAYTRACE_NS_OPEN
+
+/// \class Renderer
+///
+/// Renderer owns the full image synthesis pipeline: generating rays from the camera, tracing them through the
+/// scene with an \ref Integrator, accumulating the samples of each pixel into a linear radiance buffer, and
+/// writing out the final image through an \ref ImageWriter.
+///
+/// Programs only need to describe the scene and camera, then hand them to a Renderer.
+class Renderer
+{
+public:
+    /// Explicit constructor with the render settings, camera and scene.
+    ///
+    /// \param i_settings The settings controlling the render.
+    /// \param i_camera The camera model which rays are cast from.
+    /// \param i_rootObject The root object to perform hit tests against.
+    /// \param i_background The texture sampled, by ray direction, when a ray does not hit an object.
+    /// \param i_lights The lights of the scene, sampled directly if \ref RenderSettings::m_lightSampling is set.
+    inline explicit Renderer( const RenderSettings&   i_settings,
+                              const Camera&           i_camera,
+                              const SceneObjectPtr&   i_rootObject,
+                              const TextureSharedPtr& i_background,
+                              const LightList&        i_lights = LightList() )
+        : m_settings( i_settings )
+        , m_camera( i_camera )
+        , m_integrator( i_rootObject,
+                        i_background,
+                        i_settings.m_rayBounceLimit,
+                        i_settings.m_russianRouletteDepth,
+                        i_settings.m_lightSampling ? i_lights : LightList() )
+        , m_sampler( CreateSampler( i_settings ) )
+        , m_imageWriter( CreateImageWriter( i_settings ) )
+    {
+    }
+
+    /// Render the image described by the settings, and write it to the output file path.
+    ///
+    /// If AOVs are requested, they are gathered once the image is rendered, and written to the AOV file path.
+    ///
+    /// If denoising is enabled, the image is filtered by a \ref Denoiser, guided by AOVs gathered for it, before
+    /// it is written.  If a reference image is set, the error of the image against it is printed, before and after
+    /// denoising.
+    ///
+    /// If debugging is enabled, the debug pixel is re-shaded with its ray information printed.
+    ///
+    /// \return success of rendering and writing the image.  Fails if the sampler type, tone mapping curve, output
+    /// file format or an AOV is not recognized, the render cannot be resumed, the reference image cannot be read,
+    /// or denoising is requested with streamed output.
+    inline bool Run() const
+    {
+        int aovChannels = 0;
+        if ( !m_sampler || !m_imageWriter || !ParseAOVChannels( m_settings.m_aovs, aovChannels ) )
+        {
+            return false;
+        }
+
+        if ( m_settings.m_denoise && m_settings.m_streamOutput )
+        {
+            std::cerr << "Denoising is not supported with streamed output." << std::endl;
+            return false;
+        }
+
+        RGBImageBuffer reference( 0, 0 );
+        if ( !m_settings.m_referenceFilePath.empty() )
+        {
+            if ( !ReadPFMImage( m_settings.m_referenceFilePath, reference ) )
+            {
+                return false;
+            }
+
+            if ( reference.Width() != m_settings.m_imageWidth || reference.Height() != m_settings.m_imageHeight )
+            {
+                std::cerr << "Reference image dimensions do not match the render: " << reference.Width() << "x"
+                          << reference.Height() << std::endl;
+                return false;
+            }
+        }
+
+        // The denoiser is guided by AOVs of its own, which are not written unless requested.
+        int gatheredChannels = aovChannels | ( m_settings.m_denoise ? Denoiser::c_guideChannels : 0 );
+
+        std::unique_ptr< AOVImage > aovs;
+        if ( gatheredChannels != 0 )
+        {
+            aovs.reset( new AOVImage( gatheredChannels, m_settings.m_imageWidth, m_settings.m_imageHeight ) );
+        }
+
+        if ( m_settings.m_streamOutput )
+        {
+            if ( !RenderStreaming( aovs.get() ) )
+            {
+                return false;
+            }
+
+            if ( aovs )
+            {
+                RenderAOVs( *aovs );
+            }
+        }
+        else
+        {
+            RGBImageBuffer radiance( m_settings.m_imageWidth, m_settings.m_imageHeight );
+            if ( !Render( radiance, aovs.get() ) )
+            {
+                return false;
+            }
+
+            if ( m_settings.m_debug )
+            {
+                ShadePixel( m_settings.m_debugPixel, *m_sampler->Clone(), /* printDebug */ true );
+            }
+
+            if ( aovs )
+            {
+                RenderAOVs( *aovs );
+            }
+
+            if ( !m_settings.m_referenceFilePath.empty() )
+            {
+                std::cout << "Relative MSE: " << ComputeRelativeMSE( radiance, reference ) << std::endl;
+            }
+
+            if ( m_settings.m_denoise )
+            {
+                RGBImageBuffer denoisedRadiance( m_settings.m_imageWidth, m_settings.m_imageHeight );
+                Denoiser       denoiser( m_settings.m_denoiseIterations,
+                                   m_settings.m_denoiseColorSigma,
+                                   m_settings.m_denoiseDepthSigma,
+                                   m_settings.m_threadCount );
+                denoiser.Apply( radiance, *aovs, denoisedRadiance );
+                radiance = std::move( denoisedRadiance );
+
+                if ( !m_settings.m_referenceFilePath.empty() )
+                {
+                    std::cout << "Denoised relative MSE: " << ComputeRelativeMSE( radiance, reference ) << std::endl;
+                }
+            }
+
+            if ( !m_imageWriter->Write( radiance, m_settings.m_outputFilePath ) )
+            {
+                return false;
+            }
+        }
+
+        if ( aovChannels != 0 )
+        {
+            return aovs->Write( m_settings.m_aovFilePath, aovChannels );
+        }
+
+        return true;
+    }
+
+    /// Shade all the pixels of the image in parallel, streaming each finished tile to the output file.
+    ///
+    /// Finished tiles are handed to a \ref TileStreamWriter, which writes them into place on its own thread, while
+    /// rendering continues.  Only a bounded number of finished tiles are held in memory, rather than the whole
+    /// image, and the output file is complete as soon as the last tile is written.
+    ///
+    /// If debugging is enabled, the debug pixel is re-shaded with its ray information printed.
+    ///
+    /// \param o_aovs Optional AOV image to record the sample count and variance of each pixel into.
+    ///
+    /// \return success of rendering and writing the image.  Fails for progressive renders, which need the
+    /// statistics of every pixel until the end, and for output file formats which cannot be streamed.
+    inline bool RenderStreaming( AOVImage* o_aovs = nullptr ) const
+    {
+        if ( _IsProgressive() )
+        {
+            std::cerr << "Streaming output is not supported by progressive renders." << std::endl;
+            return false;
+        }
+
+        // Each thread may have a tile in flight, while as many finished tiles wait to be written.
+        TileRenderer        tileRenderer( m_settings.m_threadCount );
+        TileStreamWriterPtr stream = m_imageWriter->OpenTileStream( m_settings.m_outputFilePath,
+                                                                    m_settings.m_imageWidth,
+                                                                    m_settings.m_imageHeight,
+                                                                    tileRenderer.ThreadCount() );
+        if ( !stream )
+        {
+            return false;
+        }
+
+        gm::Vec2iRange extent( gm::Vec2i( 0, 0 ), gm::Vec2i( m_settings.m_imageWidth, m_settings.m_imageHeight ) );
+        tileRenderer.ForEachTile( extent, [&]( const gm::Vec2iRange& i_tile ) {
+            SamplerPtr     sampler = m_sampler->Clone();
+            RGBImageBuffer tileRadiance( i_tile.Max().X() - i_tile.Min().X(), i_tile.Max().Y() - i_tile.Min().Y() );
+            for ( int yCoord = i_tile.Min().Y(); yCoord < i_tile.Max().Y(); ++yCoord )
+            {
+                for ( int xCoord = i_tile.Min().X(); xCoord < i_tile.Max().X(); ++xCoord )
+                {
+                    gm::Vec2i       pixelCoord( xCoord, yCoord );
+                    PixelStatistics statistics = ShadePixel( pixelCoord, *sampler );
+                    tileRadiance( xCoord - i_tile.Min().X(), yCoord - i_tile.Min().Y() ) = statistics.Mean();
+                    if ( o_aovs != nullptr )
+                    {
+                        o_aovs->SetStatistics( pixelCoord, statistics );
+                    }
+                }
+            }
+            stream->Submit( i_tile, std::move( tileRadiance ) );
+        } );
+
+        if ( m_settings.m_debug )
+        {
+            ShadePixel( m_settings.m_debugPixel, *m_sampler->Clone(), /* printDebug */ true );
+        }
+
+        return stream->Close();
+    }
+
+    /// Shade all the pixels of \p o_radiance, in parallel.
+    ///
+    /// If progressive rendering or adaptive sampling is enabled, see \ref RenderProgressive.  Otherwise, every
+    /// pixel takes \ref RenderSettings::m_samplesPerPixel samples, one pixel at a time.
+    ///
+    /// \param o_radiance The image buffer to write the linear radiance of each pixel into.
+    /// \param o_aovs Optional AOV image to record the sample count and variance of each pixel into.
+    ///
+    /// \return success of the render.
+    inline bool Render( RGBImageBuffer& o_radiance, AOVImage* o_aovs = nullptr ) const
+    {
+        TileRenderer tileRenderer( m_settings.m_threadCount );
+        if ( _IsProgressive() )
+        {
+            return RenderProgressive( tileRenderer, o_radiance, o_aovs );
+        }
+
+        tileRenderer.ForEachTile( o_radiance.Extent(), [&]( const gm::Vec2iRange& i_tile ) {
+            SamplerPtr sampler = m_sampler->Clone();
+            for ( int yCoord = i_tile.Min().Y(); yCoord < i_tile.Max().Y(); ++yCoord )
+            {
+                for ( int xCoord = i_tile.Min().X(); xCoord < i_tile.Max().X(); ++xCoord )
+                {
+                    gm::Vec2i       pixelCoord( xCoord, yCoord );
+                    PixelStatistics statistics   = ShadePixel( pixelCoord, *sampler );
+                    o_radiance( xCoord, yCoord ) = statistics.Mean();
+                    if ( o_aovs != nullptr )
+                    {
+                        o_aovs->SetStatistics( pixelCoord, statistics );
+                    }
+                }
+            }
+        } );
+        return true;
+    }
+
+    /// Shade all the pixels of \p o_radiance together, refining them pass by pass.
+    ///
+    /// Each pass takes \ref RenderSettings::m_samplesPerPass further samples for every pixel which needs them.
+    /// A pixel stops once it has taken \ref RenderSettings::m_samplesPerPixel samples.  Under adaptive
+    /// sampling, a pixel also stops once it has taken at least \ref RenderSettings::m_minSamplesPerPixel
+    /// samples and its relative error falls below \ref RenderSettings::m_adaptiveThreshold.  See
+    /// \ref PixelStatistics::RelativeError.
+    ///
+    /// The render stops early:
+    /// - If \ref RenderSettings::m_noiseTarget is positive, once the mean relative error across all pixels
+    ///   falls below it.
+    /// - Before a pass which is predicted, from the duration of the previous pass, to exceed the time budget
+    ///   \ref RenderSettings::m_timeBudget, or the deadline \ref RenderSettings::m_deadline.
+    ///
+    /// Snapshots of the image are written to the output file path every
+    /// \ref RenderSettings::m_snapshotInterval seconds and every \ref RenderSettings::m_snapshotPassInterval
+    /// passes, so the best image so far is always available.
+    ///
+    /// If \ref RenderSettings::m_checkpointFilePath is set, the per-pixel statistics are checkpointed to it
+    /// every \ref RenderSettings::m_checkpointInterval seconds, and once the render stops.  If
+    /// \ref RenderSettings::m_resume is set, the render resumes from that checkpoint.  Samples are keyed by
+    /// their index, and passes only depend on the state of each pixel, so a resumed render produces the same
+    /// image as an uninterrupted one.  Resuming a finished render takes no further samples, so it only re-grades
+    /// the image.
+    ///
+    /// \param i_tileRenderer The tile renderer distributing the pixels of each pass across threads.
+    /// \param o_radiance The image buffer to write the linear radiance of each pixel into.
+    /// \param o_aovs Optional AOV image to record the sample count and variance of each pixel into.
+    ///
+    /// \return success of the render.  Fails if the checkpoint to resume from cannot be read, or the final
+    /// checkpoint cannot be written.
+    inline bool RenderProgressive( const TileRenderer& i_tileRenderer,
+                                   RGBImageBuffer&     o_radiance,
+                                   AOVImage*           o_aovs = nullptr ) const
+    {
+        using Clock = std::chrono::steady_clock;
+
+        ImageBuffer< PixelStatistics > statistics( o_radiance.Width(), o_radiance.Height() );
+        int                            samplesPerPass = std::max( m_settings.m_samplesPerPass, 1 );
+        if ( m_settings.m_resume && !ReadRenderCheckpoint( m_settings.m_checkpointFilePath, m_settings, statistics ) )
+        {
+            return false;
+        }
+
+        // Resolve the time budget and deadline into a single end time.
+        Clock::time_point startTime      = Clock::now();
+        Clock::time_point endTime        = Clock::time_point::max();
+        Clock::time_point snapshotTime   = startTime;
+        Clock::time_point checkpointTime = startTime;
+        if ( m_settings.m_timeBudget > 0.0f )
+        {
+            endTime = std::min( endTime, startTime + _ToDuration( m_settings.m_timeBudget ) );
+        }
+        if ( m_settings.m_deadline > 0.0 )
+        {
+            double secondsSinceEpoch = std::chrono::duration< double >(
+                                           std::chrono::system_clock::now().time_since_epoch() )
+                                           .count();
+            endTime = std::min( endTime, startTime + _ToDuration( m_settings.m_deadline - secondsSinceEpoch ) );
+        }
+
+        Clock::duration passDuration = Clock::duration::zero();
+        int             passCount    = 0;
+        for ( ;; )
+        {
+            Clock::time_point passStartTime = Clock::now();
+            if ( endTime != Clock::time_point::max() && endTime - passStartTime < passDuration )
+            {
+                break;
+            }
+
+            std::atomic< int > sampledPixelCount( 0 );
+            i_tileRenderer.ForEachTile( o_radiance.Extent(), [&]( const gm::Vec2iRange& i_tile ) {
+                SamplerPtr sampler          = m_sampler->Clone();
+                int        tileSampledCount = 0;
+                for ( int yCoord = i_tile.Min().Y(); yCoord < i_tile.Max().Y(); ++yCoord )
+                {
+                    for ( int xCoord = i_tile.Min().X(); xCoord < i_tile.Max().X(); ++xCoord )
+                    {
+                        PixelStatistics& pixelStatistics = statistics( xCoord, yCoord );
+                        if ( _IsConverged( pixelStatistics ) )
+                        {
+                            continue;
+                        }
+
+                        int sampleCount =
+                            std::min( samplesPerPass, m_settings.m_samplesPerPixel - pixelStatistics.SampleCount() );
+                        SamplePixel( gm::Vec2i( xCoord, yCoord ), sampleCount, *sampler, pixelStatistics );
+                        tileSampledCount++;
+                    }
+                }
+                sampledPixelCount += tileSampledCount;
+            } );
+
+            if ( sampledPixelCount == 0 )
+            {
+                break;
+            }
+
+            passCount++;
+            Clock::time_point passEndTime = Clock::now();
+            passDuration                  = passEndTime - passStartTime;
+
+            if ( m_settings.m_noiseTarget > 0.0f && _ComputeMeanError( statistics ) <= m_settings.m_noiseTarget )
+            {
+                break;
+            }
+
+            // Write out a snapshot of the image so far.
+            bool snapshotDue =
+                ( m_settings.m_snapshotPassInterval > 0 && passCount % m_settings.m_snapshotPassInterval == 0 ) ||
+                ( m_settings.m_snapshotInterval > 0.0f &&
+                  passEndTime - snapshotTime >= _ToDuration( m_settings.m_snapshotInterval ) );
+            if ( snapshotDue )
+            {
+                _ResolveRadiance( statistics, o_radiance );
+                if ( !_WriteSnapshot( o_radiance ) )
+                {
+                    std::cerr << "Warning: continuing the render without snapshot '" << m_settings.m_outputFilePath
+                              << "'." << std::endl;
+                }
+                snapshotTime = Clock::now();
+            }
+
+            if ( !m_settings.m_checkpointFilePath.empty() &&
+                 passEndTime - checkpointTime >= _ToDuration( m_settings.m_checkpointInterval ) )
+            {
+                // The render carries on, as the next checkpoint may succeed, and the final one is checked.
+                if ( !WriteRenderCheckpoint( statistics, m_settings, m_settings.m_checkpointFilePath ) )
+                {
+                    std::cerr << "Warning: continuing the render without checkpoint '"
+                              << m_settings.m_checkpointFilePath << "'." << std::endl;
+                }
+                checkpointTime = Clock::now();
+            }
+        }
+
+        _ResolveRadiance( statistics, o_radiance );
+        if ( o_aovs != nullptr )
+        {
+            for ( int yCoord = 0; yCoord < statistics.Height(); ++yCoord )
+            {
+                for ( int xCoord = 0; xCoord < statistics.Width(); ++xCoord )
+                {
+                    o_aovs->SetStatistics( gm::Vec2i( xCoord, yCoord ), statistics( xCoord, yCoord ) );
+                }
+            }
+        }
+
+        if ( !m_settings.m_checkpointFilePath.empty() &&
+             !WriteRenderCheckpoint( statistics, m_settings, m_settings.m_checkpointFilePath ) )
+        {
+            return false;
+        }
+
+        if ( m_settings.m_debug )
+        {
+            long long totalSampleCount = 0;
+            for ( int yCoord = 0; yCoord < statistics.Height(); ++yCoord )
+            {
+                for ( int xCoord = 0; xCoord < statistics.Width(); ++xCoord )
+                {
+                    totalSampleCount += statistics( xCoord, yCoord ).SampleCount();
+                }
+            }
+
+            std::cout << "Progressive passes: " << passCount << std::endl;
+            std::cout << "Progressive render time: "
+                      << std::chrono::duration< double >( Clock::now() - startTime ).count() << "s" << std::endl;
+            std::cout << "Mean samples per pixel: "
+                      << ( double ) totalSampleCount / ( o_radiance.Width() * o_radiance.Height() ) << std::endl;
+            std::cout << "Mean relative error: " << _ComputeMeanError( statistics ) << std::endl;
+        }
+
+        return true;
+    }
+
+    /// Gather the arbitrary output variables (AOVs) of every pixel into \p io_aovs, in parallel.
+    ///
+    /// AOVs are gathered in a pass of their own, once the image is rendered, such that rendering without AOVs
+    /// does not pay for them.  Each pixel casts \ref RenderSettings::m_aovSamplesPerPixel camera rays, capped at
+    /// \ref RenderSettings::m_samplesPerPixel, and follows them to their first non-specular hit, see
+    /// \ref Integrator::ComputeRayAOVs.  They are the camera rays of the first samples of the pixel, although a
+    /// pixel which stopped early, under adaptive sampling or a time budget, may not have taken all of them.
+    ///
+    /// The albedo and normal are averaged over all the rays, the depth over the rays which hit a surface (zero if
+    /// none did), and the object ID is taken from the first ray.
+    ///
+    /// \param io_aovs The AOV image, whose requested channels are written, except for the sample count and variance.
+    inline void RenderAOVs( AOVImage& io_aovs ) const
+    {
+        int sampleCount = std::max( std::min( m_settings.m_aovSamplesPerPixel, m_settings.m_samplesPerPixel ), 1 );
+
+        TileRenderer tileRenderer( m_settings.m_threadCount );
+        tileRenderer.ForEachTile( io_aovs.Extent(), [&]( const gm::Vec2iRange& i_tile ) {
+            SamplerPtr sampler = m_sampler->Clone();
+            AOVSample  sample;
+            for ( int yCoord = i_tile.Min().Y(); yCoord < i_tile.Max().Y(); ++yCoord )
+            {
+                for ( int xCoord = i_tile.Min().X(); xCoord < i_tile.Max().X(); ++xCoord )
+                {
+                    gm::Vec2i pixelCoord( xCoord, yCoord );
+                    gm::Vec3f albedo( 0, 0, 0 );
+                    gm::Vec3f normal( 0, 0, 0 );
+                    float     depth    = 0.0f;
+                    int       hitCount = 0;
+                    int       objectId = -1;
+                    for ( int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex )
+                    {
+                        sampler->StartPixelSample( pixelCoord, sampleIndex );
+                        raytrace::Ray ray = GenerateCameraRay( pixelCoord, *sampler );
+                        m_integrator.ComputeRayAOVs( ray, *sampler, sample );
+
+                        albedo += sample.m_albedo;
+                        normal += sample.m_normal;
+                        if ( sample.m_isHit )
+                        {
+                            depth += sample.m_depth;
+                            hitCount++;
+                        }
+
+                        if ( sampleIndex == 0 )
+                        {
+                            objectId = sample.m_objectId;
+                        }
+                    }
+
+                    io_aovs.SetPixel( pixelCoord,
+                                      albedo / ( float ) sampleCount,
+                                      normal / ( float ) sampleCount,
+                                      hitCount > 0 ? depth / ( float ) hitCount : 0.0f,
+                                      objectId );
+                }
+            }
+        } );
+    }
+
+    /// Shade the specified pixel coordinate \p i_pixelCoord through colors sampled from casted rays.
+    ///
+    /// \param i_pixelCoord The pixel coordinate to shade.
+    /// \param io_sampler The sampler which the samples draw their values from, such as a clone shared by the
+    /// pixels of a tile.
+    /// \param i_printDebug Flag to enable debug printing of shading and ray information.
+    ///
+    /// \return The statistics of the samples of the pixel, whose mean is the linear radiance of the pixel.
+    inline PixelStatistics
+    ShadePixel( const gm::Vec2i& i_pixelCoord, Sampler& io_sampler, bool i_printDebug = false ) const
+    {
+        if ( i_printDebug )
+        {
+            std::cout << "Pixel " << i_pixelCoord << std::endl;
+        }
+
+        // Accumulate pixel color over multiple samples.
+        PixelStatistics statistics;
+        SamplePixel( i_pixelCoord, m_settings.m_samplesPerPixel, io_sampler, statistics, i_printDebug );
+
+        return statistics;
+    }
+
+    /// Take further samples of the pixel \p i_pixelCoord, and accumulate their colors into \p io_statistics.
+    ///
+    /// Sample indices continue from the number of samples already accumulated.  The samples draw their values
+    /// from \p io_sampler, keyed by the pixel, the sample index and \ref RenderSettings::m_seed, so the result
+    /// is independent of the thread and order which pixels are rendered in.
+    ///
+    /// \param i_pixelCoord The pixel coordinate to sample.
+    /// \param i_sampleCount The number of samples to take.
+    /// \param io_sampler The sampler which the samples draw their values from.
+    /// \param io_statistics The statistics of the samples of the pixel.
+    /// \param i_printDebug Flag to enable debug printing of shading and ray information.
+    inline void SamplePixel( const gm::Vec2i& i_pixelCoord,
+                             int              i_sampleCount,
+                             Sampler&         io_sampler,
+                             PixelStatistics& io_statistics,
+                             bool             i_printDebug = false ) const
+    {
+        for ( int sampleOffset = 0; sampleOffset < i_sampleCount; ++sampleOffset )
+        {
+            int sampleIndex = io_statistics.SampleCount();
+            io_sampler.StartPixelSample( i_pixelCoord, sampleIndex );
+            raytrace::Ray ray         = GenerateCameraRay( i_pixelCoord, io_sampler );
+            gm::Vec3f     sampleColor = m_integrator.ComputeRayColor( ray, io_sampler, i_printDebug );
+            io_statistics.AddSample( sampleColor );
+
+            if ( i_printDebug )
+            {
+                std::cout << c_debugIndent << "Sample: " << sampleIndex << std::endl;
+                std::cout << c_debugIndent << "Sample color: " << sampleColor << std::endl;
+            }
+        }
+    }
+
+    /// Generate a camera ray through a random position within the pixel \p i_pixelCoord.
+    ///
+    /// The ray origin is randomly offset across the camera lens to produce depth of field, and the
+    /// ray time is randomly chosen within the shutter range to produce motion blur.
+    ///
+    /// \param i_pixelCoord The pixel coordinate.
+    /// \param io_sampler The sampler of the sample, positioned at its first dimension.
+    ///
+    /// \return The camera ray.
+    inline raytrace::Ray GenerateCameraRay( const gm::Vec2i& i_pixelCoord, Sampler& io_sampler ) const
+    {
+        // Compute normalised viewport coordinates (values between 0 and 1).
+        gm::Vec2f pixelSample = io_sampler.Get2D();
+        float     u           = ( float( i_pixelCoord.X() ) + pixelSample[ 0 ] ) / m_settings.m_imageWidth;
+        float     v           = ( float( i_pixelCoord.Y() ) + pixelSample[ 1 ] ) / m_settings.m_imageHeight;
+
+        // Compute lens offset, produces the depth of field effect for those objects not exactly
+        // at the focal distance.
+        const float lensRadius        = m_camera.Aperture() * 0.5f;
+        gm::Vec3f   randomPointInLens = lensRadius * RandomPointInUnitDisk( io_sampler.Get2D() );
+        gm::Vec3f   lensOffset        = randomPointInLens.X() * m_camera.Right() + randomPointInLens.Y() * m_camera.Up();
+
+        // Construct our ray.
+        gm::Vec3f rayDirection = m_camera.ViewportBottomLeft()           // Starting from the viewport bottom left...
+                                 + ( u * m_camera.ViewportHorizontal() ) // Horizontal offset.
+                                 + ( v * m_camera.ViewportVertical() )   // Vertical offset.
+                                 - m_camera.Origin()                     // Get difference vector from camera origin.
+                                 - lensOffset; // Since the origin was offset, we must apply the inverse offset to
+                                               // the ray direction such that the ray position _at the focal plane_
+                                               // is the same as before!
+
+        // Compute the time within the shutter range, produces the motion blur effect.
+        float time = m_settings.m_shutterRange.Min() +
+                     io_sampler.Get1D() * ( m_settings.m_shutterRange.Max() - m_settings.m_shutterRange.Min() );
+
+        return raytrace::Ray( /* origin */ m_camera.Origin() + lensOffset,
+                              /* direction */ gm::Normalize( rayDirection ),
+                              /* time */ time );
+    }
+
+private:
+    // Check if the image is rendered in passes, rather than one pixel at a time.
+    inline bool _IsProgressive() const
+    {
+        return m_settings.m_progressive || m_settings.m_adaptiveSampling || m_settings.m_timeBudget > 0.0f ||
+               m_settings.m_deadline > 0.0 || m_settings.m_snapshotInterval > 0.0f ||
+               m_settings.m_snapshotPassInterval > 0 || !m_settings.m_checkpointFilePath.empty();
+    }
+
+    // Check if a pixel has taken enough samples.
+    inline bool _IsConverged( const PixelStatistics& i_statistics ) const
+    {
+        if ( i_statistics.SampleCount() >= m_settings.m_samplesPerPixel )
+        {
+            return true;
+        }
+
+        return m_settings.m_adaptiveSampling && i_statistics.SampleCount() >= m_settings.m_minSamplesPerPixel &&
+               i_statistics.RelativeError() <= m_settings.m_adaptiveThreshold;
+    }
+
+    // Compute the mean relative error across all the pixels of \p i_statistics.
+    static inline float _ComputeMeanError( const ImageBuffer< PixelStatistics >& i_statistics )
+    {
+        double errorSum = 0.0;
+        for ( int yCoord = 0; yCoord < i_statistics.Height(); ++yCoord )
+        {
+            for ( int xCoord = 0; xCoord < i_statistics.Width(); ++xCoord )
+            {
+                errorSum += i_statistics( xCoord, yCoord ).RelativeError();
+            }
+        }
+
+        return ( float ) ( errorSum / ( ( double ) i_statistics.Width() * i_statistics.Height() ) );
+    }
+
+    // Resolve the mean radiance of every pixel of \p i_statistics into \p o_radiance.
+    static inline void _ResolveRadiance( const ImageBuffer< PixelStatistics >& i_statistics,
+                                         RGBImageBuffer&                       o_radiance )
+    {
+        for ( int yCoord = 0; yCoord < o_radiance.Height(); ++yCoord )
+        {
+            for ( int xCoord = 0; xCoord < o_radiance.Width(); ++xCoord )
+            {
+                o_radiance( xCoord, yCoord ) = i_statistics( xCoord, yCoord ).Mean();
+            }
+        }
+    }
+
+    // Write \p i_radiance as a snapshot to the output file path.  The snapshot is written to a temporary file
+    // first, then renamed over the output, such that a process killed mid-write leaves the previous snapshot.
+    //
+    // Returns whether the snapshot was written.  The reason of a failure is printed to the standard error.
+    inline bool _WriteSnapshot( const RGBImageBuffer& i_radiance ) const
+    {
+        std::string temporaryFilePath = m_settings.m_outputFilePath + ".tmp";
+        if ( !m_imageWriter->Write( i_radiance, temporaryFilePath ) )
+        {
+            return false;
+        }
+
+        if ( std::rename( temporaryFilePath.c_str(), m_settings.m_outputFilePath.c_str() ) != 0 )
+        {
+            std::cerr << "Cannot rename snapshot '" << temporaryFilePath << "' to '" << m_settings.m_outputFilePath
+                      << "': " << std::strerror( errno ) << "!" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Convert a duration in seconds into a steady clock duration.
+    static inline std::chrono::steady_clock::duration _ToDuration( double i_seconds )
+    {
+        return std::chrono::duration_cast< std::chrono::steady_clock::duration >(
+            std::chrono::duration< double >( i_seconds ) );
+    }
+
+    RenderSettings m_settings;
+    Camera         m_camera;
+    Integrator     m_integrator;
+    SamplerPtr     m_sampler;
+    ImageWriterPtr m_imageWriter;
+};
+
+RAYTRACE_NS_CLOSE
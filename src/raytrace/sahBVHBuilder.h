@@ -0,0 +1,335 @@
+#pragma once
+
+/// \file raytrace/sahBVHBuilder.h
+///
+/// Bounding volume hierarchy builder, based on the binned Surface Area Heuristic.
+
+#include <raytrace/bvhBuildNode.h>
+#include <raytrace/bvhBuilder.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/types/intRange.h>
+#include <gm/types/vec3f.h>
+#include <gm/types/vec3fRange.h>
+
+#include <gm/functions/expand.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class SAHBVHBuilder
+///
+/// SAHBVHBuilder constructs a binary BVH build tree by top-down partitioning of the scene objects.
+///
+/// At each node, the object centroids are distributed into a fixed number of equally sized bins along each
+/// axis.  Every boundary between two bins is a candidate split, and its cost is estimated with the Surface Area
+/// Heuristic (SAH):
+///
+/// \code
+/// cost = traversalCost +
+///        ( area( left ) * count( left ) + area( right ) * count( right ) ) / area( node ) * intersectionCost
+/// \endcode
+///
+/// The cheapest candidate is chosen.  A node becomes a leaf once it holds no more than the leaf size number
+/// of objects, and intersecting them directly is cheaper than any split.  Nodes which are too deep to reach
+/// their leaves within \ref c_bvhMaxDepth by SAH splits are split at the median instead.
+///
+/// Objects are partitioned in place, so the left & right subtrees of a node are built concurrently.
+class SAHBVHBuilder : public BVHBuilder
+{
+public:
+    /// Explicit constructor with the builder parameters.
+    ///
+    /// \param i_binCount The number of bins, per axis, which split candidates are evaluated for.
+    /// \param i_leafSize The maximum number of objects which a leaf node may hold, up to \ref c_bvhMaxLeafSize.
+    /// \param i_threadCount The number of threads to build with.  If zero or negative, the number of
+    /// concurrent threads supported by the hardware is used.
+    /// \param i_traversalCost The relative cost of visiting an interior node.
+    /// \param i_intersectionCost The relative cost of intersecting a single object.
+    inline explicit SAHBVHBuilder( int   i_binCount         = 16,
+                                   int   i_leafSize         = 4,
+                                   int   i_threadCount      = 1,
+                                   float i_traversalCost    = 1.0f,
+                                   float i_intersectionCost = 1.0f )
+        : BVHBuilder( i_threadCount, i_traversalCost, i_intersectionCost )
+        , m_binCount( std::max( i_binCount, 2 ) )
+        , m_leafSize( std::min( std::max( i_leafSize, 1 ), c_bvhMaxLeafSize ) )
+    {
+    }
+
+    virtual inline std::unique_ptr< BVHBuildNode > Build( const SceneObjectPtrs&      i_sceneObjects,
+                                                          const std::vector< float >& i_times,
+                                                          SceneObjectPtrs&            o_orderedObjects ) const override
+    {
+        o_orderedObjects.clear();
+        if ( i_sceneObjects.empty() )
+        {
+            return nullptr;
+        }
+
+        std::vector< gm::Vec3fRange > extents( i_sceneObjects.size() );
+        _ParallelFor( extents.size(), [&]( int i_begin, int i_end ) {
+            for ( int objectIndex = i_begin; objectIndex < i_end; ++objectIndex )
+            {
+                extents[ objectIndex ] = i_sceneObjects[ objectIndex ]->Extent( i_times );
+            }
+        } );
+
+        std::vector< int >              orderedIndices;
+        std::unique_ptr< BVHBuildNode > root = BuildExtents( extents, orderedIndices );
+
+        o_orderedObjects.reserve( orderedIndices.size() );
+        for ( int objectIndex : orderedIndices )
+        {
+            o_orderedObjects.push_back( i_sceneObjects[ objectIndex ] );
+        }
+
+        return root;
+    }
+
+    /// Build a BVH tree over a collection of extents, such as the primitives of a single scene object.
+    ///
+    /// \param i_extents The extents to build the BVH for.
+    /// \param o_orderedIndices Indices into \p i_extents, re-ordered such that each leaf references a contiguous
+    /// range.
+    ///
+    /// \return The root node of the build tree, or null if \p i_extents is empty.
+    inline std::unique_ptr< BVHBuildNode > BuildExtents( const std::vector< gm::Vec3fRange >& i_extents,
+                                                         std::vector< int >&                  o_orderedIndices ) const
+    {
+        o_orderedIndices.clear();
+        if ( i_extents.empty() )
+        {
+            return nullptr;
+        }
+
+        // Compute the centroid of each extent, once.
+        std::vector< _BuildObject > buildObjects( i_extents.size() );
+        _ParallelFor( buildObjects.size(), [&]( int i_begin, int i_end ) {
+            for ( int objectIndex = i_begin; objectIndex < i_end; ++objectIndex )
+            {
+                _BuildObject& buildObject = buildObjects[ objectIndex ];
+                buildObject.m_extent      = i_extents[ objectIndex ];
+                buildObject.m_centroid    = ( buildObject.m_extent.Min() + buildObject.m_extent.Max() ) * 0.5f;
+                buildObject.m_index       = objectIndex;
+            }
+        } );
+
+        std::unique_ptr< BVHBuildNode > root =
+            _Build( gm::IntRange( 0, buildObjects.size() ), buildObjects, /* depth */ 0, m_threadCount );
+
+        // Leaves reference the partitioned build objects, so their order is the object order.
+        o_orderedIndices.reserve( buildObjects.size() );
+        for ( const _BuildObject& buildObject : buildObjects )
+        {
+            o_orderedIndices.push_back( buildObject.m_index );
+        }
+
+        return root;
+    }
+
+    /// Get the number of bins, per axis.
+    inline int BinCount() const
+    {
+        return m_binCount;
+    }
+
+    /// Get the maximum number of objects which a leaf node may hold.
+    inline int LeafSize() const
+    {
+        return m_leafSize;
+    }
+
+private:
+    // Per-object information cached for the duration of the build.
+    class _BuildObject
+    {
+    public:
+        gm::Vec3fRange m_extent;
+        gm::Vec3f      m_centroid;
+        int            m_index = 0;
+    };
+
+    // Accumulated extent and object count of a single bin.
+    class _Bin
+    {
+    public:
+        gm::Vec3fRange m_extent;
+        int            m_objectCount = 0;
+    };
+
+    // Recursively build the node for the objects within \p i_objectRange, at \p i_depth interior nodes below the
+    // root, with up to \p i_threadBudget threads.
+    inline std::unique_ptr< BVHBuildNode > _Build( const gm::IntRange&          i_objectRange,
+                                                   std::vector< _BuildObject >& io_buildObjects,
+                                                   int                          i_depth,
+                                                   int                          i_threadBudget ) const
+    {
+        std::unique_ptr< BVHBuildNode > node( new BVHBuildNode() );
+
+        // Compute the extent of the objects, and of their centroids.
+        gm::Vec3fRange centroidExtent;
+        for ( int objectIndex : i_objectRange )
+        {
+            const _BuildObject& buildObject = io_buildObjects[ objectIndex ];
+            node->m_extent                  = gm::Expand( node->m_extent, buildObject.m_extent );
+            centroidExtent                  = gm::Expand( centroidExtent, buildObject.m_centroid );
+        }
+
+        int objectCount = i_objectRange.Max() - i_objectRange.Min();
+        if ( objectCount == 1 )
+        {
+            _MakeLeaf( i_objectRange, *node );
+            return node;
+        }
+
+        // Median splits halve the objects at each level, so they are forced once the objects only just fit within
+        // the remaining depth.
+        int  remainingDepth = c_bvhMaxDepth - i_depth;
+        bool medianSplit    = remainingDepth <= 31 && objectCount > ( 1 << ( remainingDepth - 1 ) );
+
+        // Find the cheapest split across all axes.
+        int   splitAxis = -1;
+        int   splitBin  = -1;
+        float splitCost = std::numeric_limits< float >::max();
+        float nodeArea  = std::max( SurfaceArea( node->m_extent ), std::numeric_limits< float >::min() );
+        for ( int axis = 0; axis < 3 && !medianSplit; ++axis )
+        {
+            float axisLength = centroidExtent.Max()[ axis ] - centroidExtent.Min()[ axis ];
+            if ( !( axisLength > 0.0f ) || !std::isfinite( axisLength ) )
+            {
+                // All centroids coincide along this axis.
+                continue;
+            }
+
+            // Distribute the objects into bins.
+            std::vector< _Bin > bins( m_binCount );
+            for ( int objectIndex : i_objectRange )
+            {
+                const _BuildObject& buildObject = io_buildObjects[ objectIndex ];
+
+                _Bin& bin    = bins[ _ComputeBinIndex( buildObject.m_centroid, centroidExtent, axis ) ];
+                bin.m_extent = gm::Expand( bin.m_extent, buildObject.m_extent );
+                bin.m_objectCount++;
+            }
+
+            // Sweep from the right to accumulate the cost terms of the right-hand side of each split.
+            std::vector< float > rightCosts( m_binCount, 0.0f );
+            gm::Vec3fRange       rightExtent;
+            int                  rightCount = 0;
+            for ( int binIndex = m_binCount - 1; binIndex > 0; --binIndex )
+            {
+                rightExtent = gm::Expand( rightExtent, bins[ binIndex ].m_extent );
+                rightCount += bins[ binIndex ].m_objectCount;
+                rightCosts[ binIndex - 1 ] = rightCount > 0 ? SurfaceArea( rightExtent ) * rightCount : -1.0f;
+            }
+
+            // Sweep from the left, evaluating the cost of splitting after each bin.
+            gm::Vec3fRange leftExtent;
+            int            leftCount = 0;
+            for ( int binIndex = 0; binIndex < m_binCount - 1; ++binIndex )
+            {
+                leftExtent = gm::Expand( leftExtent, bins[ binIndex ].m_extent );
+                leftCount += bins[ binIndex ].m_objectCount;
+                if ( leftCount == 0 || rightCosts[ binIndex ] < 0.0f )
+                {
+                    continue;
+                }
+
+                float cost = m_traversalCost + ( SurfaceArea( leftExtent ) * leftCount + rightCosts[ binIndex ] ) /
+                                                   nodeArea * m_intersectionCost;
+                if ( cost < splitCost )
+                {
+                    splitAxis = axis;
+                    splitBin  = binIndex;
+                    splitCost = cost;
+                }
+            }
+        }
+
+        // Terminate with a leaf, if it is cheaper than splitting.
+        float leafCost = objectCount * m_intersectionCost;
+        if ( objectCount <= m_leafSize && ( splitAxis < 0 || leafCost <= splitCost ) )
+        {
+            _MakeLeaf( i_objectRange, *node );
+            return node;
+        }
+
+        // Partition the objects.
+        int midObjectIndex = i_objectRange.Min() + objectCount / 2;
+        if ( splitAxis >= 0 )
+        {
+            auto midIterator = std::partition( io_buildObjects.begin() + i_objectRange.Min(),
+                                               io_buildObjects.begin() + i_objectRange.Max(),
+                                               [&]( const _BuildObject& i_buildObject ) {
+                                                   return _ComputeBinIndex( i_buildObject.m_centroid,
+                                                                            centroidExtent,
+                                                                            splitAxis ) <= splitBin;
+                                               } );
+            midObjectIndex    = midIterator - io_buildObjects.begin();
+            node->m_splitAxis = splitAxis;
+        }
+        else if ( medianSplit )
+        {
+            // Split at the median centroid along the longest axis of the centroid extent.
+            gm::Vec3f centroidLengths = centroidExtent.Max() - centroidExtent.Min();
+            int       medianAxis      = centroidLengths[ 0 ] > centroidLengths[ 1 ] ? 0 : 1;
+            medianAxis                = centroidLengths[ medianAxis ] > centroidLengths[ 2 ] ? medianAxis : 2;
+            std::nth_element( io_buildObjects.begin() + i_objectRange.Min(),
+                              io_buildObjects.begin() + midObjectIndex,
+                              io_buildObjects.begin() + i_objectRange.Max(),
+                              [&]( const _BuildObject& i_lhs, const _BuildObject& i_rhs ) {
+                                  return i_lhs.m_centroid[ medianAxis ] < i_rhs.m_centroid[ medianAxis ];
+                              } );
+            node->m_splitAxis = medianAxis;
+        }
+
+        // Recursively construct left & right, which cover disjoint ranges of the build objects.
+        _ForkJoin(
+            i_threadBudget,
+            objectCount,
+            [&]( int i_childThreadBudget ) {
+                node->m_children[ 0 ] = _Build( gm::IntRange( i_objectRange.Min(), midObjectIndex ),
+                                                io_buildObjects,
+                                                i_depth + 1,
+                                                i_childThreadBudget );
+            },
+            [&]( int i_childThreadBudget ) {
+                node->m_children[ 1 ] = _Build( gm::IntRange( midObjectIndex, i_objectRange.Max() ),
+                                                io_buildObjects,
+                                                i_depth + 1,
+                                                i_childThreadBudget );
+            } );
+        return node;
+    }
+
+    // Compute the bin which a centroid falls into.
+    inline int _ComputeBinIndex( const gm::Vec3f& i_centroid, const gm::Vec3fRange& i_centroidExtent, int i_axis ) const
+    {
+        float offset = ( i_centroid[ i_axis ] - i_centroidExtent.Min()[ i_axis ] ) /
+                       ( i_centroidExtent.Max()[ i_axis ] - i_centroidExtent.Min()[ i_axis ] );
+        if ( !( offset > 0.0f ) )
+        {
+            return 0;
+        }
+
+        return std::min( ( int ) ( offset * m_binCount ), m_binCount - 1 );
+    }
+
+    // Turn \p o_node into a leaf referencing the objects within \p i_objectRange.
+    static inline void _MakeLeaf( const gm::IntRange& i_objectRange, BVHBuildNode& o_node )
+    {
+        o_node.m_objectOffset = i_objectRange.Min();
+        o_node.m_objectCount  = i_objectRange.Max() - i_objectRange.Min();
+    }
+
+    int m_binCount = 0;
+    int m_leafSize = 0;
+};
+
+RAYTRACE_NS_CLOSE
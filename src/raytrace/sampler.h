@@ -0,0 +1,167 @@
+#pragma once
+
+/// \file raytrace/sampler.h
+///
+/// Abstract base class of the sample generators, which provide the numbers each pixel sample integrates over.
+
+#include <raytrace/randomNumberGenerator.h>
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec2f.h>
+#include <gm/types/vec2i.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+RAYTRACE_NS_OPEN
+
+class Sampler;
+
+/// \typedef SamplerPtr
+///
+/// Unique ownership of a sampler.
+using SamplerPtr = std::unique_ptr< Sampler >;
+
+/// \class Sampler
+///
+/// Sampler generates the sample values, in [0, 1), of each dimension of a pixel sample.
+///
+/// A render consumes the dimensions of a sample in a fixed order: the position within the pixel, the position
+/// on the lens and the shutter time, followed by a fixed block of dimensions per bounce (see \ref Integrator).
+/// Samplers exploit this to distribute the values of each dimension well across the samples of a pixel, such
+/// that the estimate of a pixel converges faster than with independent random numbers.
+///
+/// A sampler carries the state of a single pixel sample, so each thread works with its own \ref Clone.
+/// The values are a function of the pixel, sample index, dimension and seed only, and are therefore
+/// independent of the thread and order which pixels are rendered in.
+class Sampler
+{
+public:
+    /// Explicit constructor with the number of samples per pixel.
+    ///
+    /// \param i_samplesPerPixel The number of samples which each pixel will take.
+    /// \param i_seed The seed which the sample values are randomized with.
+    inline explicit Sampler( int i_samplesPerPixel, uint32_t i_seed )
+        : m_samplesPerPixel( std::max( i_samplesPerPixel, 1 ) )
+        , m_seed( i_seed )
+    {
+    }
+
+    virtual ~Sampler() = default;
+
+    /// Create a copy of this sampler, to be used by another thread.
+    virtual SamplerPtr Clone() const = 0;
+
+    /// Begin generating the values of a new pixel sample, from its first dimension.
+    ///
+    /// \param i_pixelCoord The coordinate of the pixel.
+    /// \param i_sampleIndex The index of the sample, within the pixel.
+    inline void StartPixelSample( const gm::Vec2i& i_pixelCoord, int i_sampleIndex )
+    {
+        m_pixelKey     = ( ( uint64_t )( uint32_t ) i_pixelCoord.Y() << 32 ) | ( uint32_t ) i_pixelCoord.X();
+        m_sampleIndex  = i_sampleIndex;
+        m_sampleRandom = RandomNumberGenerator::ForSample( m_pixelKey, m_sampleIndex, m_seed );
+        SetDimension( 0 );
+    }
+
+    /// Position the sampler at a dimension of the current pixel sample.
+    ///
+    /// \param i_dimension The dimension of the next value to generate.
+    inline void SetDimension( int i_dimension )
+    {
+        // Seeking from the first dimension of the sample only takes a few steps.
+        m_dimension = i_dimension;
+        m_random    = m_sampleRandom;
+        m_random.Advance( m_dimension );
+    }
+
+    /// Generate the value of the next dimension.
+    virtual float Get1D() = 0;
+
+    /// Generate the values of the next two dimensions, which are well distributed as a pair.
+    virtual gm::Vec2f Get2D() = 0;
+
+    /// Get the number of samples per pixel.
+    inline int SamplesPerPixel() const
+    {
+        return m_samplesPerPixel;
+    }
+
+protected:
+    // The largest float below one, and 2^-32.
+    static constexpr float c_oneMinusEpsilon = 0.99999994f;
+    static constexpr float c_uint32Scale     = 1.0f / 4294967296.0f;
+
+    // Convert the 32 bits of \p i_bits into a float in [0, 1).
+    static inline float _ToFloat( uint32_t i_bits )
+    {
+        return std::min( ( float ) i_bits * c_uint32Scale, c_oneMinusEpsilon );
+    }
+
+    // Scramble the bits of \p i_value, such that nearby inputs produce unrelated outputs.
+    static inline uint32_t _MixBits( uint64_t i_value )
+    {
+        i_value ^= i_value >> 31;
+        i_value *= 0x7fb5d329728ea185ULL;
+        i_value ^= i_value >> 27;
+        i_value *= 0x81dadef4bc2dd44dULL;
+        i_value ^= i_value >> 33;
+        return ( uint32_t ) i_value;
+    }
+
+    // Compute a hash of the current pixel, seed, and \p i_dimension.
+    inline uint32_t _DimensionHash( int i_dimension ) const
+    {
+        return _MixBits( m_pixelKey ^ _MixBits( ( ( uint64_t ) m_seed << 32 ) | ( uint32_t ) i_dimension ) );
+    }
+
+    // Compute the element at \p i_index of a random permutation of [0, \p i_count), selected by \p i_hash.
+    //
+    // Reference: A. Kensler, "Correlated Multi-Jittered Sampling".
+    static inline uint32_t _PermutationElement( uint32_t i_index, uint32_t i_count, uint32_t i_hash )
+    {
+        // Cycle walk a hash over the enclosing power of two, until it lands within the range.
+        uint32_t mask = i_count - 1;
+        mask |= mask >> 1;
+        mask |= mask >> 2;
+        mask |= mask >> 4;
+        mask |= mask >> 8;
+        mask |= mask >> 16;
+        do
+        {
+            i_index ^= i_hash;
+            i_index *= 0xe170893d;
+            i_index ^= i_hash >> 16;
+            i_index ^= ( i_index & mask ) >> 4;
+            i_index ^= i_hash >> 8;
+            i_index *= 0x0929eb3f;
+            i_index ^= i_hash >> 23;
+            i_index ^= ( i_index & mask ) >> 1;
+            i_index *= 1 | i_hash >> 27;
+            i_index *= 0x6935fa69;
+            i_index ^= ( i_index & mask ) >> 11;
+            i_index *= 0x74dcb303;
+            i_index ^= ( i_index & mask ) >> 2;
+            i_index *= 0x9e501cc3;
+            i_index ^= ( i_index & mask ) >> 2;
+            i_index *= 0xc860a3df;
+            i_index &= mask;
+            i_index ^= i_index >> 5;
+        } while ( i_index >= i_count );
+
+        return ( i_index + i_hash ) % i_count;
+    }
+
+    int      m_samplesPerPixel = 1;
+    uint32_t m_seed            = 0;
+
+    // State of the current pixel sample.
+    uint64_t              m_pixelKey    = 0;
+    int                   m_sampleIndex = 0;
+    int                   m_dimension   = 0;
+    RandomNumberGenerator m_sampleRandom; // Positioned at the first dimension of the sample.
+    RandomNumberGenerator m_random;       // Positioned at the current dimension.
+};
+
+RAYTRACE_NS_CLOSE
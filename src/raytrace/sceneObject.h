@@ -7,6 +7,7 @@
 #include <raytrace/ray.h>
 
 #include <gm/types/floatRange.h>
+#include <gm/types/vec2f.h>
 #include <gm/types/vec3fRange.h>
 
 #include <memory>
@@ -15,6 +16,7 @@ RAYTRACE_NS_OPEN
 
 // Forward declarations.
 class HitRecord;
+class Material;
 
 /// \class SceneObject
 ///
@@ -27,6 +29,10 @@ public:
 
     /// Check and record if ray \p i_ray hits the current object.
     ///
+    /// This is the query performed during traversal, where most hits are later superseded by nearer ones.
+    /// Implementations should only record the magnitude, material, and the object hit (\ref HitRecord::m_object),
+    /// and defer computing the remaining surface attributes to \ref ComputeSurfaceInteraction.
+    ///
     /// \param i_ray The ray to test for hit.
     /// \param i_magnitudeRange The range of \em accepted magnitudes to qualify as a ray hit.
     /// \param o_record the record of a ray hit.
@@ -37,6 +43,31 @@ public:
     virtual bool
     Hit( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const = 0;
 
+    /// Check if ray \p i_ray hits the current object anywhere within \p i_magnitudeRange.
+    ///
+    /// This is the query performed by visibility tests, such as shadow rays, which only need to know whether the
+    /// segment is blocked.  Unlike \ref Hit, which hit is irrelevant, so implementations return as soon as any is
+    /// found, without recording it.
+    ///
+    /// \param i_ray The ray to test for hit.
+    /// \param i_magnitudeRange The range of \em accepted magnitudes to qualify as a ray hit.
+    ///
+    /// \retval true If the ray hits this object within the range of \p i_magnitudeRange.
+    /// \retval false If the ray does not hit this object within the range of \p i_magnitudeRange.
+    virtual bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const = 0;
+
+    /// Compute the surface attributes (position, normal, and texture coordinates) of a hit, recorded by
+    /// \ref Hit of this object.
+    ///
+    /// This is called once per ray, for the nearest hit only.
+    ///
+    /// \param i_ray The ray which hit this object.
+    /// \param io_record The record of the hit, to complete with the surface attributes.
+    virtual void ComputeSurfaceInteraction( const raytrace::Ray& i_ray, HitRecord& io_record ) const
+    {
+        // By default, all the attributes are recorded by Hit.
+    }
+
     /// Compute the extent containing this SceneObject over time samples \p i_times.
     ///
     /// If this SceneObject does not have a bounding volume at any of the times,
@@ -49,6 +80,57 @@ public:
     ///
     /// \return The extent of this scene object.
     virtual gm::Vec3fRange Extent( const std::vector< float >& i_times ) const = 0;
+
+    /// Get the material assigned to the surface of this object, such that emissive objects are found as lights.
+    ///
+    /// \return The material, or null if this object is not a single surface with a material.
+    virtual const Material* SurfaceMaterial() const
+    {
+        return nullptr;
+    }
+
+    /// Compute the area of the surface of this object at time \p i_time.
+    ///
+    /// \param i_time The time.
+    ///
+    /// \return The surface area, or zero if the surface cannot be sampled.
+    virtual float Area( float i_time ) const
+    {
+        return 0.0f;
+    }
+
+    /// Sample a point uniformly over the surface area of this object, at time \p i_time, for sampling the
+    /// light emitted by it.
+    ///
+    /// \param i_sample Uniformly distributed sample in [0, 1)^2, selecting the point.
+    /// \param i_time The time.
+    /// \param o_record The sampled point, recorded with its surface attributes and material, as a hit would be.
+    ///
+    /// \return Whether the surface can be sampled.
+    virtual bool SampleSurface( const gm::Vec2f& i_sample, float i_time, HitRecord& o_record ) const
+    {
+        return false;
+    }
+
+    /// Get the identifier of this object, reported by the object ID AOV.
+    ///
+    /// \return The object ID, or -1 if it has not been assigned.
+    /// \sa BuildBVH
+    inline int ObjectId() const
+    {
+        return m_objectId;
+    }
+
+    /// Set the identifier of this object.
+    ///
+    /// \param i_objectId The object ID.
+    inline void SetObjectId( int i_objectId )
+    {
+        m_objectId = i_objectId;
+    }
+
+private:
+    int m_objectId = -1;
 };
 
 /// \typedef SceneObjectPtr
@@ -0,0 +1,77 @@
+#pragma once
+
+/// \file raytrace/sceneObjectList.h
+///
+/// A flat collection of scene objects, without any acceleration structure.
+
+#include <raytrace/hitRecord.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/functions/expand.h>
+
+RAYTRACE_NS_OPEN
+
+/// \class SceneObjectList
+///
+/// SceneObjectList aggregates a collection of scene objects into a single SceneObject.
+///
+/// Hit tests are performed against \em every object in the collection, so the cost of tracing a ray
+/// grows linearly with the number of objects.  Prefer a bounding volume hierarchy for all but the
+/// smallest collections.
+class SceneObjectList : public SceneObject
+{
+public:
+    /// Explicit constructor with the collection of scene objects.
+    ///
+    /// \param i_sceneObjects The scene objects to aggregate.
+    inline explicit SceneObjectList( const SceneObjectPtrs& i_sceneObjects )
+        : m_sceneObjects( i_sceneObjects )
+    {
+    }
+
+    virtual inline bool
+    Hit( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const override
+    {
+        bool           objectHit = false;
+        gm::FloatRange magnitudeRange( i_magnitudeRange );
+        for ( const SceneObjectPtr& sceneObject : m_sceneObjects )
+        {
+            if ( sceneObject->Hit( i_ray, magnitudeRange, o_record ) )
+            {
+                // Narrow the accepted range, such that only nearer hits are recorded from here on.
+                objectHit            = true;
+                magnitudeRange.Max() = o_record.m_magnitude;
+            }
+        }
+
+        return objectHit;
+    }
+
+    virtual inline bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const override
+    {
+        for ( const SceneObjectPtr& sceneObject : m_sceneObjects )
+        {
+            if ( sceneObject->Occluded( i_ray, i_magnitudeRange ) )
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    virtual inline gm::Vec3fRange Extent( const std::vector< float >& i_times ) const override
+    {
+        gm::Vec3fRange extent;
+        for ( const SceneObjectPtr& sceneObject : m_sceneObjects )
+        {
+            extent = gm::Expand( extent, sceneObject->Extent( i_times ) );
+        }
+        return extent;
+    }
+
+private:
+    SceneObjectPtrs m_sceneObjects;
+};
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,49 @@
+#pragma once
+
+/// \file raytrace/skyTexture.h
+///
+/// A vertical gradient texture, for use as a sky-like background.
+
+#include <raytrace/texture.h>
+
+#include <gm/functions/linearInterpolation.h>
+
+RAYTRACE_NS_OPEN
+
+/// \class SkyTexture
+///
+/// SkyTexture blends between a bottom and a top color, based on the vertical (Y) component of the
+/// sampled position.
+///
+/// When used as a background, the texture is sampled with the direction of the escaping ray as the position.
+class SkyTexture : public Texture
+{
+public:
+    /// Explicit constructor with the colors at either end of the gradient.
+    ///
+    /// \param i_bottomColor The color towards the bottom of the sky.
+    /// \param i_topColor The color towards the top of the sky.
+    inline explicit SkyTexture( const gm::Vec3f& i_bottomColor, const gm::Vec3f& i_topColor )
+        : m_bottomColor( i_bottomColor )
+        , m_topColor( i_topColor )
+    {
+    }
+
+    /// Sample the gradient.
+    ///
+    /// \param i_uv This coordinate has no affect on the sampled color.
+    /// \param i_position The direction of the ray escaping the scene.
+    ///
+    /// \return The interpolated sky color.
+    inline virtual gm::Vec3f Sample( const gm::Vec2f& i_uv, const gm::Vec3f& i_position ) const override
+    {
+        float weight = 0.5f * i_position.Y() + 1.0;
+        return gm::LinearInterpolation( m_bottomColor, m_topColor, weight );
+    }
+
+private:
+    gm::Vec3f m_bottomColor;
+    gm::Vec3f m_topColor;
+};
+
+RAYTRACE_NS_CLOSE
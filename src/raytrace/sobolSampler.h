@@ -0,0 +1,111 @@
+#pragma once
+
+/// \file raytrace/sobolSampler.h
+///
+/// Sampler producing values from the Owen-scrambled Sobol sequence.
+
+#include <raytrace/sampler.h>
+
+RAYTRACE_NS_OPEN
+
+/// \class SobolSampler
+///
+/// SobolSampler produces each pair of dimensions from the first two dimensions of the Sobol sequence, which
+/// form a (0, 2)-sequence in base 2: every power of two prefix of the samples is stratified over all the
+/// elementary intervals of the unit square.
+///
+/// The values are Owen scrambled with a hash-based nested uniform scramble, seeded per pixel and dimension.
+/// Each pair of dimensions also visits the sequence in its own scrambled order of the sample index, which
+/// decorrelates the pairs from each other while keeping their stratification ("padding").  Sample counts which
+/// are powers of two are best stratified.
+///
+/// Reference: B. Burley, "Practical Hash-based Owen Scrambling".
+class SobolSampler : public Sampler
+{
+public:
+    /// Explicit constructor with the number of samples per pixel.
+    ///
+    /// \param i_samplesPerPixel The number of samples which each pixel will take.
+    /// \param i_seed The seed which the sample values are randomized with.
+    inline explicit SobolSampler( int i_samplesPerPixel, uint32_t i_seed = 0 )
+        : Sampler( i_samplesPerPixel, i_seed )
+    {
+    }
+
+    virtual inline SamplerPtr Clone() const override
+    {
+        return SamplerPtr( new SobolSampler( *this ) );
+    }
+
+    virtual inline float Get1D() override
+    {
+        uint32_t hash  = _DimensionHash( m_dimension );
+        uint32_t index = _NestedUniformScramble( m_sampleIndex, hash );
+        m_dimension += 1;
+        return _ToFloat( _NestedUniformScramble( _ReverseBits( index ), _MixBits( hash ) ) );
+    }
+
+    virtual inline gm::Vec2f Get2D() override
+    {
+        uint32_t hash  = _DimensionHash( m_dimension );
+        uint32_t index = _NestedUniformScramble( m_sampleIndex, hash );
+        m_dimension += 2;
+
+        // The first Sobol dimension is the van der Corput sequence, ie. the reversed bits of the index.
+        uint32_t x = _ReverseBits( index );
+        uint32_t y = _SobolSecondDimension( index );
+        return gm::Vec2f( _ToFloat( _NestedUniformScramble( x, _MixBits( ( uint64_t ) hash << 1 ) ) ),
+                          _ToFloat( _NestedUniformScramble( y, _MixBits( ( ( uint64_t ) hash << 1 ) | 1 ) ) ) );
+    }
+
+private:
+    // Compute the second dimension of the Sobol sequence, for \p i_index.
+    static inline uint32_t _SobolSecondDimension( uint32_t i_index )
+    {
+        // The direction numbers of the primitive polynomial x + 1: each is the previous, xor'd with itself
+        // shifted right by one.
+        uint32_t value     = 0;
+        uint32_t direction = 1u << 31;
+        for ( ; i_index != 0; i_index >>= 1 )
+        {
+            if ( i_index & 1 )
+            {
+                value ^= direction;
+            }
+            direction ^= direction >> 1;
+        }
+        return value;
+    }
+
+    // Reverse the order of the bits of \p i_value.
+    static inline uint32_t _ReverseBits( uint32_t i_value )
+    {
+        i_value = ( i_value << 16 ) | ( i_value >> 16 );
+        i_value = ( ( i_value & 0x00ff00ff ) << 8 ) | ( ( i_value & 0xff00ff00 ) >> 8 );
+        i_value = ( ( i_value & 0x0f0f0f0f ) << 4 ) | ( ( i_value & 0xf0f0f0f0 ) >> 4 );
+        i_value = ( ( i_value & 0x33333333 ) << 2 ) | ( ( i_value & 0xcccccccc ) >> 2 );
+        i_value = ( ( i_value & 0x55555555 ) << 1 ) | ( ( i_value & 0xaaaaaaaa ) >> 1 );
+        return i_value;
+    }
+
+    // Hash \p i_value such that each bit only depends on the bits below it.
+    //
+    // Reference: S. Laine and T. Karras, "Stratified Sampling for Stochastic Transparency".
+    static inline uint32_t _LaineKarrasPermutation( uint32_t i_value, uint32_t i_seed )
+    {
+        i_value += i_seed;
+        i_value ^= i_value * 0x6c50b47cu;
+        i_value ^= i_value * 0xb82f1e52u;
+        i_value ^= i_value * 0xc7afe638u;
+        i_value ^= i_value * 0x8d22f6e6u;
+        return i_value;
+    }
+
+    // Owen scramble \p i_value, where each bit is flipped based on a hash of the bits above it.
+    static inline uint32_t _NestedUniformScramble( uint32_t i_value, uint32_t i_seed )
+    {
+        return _ReverseBits( _LaineKarrasPermutation( _ReverseBits( i_value ), i_seed ) );
+    }
+};
+
+RAYTRACE_NS_CLOSE
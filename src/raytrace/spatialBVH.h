@@ -141,6 +141,19 @@ public:
         return hitLeft || hitRight;
     }
 
+    virtual inline bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const override
+    {
+        gm::FloatRange intersections;
+        if ( !gm::RayAABBIntersection( i_ray.Origin(), i_ray.Direction(), m_extent, intersections ) ||
+             intersections.Min() > i_magnitudeRange.Max() )
+        {
+            return false;
+        }
+
+        return ( m_left && m_left->Occluded( i_ray, i_magnitudeRange ) ) ||
+               ( m_right && m_right->Occluded( i_ray, i_magnitudeRange ) );
+    }
+
     virtual gm::Vec3fRange Extent( const std::vector< float >& i_times ) const override
     {
         return m_extent;
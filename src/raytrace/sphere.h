@@ -5,6 +5,8 @@
 /// Representation of a ray-traceable sphere.
 
 #include <raytrace/attribute.h>
+#include <raytrace/hitRecord.h>
+#include <raytrace/randomUnitVector.h>
 #include <raytrace/ray.h>
 #include <raytrace/sceneObject.h>
 
@@ -63,12 +65,12 @@ public:
         {
             if ( gm::Contains( i_magnitudeRange, intersections.Min() ) )
             {
-                _RecordHit( i_ray, intersections.Min(), o_record );
+                _RecordHit( intersections.Min(), o_record );
                 return true;
             }
             else if ( gm::Contains( i_magnitudeRange, intersections.Max() ) )
             {
-                _RecordHit( i_ray, intersections.Max(), o_record );
+                _RecordHit( intersections.Max(), o_record );
                 return true;
             }
         }
@@ -77,6 +79,25 @@ public:
         return false;
     }
 
+    virtual inline bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const override
+    {
+        gm::FloatRange intersections;
+        return gm::RaySphereIntersection( m_origin.Value( i_ray.Time() ),
+                                          m_radius,
+                                          i_ray.Origin(),
+                                          i_ray.Direction(),
+                                          intersections ) > 0 &&
+               ( gm::Contains( i_magnitudeRange, intersections.Min() ) ||
+                 gm::Contains( i_magnitudeRange, intersections.Max() ) );
+    }
+
+    virtual inline void ComputeSurfaceInteraction( const raytrace::Ray& i_ray, HitRecord& io_record ) const override
+    {
+        io_record.m_position = gm::RayPosition( i_ray.Origin(), i_ray.Direction(), io_record.m_magnitude );
+        io_record.m_normal   = ( io_record.m_position - m_origin.Value( i_ray.Time() ) ) / m_radius;
+        io_record.m_uv       = _ComputeUV( io_record.m_normal );
+    }
+
     virtual inline gm::Vec3fRange Extent( const std::vector< float >& i_times ) const override
     {
         gm::Vec3fRange extent;
@@ -98,19 +119,37 @@ public:
         return extent;
     }
 
+    virtual inline const Material* SurfaceMaterial() const override
+    {
+        return m_material.get();
+    }
+
+    virtual inline float Area( float i_time ) const override
+    {
+        return 4.0f * gm::Pi * m_radius * m_radius;
+    }
+
+    virtual inline bool SampleSurface( const gm::Vec2f& i_sample, float i_time, HitRecord& o_record ) const override
+    {
+        o_record.m_normal   = RandomUnitVector( i_sample );
+        o_record.m_position = m_origin.Value( i_time ) + o_record.m_normal * m_radius;
+        o_record.m_uv       = _ComputeUV( o_record.m_normal );
+        o_record.m_material = m_material.get();
+        o_record.m_object   = this;
+        return true;
+    }
+
 private:
-    /// Helper method to record a ray hitting the sphere.
+    /// Helper method to record a ray hitting the sphere.  Surface attributes are deferred to
+    /// \ref ComputeSurfaceInteraction.
     ///
-    /// \param i_ray The ray.
     /// \param i_rayMagnitude the magnitude of the ray intersection.
     /// \param o_record the record of a ray hit.
-    inline void _RecordHit( const raytrace::Ray& i_ray, float i_rayMagnitude, HitRecord& o_record ) const
+    inline void _RecordHit( float i_rayMagnitude, HitRecord& o_record ) const
     {
-        o_record.m_position  = gm::RayPosition( i_ray.Origin(), i_ray.Direction(), i_rayMagnitude );
-        o_record.m_normal    = ( o_record.m_position - m_origin.Value( i_ray.Time() ) ) / m_radius;
-        o_record.m_uv        = _ComputeUV( o_record.m_normal );
         o_record.m_magnitude = i_rayMagnitude;
-        o_record.m_material  = m_material;
+        o_record.m_material  = m_material.get();
+        o_record.m_object    = this;
     }
 
     /// Helper method to compute the normalised UV coordinates for a sphere, given the surface normal.
@@ -0,0 +1,78 @@
+#pragma once
+
+/// \file raytrace/stratifiedSampler.h
+///
+/// Sampler producing jittered, stratified values.
+
+#include <raytrace/sampler.h>
+
+#include <cmath>
+
+RAYTRACE_NS_OPEN
+
+/// \class StratifiedSampler
+///
+/// StratifiedSampler divides the domain of each dimension into one stratum per pixel sample, and places
+/// each sample at a random position within its own stratum.
+///
+/// Pairs of dimensions are stratified over a grid of \ref StrataX by \ref StrataY cells, whose product is the
+/// number of samples per pixel.  The strata are assigned to samples through a random permutation per pixel
+/// and dimension, such that the strata of different dimensions are uncorrelated.
+class StratifiedSampler : public Sampler
+{
+public:
+    /// Explicit constructor with the number of samples per pixel.
+    ///
+    /// \param i_samplesPerPixel The number of samples which each pixel will take.
+    /// \param i_seed The seed which the sample values are randomized with.
+    inline explicit StratifiedSampler( int i_samplesPerPixel, uint32_t i_seed = 0 )
+        : Sampler( i_samplesPerPixel, i_seed )
+    {
+        // Choose the most square grid which has exactly one cell per sample.
+        m_strataX = ( int ) std::sqrt( ( float ) m_samplesPerPixel );
+        while ( m_samplesPerPixel % m_strataX != 0 )
+        {
+            --m_strataX;
+        }
+        m_strataY = m_samplesPerPixel / m_strataX;
+    }
+
+    virtual inline SamplerPtr Clone() const override
+    {
+        return SamplerPtr( new StratifiedSampler( *this ) );
+    }
+
+    virtual inline float Get1D() override
+    {
+        uint32_t stratum = _PermutationElement( m_sampleIndex, m_samplesPerPixel, _DimensionHash( m_dimension ) );
+        m_dimension += 1;
+        return ( ( float ) stratum + m_random.UniformFloat() ) / ( float ) m_samplesPerPixel;
+    }
+
+    virtual inline gm::Vec2f Get2D() override
+    {
+        uint32_t stratum = _PermutationElement( m_sampleIndex, m_samplesPerPixel, _DimensionHash( m_dimension ) );
+        m_dimension += 2;
+        float x = ( ( float ) ( stratum % m_strataX ) + m_random.UniformFloat() ) / ( float ) m_strataX;
+        float y = ( ( float ) ( stratum / m_strataX ) + m_random.UniformFloat() ) / ( float ) m_strataY;
+        return gm::Vec2f( x, y );
+    }
+
+    /// Get the number of strata along the first dimension of a pair.
+    inline int StrataX() const
+    {
+        return m_strataX;
+    }
+
+    /// Get the number of strata along the second dimension of a pair.
+    inline int StrataY() const
+    {
+        return m_strataY;
+    }
+
+private:
+    int m_strataX = 1;
+    int m_strataY = 1;
+};
+
+RAYTRACE_NS_CLOSE
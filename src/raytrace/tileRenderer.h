@@ -0,0 +1,287 @@
+#pragma once
+
+/// \file raytrace/tileRenderer.h
+///
+/// Multi-threaded, tile-based distribution of per-pixel work.
+
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec2i.h>
+#include <gm/types/vec2iRange.h>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class TileRenderer
+///
+/// TileRenderer partitions an image extent into rectangular tiles, and distributes them across a pool
+/// of worker threads.
+///
+/// Each worker owns a queue of spatially coherent tiles.  Once a worker has drained its own queue, it will
+/// \em steal tiles from the back of the other workers' queues.  Stolen tiles which are larger than the minimum
+/// tile size are split into quarters before being processed, such that the granularity of work becomes finer
+/// towards the end of a render, where load imbalance would otherwise leave threads idle.
+///
+/// Tiles are disjoint, so each pixel is visited by exactly one thread.  Callers may write pixel results
+/// directly into an image buffer without any synchronization.
+class TileRenderer
+{
+public:
+    /// Explicit constructor with the number of worker threads and tile size.
+    ///
+    /// \param i_threadCount The number of worker threads.  If zero or negative, the number of concurrent
+    /// threads supported by the hardware is used.
+    /// \param i_tileSize The edge length of a tile, in pixels.  If zero or negative, the tile size is computed
+    /// from the image extent and thread count.
+    inline explicit TileRenderer( int i_threadCount = 0, int i_tileSize = 0 )
+        : m_threadCount( i_threadCount )
+        , m_tileSize( i_tileSize )
+    {
+        if ( m_threadCount <= 0 )
+        {
+            m_threadCount = std::max( 1, ( int ) std::thread::hardware_concurrency() );
+        }
+    }
+
+    /// Get the number of worker threads used for rendering.
+    ///
+    /// \return The thread count.
+    inline int ThreadCount() const
+    {
+        return m_threadCount;
+    }
+
+    /// Compute the tile edge length used for an image extent.
+    ///
+    /// If a tile size was not explicitly specified, one is chosen such that each worker thread receives
+    /// several tiles, which gives the scheduler enough slack to balance the load.
+    ///
+    /// \param i_extent The image extent.
+    ///
+    /// \return The tile edge length, in pixels.
+    inline int ComputeTileSize( const gm::Vec2iRange& i_extent ) const
+    {
+        if ( m_tileSize > 0 )
+        {
+            return m_tileSize;
+        }
+
+        gm::Vec2i dimensions = i_extent.Max() - i_extent.Min();
+        float     pixelCount = ( float ) dimensions.X() * ( float ) dimensions.Y();
+        int       tileSize   = ( int ) std::sqrt( pixelCount / ( float ) ( m_threadCount * c_tilesPerThread ) );
+        return std::min( std::max( tileSize, ( int ) c_minTileSize ), ( int ) c_maxTileSize );
+    }
+
+    /// Partition an image extent into tiles, in row-major order.
+    ///
+    /// \param i_extent The image extent.
+    ///
+    /// \return The tiles covering the image extent.
+    inline std::vector< gm::Vec2iRange > ComputeTiles( const gm::Vec2iRange& i_extent ) const
+    {
+        int                           tileSize = ComputeTileSize( i_extent );
+        std::vector< gm::Vec2iRange > tiles;
+        for ( int yCoord = i_extent.Min().Y(); yCoord < i_extent.Max().Y(); yCoord += tileSize )
+        {
+            for ( int xCoord = i_extent.Min().X(); xCoord < i_extent.Max().X(); xCoord += tileSize )
+            {
+                tiles.push_back( gm::Vec2iRange( gm::Vec2i( xCoord, yCoord ),
+                                                 gm::Vec2i( std::min( xCoord + tileSize, i_extent.Max().X() ),
+                                                            std::min( yCoord + tileSize, i_extent.Max().Y() ) ) ) );
+            }
+        }
+        return tiles;
+    }
+
+    /// Invoke \p i_tileFunction for every tile of \p i_extent, in parallel.
+    ///
+    /// This call blocks until all the tiles have been processed.
+    ///
+    /// \tparam TileFunctionT Callable with the signature void( const gm::Vec2iRange& i_tile ).
+    ///
+    /// \param i_extent The image extent to partition into tiles.
+    /// \param i_tileFunction The function invoked per-tile.  It will be called concurrently from multiple threads.
+    template < typename TileFunctionT >
+    inline void ForEachTile( const gm::Vec2iRange& i_extent, TileFunctionT i_tileFunction ) const
+    {
+        std::vector< gm::Vec2iRange > tiles = ComputeTiles( i_extent );
+        if ( tiles.empty() )
+        {
+            return;
+        }
+
+        int workerCount = std::min( m_threadCount, ( int ) tiles.size() );
+        if ( workerCount == 1 )
+        {
+            // Nothing to distribute, process inline.
+            for ( const gm::Vec2iRange& tile : tiles )
+            {
+                i_tileFunction( tile );
+            }
+            return;
+        }
+
+        // Seed each worker queue with a contiguous run of tiles, to retain spatial locality.
+        std::unique_ptr< _TileQueue[] > queues( new _TileQueue[ workerCount ] );
+        for ( size_t tileIndex = 0; tileIndex < tiles.size(); ++tileIndex )
+        {
+            queues[ ( tileIndex * workerCount ) / tiles.size() ].m_tiles.push_back( tiles[ tileIndex ] );
+        }
+
+        // The calling thread participates as the first worker.
+        std::vector< std::thread > threads;
+        threads.reserve( workerCount - 1 );
+        for ( int workerIndex = 1; workerIndex < workerCount; ++workerIndex )
+        {
+            threads.push_back( std::thread( [&, workerIndex]() {
+                _RunWorker( workerIndex, workerCount, queues.get(), i_tileFunction );
+            } ) );
+        }
+
+        _RunWorker( 0, workerCount, queues.get(), i_tileFunction );
+
+        for ( std::thread& thread : threads )
+        {
+            thread.join();
+        }
+    }
+
+    /// Invoke \p i_pixelFunction for every pixel coordinate of \p i_extent, in parallel.
+    ///
+    /// \tparam PixelFunctionT Callable with the signature void( const gm::Vec2i& i_pixelCoord ).
+    ///
+    /// \param i_extent The image extent.
+    /// \param i_pixelFunction The function invoked per-pixel.  It will be called concurrently from multiple threads.
+    template < typename PixelFunctionT >
+    inline void ForEachPixel( const gm::Vec2iRange& i_extent, PixelFunctionT i_pixelFunction ) const
+    {
+        ForEachTile( i_extent, [&]( const gm::Vec2iRange& i_tile ) {
+            for ( int yCoord = i_tile.Min().Y(); yCoord < i_tile.Max().Y(); ++yCoord )
+            {
+                for ( int xCoord = i_tile.Min().X(); xCoord < i_tile.Max().X(); ++xCoord )
+                {
+                    i_pixelFunction( gm::Vec2i( xCoord, yCoord ) );
+                }
+            }
+        } );
+    }
+
+    /// Invoke \p i_bandFunction for bands of consecutive rows covering [0, \p i_rowCount), in parallel.
+    ///
+    /// Bands are processed as tiles which are one pixel wide, and as tall as the tile size.  Such tiles are never
+    /// split, so each band starts at a multiple of the tile size.
+    ///
+    /// \tparam BandFunctionT Callable with the signature void( int i_beginRow, int i_endRow ).
+    ///
+    /// \param i_rowCount The number of rows.
+    /// \param i_bandFunction The function invoked per-band.  It will be called concurrently from multiple threads.
+    template < typename BandFunctionT >
+    inline void ForEachRowBand( int i_rowCount, BandFunctionT i_bandFunction ) const
+    {
+        ForEachTile( gm::Vec2iRange( gm::Vec2i( 0, 0 ), gm::Vec2i( 1, i_rowCount ) ),
+                     [&]( const gm::Vec2iRange& i_band ) { i_bandFunction( i_band.Min().Y(), i_band.Max().Y() ); } );
+    }
+
+private:
+    // The preferred number of tiles per worker, when computing the tile size.
+    static constexpr int c_tilesPerThread = 16;
+
+    // Bounds of the computed tile size.
+    static constexpr int c_minTileSize = 8;
+    static constexpr int c_maxTileSize = 64;
+
+    // A queue of tiles owned by a single worker.
+    struct _TileQueue
+    {
+        std::mutex                   m_mutex;
+        std::deque< gm::Vec2iRange > m_tiles;
+    };
+
+    // Pop the next tile from the front of the worker's own queue.
+    static bool _PopTile( _TileQueue& io_queue, gm::Vec2iRange& o_tile )
+    {
+        std::lock_guard< std::mutex > lock( io_queue.m_mutex );
+        if ( io_queue.m_tiles.empty() )
+        {
+            return false;
+        }
+
+        o_tile = io_queue.m_tiles.front();
+        io_queue.m_tiles.pop_front();
+        return true;
+    }
+
+    // Steal a tile from the back of another worker's queue, which is the tile farthest away from
+    // the region the victim is currently working on.
+    static bool _StealTile( int i_workerIndex, int i_workerCount, _TileQueue* io_queues, gm::Vec2iRange& o_tile )
+    {
+        for ( int offset = 1; offset < i_workerCount; ++offset )
+        {
+            _TileQueue&                   victim = io_queues[ ( i_workerIndex + offset ) % i_workerCount ];
+            std::lock_guard< std::mutex > lock( victim.m_mutex );
+            if ( !victim.m_tiles.empty() )
+            {
+                o_tile = victim.m_tiles.back();
+                victim.m_tiles.pop_back();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Split a stolen tile into quarters.  One quarter is returned through \p io_tile, the remaining are
+    // pushed into the thief's own queue, where they can in turn be stolen.
+    static void _SplitStolenTile( _TileQueue& io_queue, gm::Vec2iRange& io_tile )
+    {
+        gm::Vec2i dimensions = io_tile.Max() - io_tile.Min();
+        if ( dimensions.X() < 2 * c_minTileSize || dimensions.Y() < 2 * c_minTileSize )
+        {
+            return;
+        }
+
+        gm::Vec2i                     mid = io_tile.Min() + gm::Vec2i( dimensions.X() / 2, dimensions.Y() / 2 );
+        std::lock_guard< std::mutex > lock( io_queue.m_mutex );
+        io_queue.m_tiles.push_back( gm::Vec2iRange( gm::Vec2i( mid.X(), io_tile.Min().Y() ),
+                                                    gm::Vec2i( io_tile.Max().X(), mid.Y() ) ) );
+        io_queue.m_tiles.push_back( gm::Vec2iRange( gm::Vec2i( io_tile.Min().X(), mid.Y() ),
+                                                    gm::Vec2i( mid.X(), io_tile.Max().Y() ) ) );
+        io_queue.m_tiles.push_back( gm::Vec2iRange( mid, io_tile.Max() ) );
+        io_tile = gm::Vec2iRange( io_tile.Min(), mid );
+    }
+
+    // Worker loop: drain the own queue, then steal until all queues are empty.
+    template < typename TileFunctionT >
+    static void
+    _RunWorker( int i_workerIndex, int i_workerCount, _TileQueue* io_queues, const TileFunctionT& i_tileFunction )
+    {
+        _TileQueue&    ownQueue = io_queues[ i_workerIndex ];
+        gm::Vec2iRange tile;
+        while ( true )
+        {
+            if ( !_PopTile( ownQueue, tile ) )
+            {
+                if ( !_StealTile( i_workerIndex, i_workerCount, io_queues, tile ) )
+                {
+                    return;
+                }
+
+                _SplitStolenTile( ownQueue, tile );
+            }
+
+            i_tileFunction( tile );
+        }
+    }
+
+    int m_threadCount = 1;
+    int m_tileSize    = 0;
+};
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,277 @@
+#pragma once
+
+/// \file raytrace/tileStreamWriter.h
+///
+/// Asynchronous writing of finished tiles into an image file on disk.
+
+#include <raytrace/imageBuffer.h>
+#include <raytrace/pfmImageWriter.h>
+#include <raytrace/postProcessor.h>
+#include <raytrace/ppmImageWriter.h>
+#include <raytrace/quantizeColorChannel.h>
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec2iRange.h>
+#include <gm/types/vec3f.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class TileStreamWriter
+///
+/// TileStreamWriter writes tiles of an image into a file, as they finish rendering, such that the full image
+/// never needs to be held in memory.
+///
+/// The file is pre-sized when opened, then a writer thread encodes each submitted tile and writes its rows into
+/// place.  Only formats with a fixed size per pixel can be written this way:
+/// - PFM: the linear radiance, written as is.
+/// - PPM: the radiance graded by a \ref PostProcessor, then quantized into 8 bits.
+///
+/// At most a fixed number of tiles are queued for writing.  Submitting a tile to a full queue blocks until the
+/// writer thread catches up, which bounds the memory held by finished tiles.
+class TileStreamWriter
+{
+public:
+    /// \enum Format
+    ///
+    /// The image file formats which can be streamed.
+    enum class Format
+    {
+        PPM,
+        PFM
+    };
+
+    /// Explicit constructor with the file format, image dimensions, and post processor.
+    ///
+    /// \param i_format The image file format to write.
+    /// \param i_width The width of the image.
+    /// \param i_height The height of the image.
+    /// \param i_postProcessor The post processor grading the radiance of PPM files.
+    /// \param i_maxQueuedTiles The number of submitted tiles which may wait to be written.
+    inline explicit TileStreamWriter( Format               i_format,
+                                      int                  i_width,
+                                      int                  i_height,
+                                      const PostProcessor& i_postProcessor,
+                                      int                  i_maxQueuedTiles )
+        : m_format( i_format )
+        , m_width( i_width )
+        , m_height( i_height )
+        , m_postProcessor( i_postProcessor )
+        , m_maxQueuedTiles( std::max( i_maxQueuedTiles, 1 ) )
+    {
+    }
+
+    /// Waits for the queued tiles to be written, and closes the file.
+    inline ~TileStreamWriter()
+    {
+        Close();
+    }
+
+    /// Create the file at location \p i_filePath, pre-sized to hold the whole image, and start the writer thread.
+    ///
+    /// \param i_filePath file location to save the image.
+    ///
+    /// \return success of creating the file.
+    inline bool Open( const std::string& i_filePath )
+    {
+        m_filePath = i_filePath;
+        m_fileStream.open( i_filePath.c_str(), std::ios::out | std::ios::trunc | std::ios::binary );
+        if ( !m_fileStream.is_open() )
+        {
+            fprintf( stderr, "Cannot open file '%s' for writing!\n", i_filePath.c_str() );
+            return false;
+        }
+
+        std::string header =
+            m_format == Format::PFM ? PFMHeader( m_width, m_height ) : PPMHeader( m_width, m_height );
+        m_pixelsOffset = header.size();
+        m_fileStream.write( header.data(), header.size() );
+
+        // Pre-size the file, by writing its last byte.
+        size_t fileSize = m_pixelsOffset + ( size_t ) m_width * m_height * _PixelSize();
+        if ( fileSize > m_pixelsOffset )
+        {
+            m_fileStream.seekp( fileSize - 1 );
+            m_fileStream.put( 0 );
+        }
+
+        if ( !m_fileStream )
+        {
+            fprintf( stderr, "Failed to write image '%s'!\n", i_filePath.c_str() );
+            return false;
+        }
+
+        m_thread = std::thread( [this]() { _RunWriter(); } );
+        return true;
+    }
+
+    /// Submit the finished tile \p i_tile of the image, to be written asynchronously.
+    ///
+    /// Blocks while the queue of tiles waiting to be written is full.
+    ///
+    /// \param i_tile The extent of the tile, within the image.
+    /// \param i_radiance The linear radiance of the pixels of the tile, whose dimensions match \p i_tile.
+    inline void Submit( const gm::Vec2iRange& i_tile, RGBImageBuffer&& i_radiance )
+    {
+        std::unique_lock< std::mutex > lock( m_mutex );
+        m_notFull.wait( lock, [this]() { return ( int ) m_queue.size() < m_maxQueuedTiles; } );
+        m_queue.push_back( _Tile{i_tile, std::move( i_radiance )} );
+        m_notEmpty.notify_one();
+    }
+
+    /// Wait for the submitted tiles to be written, and close the file.
+    ///
+    /// \return success of writing all the submitted tiles.
+    inline bool Close()
+    {
+        if ( m_thread.joinable() )
+        {
+            {
+                std::lock_guard< std::mutex > lock( m_mutex );
+                m_isClosing = true;
+            }
+            m_notEmpty.notify_one();
+            m_thread.join();
+        }
+
+        if ( m_fileStream.is_open() )
+        {
+            m_fileStream.close();
+            if ( !m_fileStream )
+            {
+                m_hasFailed = true;
+            }
+
+            if ( m_hasFailed )
+            {
+                fprintf( stderr, "Failed to write image '%s'!\n", m_filePath.c_str() );
+            }
+        }
+
+        return !m_hasFailed;
+    }
+
+private:
+    // A finished tile, waiting to be written.
+    struct _Tile
+    {
+        gm::Vec2iRange m_extent;
+        RGBImageBuffer m_radiance;
+    };
+
+    // The number of bytes which encode a pixel.
+    inline size_t _PixelSize() const
+    {
+        return m_format == Format::PFM ? sizeof( gm::Vec3f ) : 3;
+    }
+
+    // Writer thread loop: write queued tiles, until closed and the queue is drained.
+    inline void _RunWriter()
+    {
+        std::vector< uint8_t > row;
+        while ( true )
+        {
+            _Tile tile{gm::Vec2iRange(), RGBImageBuffer( 0, 0 )};
+            {
+                std::unique_lock< std::mutex > lock( m_mutex );
+                m_notEmpty.wait( lock, [this]() { return !m_queue.empty() || m_isClosing; } );
+                if ( m_queue.empty() )
+                {
+                    return;
+                }
+
+                tile = std::move( m_queue.front() );
+                m_queue.pop_front();
+            }
+            m_notFull.notify_one();
+
+            _WriteTile( tile, row );
+        }
+    }
+
+    // Encode the rows of \p i_tile into \p io_row, and write each into place in the file.
+    inline void _WriteTile( const _Tile& i_tile, std::vector< uint8_t >& io_row )
+    {
+        const RGBImageBuffer* pixels = &i_tile.m_radiance;
+        RGBImageBuffer        gradedPixels( 0, 0 );
+        if ( m_format == Format::PPM )
+        {
+            m_postProcessor.Apply( i_tile.m_radiance, gradedPixels );
+            pixels = &gradedPixels;
+        }
+
+        int tileWidth = pixels->Width();
+        io_row.resize( tileWidth * _PixelSize() );
+        for ( int tileY = 0; tileY < pixels->Height(); ++tileY )
+        {
+            // PFM rows are stored from the bottom up, PPM rows from the top down.
+            int    yCoord  = i_tile.m_extent.Min().Y() + tileY;
+            int    fileRow = m_format == Format::PFM ? yCoord : m_height - 1 - yCoord;
+            size_t offset =
+                m_pixelsOffset + ( ( size_t ) fileRow * m_width + i_tile.m_extent.Min().X() ) * _PixelSize();
+
+            uint8_t* output = io_row.data();
+            for ( int tileX = 0; tileX < tileWidth; ++tileX )
+            {
+                const gm::Vec3f& pixel = ( *pixels )( tileX, tileY );
+                if ( m_format == Format::PFM )
+                {
+                    std::memcpy( output, &pixel, sizeof( gm::Vec3f ) );
+                    output += sizeof( gm::Vec3f );
+                }
+                else
+                {
+                    *output++ = QuantizeColorChannel( pixel[ 0 ] );
+                    *output++ = QuantizeColorChannel( pixel[ 1 ] );
+                    *output++ = QuantizeColorChannel( pixel[ 2 ] );
+                }
+            }
+
+            m_fileStream.seekp( offset );
+            m_fileStream.write( reinterpret_cast< const char* >( io_row.data() ), io_row.size() );
+        }
+
+        if ( !m_fileStream )
+        {
+            m_hasFailed = true;
+        }
+    }
+
+    Format        m_format = Format::PPM;
+    int           m_width  = 0;
+    int           m_height = 0;
+    PostProcessor m_postProcessor;
+    int           m_maxQueuedTiles = 1;
+
+    std::string   m_filePath;
+    std::ofstream m_fileStream;
+    size_t        m_pixelsOffset = 0;
+    bool          m_hasFailed    = false;
+
+    // The queue of tiles waiting to be written, and its synchronization with the writer thread.
+    std::thread             m_thread;
+    std::mutex              m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    std::deque< _Tile >     m_queue;
+    bool                    m_isClosing = false;
+};
+
+/// \typedef TileStreamWriterPtr
+///
+/// Unique pointer to a tile stream writer.
+using TileStreamWriterPtr = std::unique_ptr< TileStreamWriter >;
+
+RAYTRACE_NS_CLOSE
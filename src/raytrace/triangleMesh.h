@@ -0,0 +1,495 @@
+#pragma once
+
+/// \file raytrace/triangleMesh.h
+///
+/// Representation of a ray-traceable triangle mesh, with its own bounding volume hierarchy over the triangles.
+///
+/// Triangles are intersected 4 at a time with SSE instructions when available, otherwise with a scalar
+/// implementation.
+
+#include <raytrace/bvhBuildNode.h>
+#include <raytrace/hitRecord.h>
+#include <raytrace/linearBVH.h>
+#include <raytrace/material.h>
+#include <raytrace/ray.h>
+#include <raytrace/sahBVHBuilder.h>
+#include <raytrace/sceneObject.h>
+#include <raytrace/triangleMeshData.h>
+
+#include <gm/base/diagnostic.h>
+
+#include <gm/functions/crossProduct.h>
+#include <gm/functions/expand.h>
+#include <gm/functions/normalize.h>
+
+#include <gm/types/floatRange.h>
+#include <gm/types/vec2f.h>
+#include <gm/types/vec3f.h>
+#include <gm/types/vec3fRange.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+RAYTRACE_NS_OPEN
+
+/// \class TriangleMesh
+///
+/// TriangleMesh is a surface composed of the triangles of a \ref TriangleMeshData, as a single scene object.
+///
+/// Rather than each triangle being its own scene object, the mesh builds a bounding volume hierarchy over the
+/// triangle indices, whose leaves hold packets of up to 4 triangles with their vertex positions stored in
+/// structure-of-arrays form.  A ray is tested against a whole packet at once, with the watertight ray-triangle
+/// test of Woop et al., "Watertight Ray/Triangle Intersection", which never lets a ray slip through the shared
+/// edge of two triangles.
+///
+/// The triangle hit and its barycentric coordinates are recorded during traversal, then the position, normal &
+/// texture coordinates are interpolated from the vertices by \ref ComputeSurfaceInteraction.
+class TriangleMesh : public SceneObject
+{
+public:
+    /// Construct a static triangle mesh, and build the hierarchy over its triangles.
+    ///
+    /// \pre \p i_data must be valid (see \ref TriangleMeshData::IsValid).
+    ///
+    /// \param i_data The vertex & index buffers of the mesh.
+    /// \param i_material Optional material assigned to the mesh.
+    /// \param i_threadCount The number of threads to build the hierarchy with.  If zero or negative, the number of
+    /// concurrent threads supported by the hardware is used.
+    inline explicit TriangleMesh( TriangleMeshDataSharedPtr i_data,
+                                  MaterialSharedPtr         i_material    = nullptr,
+                                  int                       i_threadCount = 1 )
+        : m_data( i_data )
+        , m_material( i_material )
+    {
+        GM_ASSERT( m_data != nullptr && m_data->IsValid() );
+        _Build( i_threadCount );
+    }
+
+    virtual inline bool
+    Hit( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const override
+    {
+        _ShearedRay shearedRay( i_ray );
+        bool        objectHit = false;
+        TraverseLinearBVH(
+            m_nodes, i_ray, i_magnitudeRange, [&]( const LinearBVHNode& i_leaf, gm::FloatRange& io_magnitudeRange ) {
+                int packetEnd = i_leaf.m_offset + _PacketCount( i_leaf.m_objectCount );
+                for ( int packetIndex = i_leaf.m_offset; packetIndex < packetEnd; ++packetIndex )
+                {
+                    _PacketHit packetHit;
+                    if ( _IntersectPacket( m_packets[ packetIndex ], shearedRay, io_magnitudeRange, packetHit ) )
+                    {
+                        // Narrow the accepted range, such that only nearer hits are recorded from here on.
+                        objectHit                 = true;
+                        io_magnitudeRange.Max()   = packetHit.m_magnitude;
+                        o_record.m_magnitude      = packetHit.m_magnitude;
+                        o_record.m_uv             = packetHit.m_barycentric;
+                        o_record.m_primitiveIndex = packetHit.m_triangleIndex;
+                        o_record.m_material       = m_material.get();
+                        o_record.m_object         = this;
+                    }
+                }
+                return false;
+            } );
+        return objectHit;
+    }
+
+    virtual inline bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const override
+    {
+        // Any hit will do, so the traversal stops at the first.
+        _ShearedRay shearedRay( i_ray );
+        return TraverseLinearBVH(
+            m_nodes, i_ray, i_magnitudeRange, [&]( const LinearBVHNode& i_leaf, gm::FloatRange& io_magnitudeRange ) {
+                int packetEnd = i_leaf.m_offset + _PacketCount( i_leaf.m_objectCount );
+                for ( int packetIndex = i_leaf.m_offset; packetIndex < packetEnd; ++packetIndex )
+                {
+                    _PacketHit packetHit;
+                    if ( _IntersectPacket( m_packets[ packetIndex ], shearedRay, io_magnitudeRange, packetHit ) )
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            } );
+    }
+
+    virtual inline void ComputeSurfaceInteraction( const raytrace::Ray& i_ray, HitRecord& io_record ) const override
+    {
+        // The texture coordinates hold the barycentric coordinates of the second & third vertices, recorded by Hit.
+        const int* vertexIndices = &m_data->m_indices[ 3 * io_record.m_primitiveIndex ];
+        float      weights[ 3 ]  = {
+            1.0f - io_record.m_uv[ 0 ] - io_record.m_uv[ 1 ], io_record.m_uv[ 0 ], io_record.m_uv[ 1 ]};
+
+        const std::vector< gm::Vec3f >& positions = m_data->m_positions;
+        io_record.m_position = positions[ vertexIndices[ 0 ] ] * weights[ 0 ] +
+                               positions[ vertexIndices[ 1 ] ] * weights[ 1 ] +
+                               positions[ vertexIndices[ 2 ] ] * weights[ 2 ];
+
+        if ( m_data->m_normals.empty() )
+        {
+            io_record.m_normal = gm::Normalize(
+                gm::CrossProduct( positions[ vertexIndices[ 1 ] ] - positions[ vertexIndices[ 0 ] ],
+                                  positions[ vertexIndices[ 2 ] ] - positions[ vertexIndices[ 0 ] ] ) );
+        }
+        else
+        {
+            const std::vector< gm::Vec3f >& normals = m_data->m_normals;
+            io_record.m_normal = gm::Normalize( normals[ vertexIndices[ 0 ] ] * weights[ 0 ] +
+                                                normals[ vertexIndices[ 1 ] ] * weights[ 1 ] +
+                                                normals[ vertexIndices[ 2 ] ] * weights[ 2 ] );
+        }
+
+        if ( !m_data->m_uvs.empty() )
+        {
+            const std::vector< gm::Vec2f >& uvs = m_data->m_uvs;
+            io_record.m_uv = uvs[ vertexIndices[ 0 ] ] * weights[ 0 ] + uvs[ vertexIndices[ 1 ] ] * weights[ 1 ] +
+                             uvs[ vertexIndices[ 2 ] ] * weights[ 2 ];
+        }
+    }
+
+    virtual inline gm::Vec3fRange Extent( const std::vector< float >& i_times ) const override
+    {
+        if ( m_nodes.empty() )
+        {
+            return gm::Vec3fRange();
+        }
+
+        return gm::Vec3fRange( m_nodes[ 0 ].m_min, m_nodes[ 0 ].m_max );
+    }
+
+    /// Get the vertex & index buffers of the mesh.
+    inline const TriangleMeshData& Data() const
+    {
+        return *m_data;
+    }
+
+private:
+    // The number of triangles in a packet, intersected at once.
+    static constexpr int c_packetWidth = 4;
+
+    // Up to 4 triangles of a leaf.  Lanes past the last triangle of the leaf repeat it.
+    class _TrianglePacket
+    {
+    public:
+        // The position of each vertex, per axis, of each lane.
+        float m_vertices[ 3 ][ 3 ][ c_packetWidth ];
+
+        // The index of the triangle of each lane.
+        int32_t m_triangleIndices[ c_packetWidth ];
+    };
+
+    // The nearest hit within a packet.
+    class _PacketHit
+    {
+    public:
+        float     m_magnitude = 0.0f;
+        gm::Vec2f m_barycentric;
+        int       m_triangleIndex = 0;
+    };
+
+    // A ray transformed, once, for the watertight test.  The axes are permuted such that the ray travels mostly
+    // along the last, then sheared such that it travels exactly along the last.
+    class _ShearedRay
+    {
+    public:
+        inline explicit _ShearedRay( const raytrace::Ray& i_ray )
+        {
+            const gm::Vec3f& direction = i_ray.Direction();
+            int              axisZ     = 0;
+            for ( int axis = 1; axis < 3; ++axis )
+            {
+                if ( std::abs( direction[ axis ] ) > std::abs( direction[ axisZ ] ) )
+                {
+                    axisZ = axis;
+                }
+            }
+
+            // Swap the other two axes of rays travelling backwards, to preserve the winding of the triangles.
+            int axisX = ( axisZ + 1 ) % 3;
+            int axisY = ( axisX + 1 ) % 3;
+            if ( direction[ axisZ ] < 0.0f )
+            {
+                std::swap( axisX, axisY );
+            }
+
+            m_axes[ 0 ]   = axisX;
+            m_axes[ 1 ]   = axisY;
+            m_axes[ 2 ]   = axisZ;
+            m_origin[ 0 ] = i_ray.Origin()[ axisX ];
+            m_origin[ 1 ] = i_ray.Origin()[ axisY ];
+            m_origin[ 2 ] = i_ray.Origin()[ axisZ ];
+            m_shear[ 0 ]  = direction[ axisX ] / direction[ axisZ ];
+            m_shear[ 1 ]  = direction[ axisY ] / direction[ axisZ ];
+            m_shear[ 2 ]  = 1.0f / direction[ axisZ ];
+        }
+
+        int   m_axes[ 3 ];
+        float m_origin[ 3 ];
+        float m_shear[ 3 ];
+    };
+
+    // Get the number of packets holding \p i_triangleCount triangles.
+    static inline int _PacketCount( int i_triangleCount )
+    {
+        return ( i_triangleCount + c_packetWidth - 1 ) / c_packetWidth;
+    }
+
+    // Build the hierarchy over the triangles, then gather the triangles of each leaf into packets.
+    inline void _Build( int i_threadCount )
+    {
+        const std::vector< gm::Vec3f >& positions = m_data->m_positions;
+        const std::vector< int >&        indices   = m_data->m_indices;
+
+        std::vector< gm::Vec3fRange > extents( m_data->TriangleCount() );
+        for ( size_t triangleIndex = 0; triangleIndex < extents.size(); ++triangleIndex )
+        {
+            for ( int vertex = 0; vertex < 3; ++vertex )
+            {
+                extents[ triangleIndex ] =
+                    gm::Expand( extents[ triangleIndex ], positions[ indices[ 3 * triangleIndex + vertex ] ] );
+            }
+        }
+
+        SAHBVHBuilder                   builder( /* binCount */ 16, /* leafSize */ c_packetWidth, i_threadCount );
+        std::vector< int >              orderedTriangles;
+        std::unique_ptr< BVHBuildNode > root = builder.BuildExtents( extents, orderedTriangles );
+        if ( root == nullptr )
+        {
+            return;
+        }
+
+        FlattenBVH( *root, m_nodes );
+
+        // Leaves are re-pointed from their range of ordered triangles to their range of packets.
+        for ( LinearBVHNode& node : m_nodes )
+        {
+            if ( !node.IsLeaf() )
+            {
+                continue;
+            }
+
+            int packetOffset = m_packets.size();
+            for ( int packetStart = 0; packetStart < node.m_objectCount; packetStart += c_packetWidth )
+            {
+                _TrianglePacket packet;
+                for ( int lane = 0; lane < c_packetWidth; ++lane )
+                {
+                    int triangleIndex =
+                        orderedTriangles[ node.m_offset + std::min( packetStart + lane, node.m_objectCount - 1 ) ];
+                    packet.m_triangleIndices[ lane ] = triangleIndex;
+                    for ( int vertex = 0; vertex < 3; ++vertex )
+                    {
+                        const gm::Vec3f& position = positions[ indices[ 3 * triangleIndex + vertex ] ];
+                        for ( int axis = 0; axis < 3; ++axis )
+                        {
+                            packet.m_vertices[ vertex ][ axis ][ lane ] = position[ axis ];
+                        }
+                    }
+                }
+                m_packets.push_back( packet );
+            }
+
+            node.m_offset = packetOffset;
+        }
+    }
+
+    // Intersect the triangles of \p i_packet with \p i_ray, and record the nearest hit within \p i_magnitudeRange.
+    //
+    // Returns whether any triangle was hit.
+    static inline bool _IntersectPacket( const _TrianglePacket& i_packet,
+                                         const _ShearedRay&     i_ray,
+                                         const gm::FloatRange&  i_magnitudeRange,
+                                         _PacketHit&            o_hit )
+    {
+        // Per lane, the sheared vertex coordinates, then the scaled barycentric coordinates, determinant and
+        // magnitude.
+        float shearedX[ 3 ][ c_packetWidth ];
+        float shearedY[ 3 ][ c_packetWidth ];
+        float edges[ 3 ][ c_packetWidth ];
+        float determinants[ c_packetWidth ];
+        float magnitudes[ c_packetWidth ];
+        int   hitMask = 0;
+
+#if defined( __SSE2__ )
+        __m128 shearedZ[ 3 ];
+        for ( int vertex = 0; vertex < 3; ++vertex )
+        {
+            // Translate to the ray origin, permute, then shear.
+            __m128 x = _mm_sub_ps( _mm_loadu_ps( i_packet.m_vertices[ vertex ][ i_ray.m_axes[ 0 ] ] ),
+                                   _mm_set1_ps( i_ray.m_origin[ 0 ] ) );
+            __m128 y = _mm_sub_ps( _mm_loadu_ps( i_packet.m_vertices[ vertex ][ i_ray.m_axes[ 1 ] ] ),
+                                   _mm_set1_ps( i_ray.m_origin[ 1 ] ) );
+            __m128 z = _mm_sub_ps( _mm_loadu_ps( i_packet.m_vertices[ vertex ][ i_ray.m_axes[ 2 ] ] ),
+                                   _mm_set1_ps( i_ray.m_origin[ 2 ] ) );
+            _mm_storeu_ps( shearedX[ vertex ], _mm_sub_ps( x, _mm_mul_ps( _mm_set1_ps( i_ray.m_shear[ 0 ] ), z ) ) );
+            _mm_storeu_ps( shearedY[ vertex ], _mm_sub_ps( y, _mm_mul_ps( _mm_set1_ps( i_ray.m_shear[ 1 ] ), z ) ) );
+            shearedZ[ vertex ] = _mm_mul_ps( _mm_set1_ps( i_ray.m_shear[ 2 ] ), z );
+        }
+
+        // Edge function of each edge, opposite to each vertex.
+        __m128 edge[ 3 ];
+        for ( int vertex = 0; vertex < 3; ++vertex )
+        {
+            int first      = ( vertex + 1 ) % 3;
+            int second     = ( vertex + 2 ) % 3;
+            edge[ vertex ] = _mm_sub_ps(
+                _mm_mul_ps( _mm_loadu_ps( shearedX[ second ] ), _mm_loadu_ps( shearedY[ first ] ) ),
+                _mm_mul_ps( _mm_loadu_ps( shearedY[ second ] ), _mm_loadu_ps( shearedX[ first ] ) ) );
+        }
+
+        // Edge functions of exactly zero are re-computed in double precision, such that a ray through an edge is
+        // consistently assigned to one of its triangles.
+        __m128 zero     = _mm_setzero_ps();
+        int    zeroMask = _mm_movemask_ps( _mm_or_ps( _mm_or_ps( _mm_cmpeq_ps( edge[ 0 ], zero ),
+                                                                 _mm_cmpeq_ps( edge[ 1 ], zero ) ),
+                                                      _mm_cmpeq_ps( edge[ 2 ], zero ) ) );
+        if ( zeroMask != 0 )
+        {
+            for ( int vertex = 0; vertex < 3; ++vertex )
+            {
+                _mm_storeu_ps( edges[ vertex ], edge[ vertex ] );
+            }
+            for ( int lane = 0; lane < c_packetWidth; ++lane )
+            {
+                if ( zeroMask & ( 1 << lane ) )
+                {
+                    _ComputeEdgesDouble( shearedX, shearedY, lane, edges );
+                }
+            }
+            for ( int vertex = 0; vertex < 3; ++vertex )
+            {
+                edge[ vertex ] = _mm_loadu_ps( edges[ vertex ] );
+            }
+        }
+
+        // The ray misses if the edge functions differ in sign.
+        __m128 anyNegative = _mm_or_ps( _mm_or_ps( _mm_cmplt_ps( edge[ 0 ], zero ), _mm_cmplt_ps( edge[ 1 ], zero ) ),
+                                        _mm_cmplt_ps( edge[ 2 ], zero ) );
+        __m128 anyPositive = _mm_or_ps( _mm_or_ps( _mm_cmpgt_ps( edge[ 0 ], zero ), _mm_cmpgt_ps( edge[ 1 ], zero ) ),
+                                        _mm_cmpgt_ps( edge[ 2 ], zero ) );
+        __m128 determinant = _mm_add_ps( _mm_add_ps( edge[ 0 ], edge[ 1 ] ), edge[ 2 ] );
+        __m128 scaledMagnitude =
+            _mm_add_ps( _mm_add_ps( _mm_mul_ps( edge[ 0 ], shearedZ[ 0 ] ), _mm_mul_ps( edge[ 1 ], shearedZ[ 1 ] ) ),
+                        _mm_mul_ps( edge[ 2 ], shearedZ[ 2 ] ) );
+        __m128 magnitude = _mm_div_ps( scaledMagnitude, determinant );
+
+        __m128 valid = _mm_andnot_ps( _mm_and_ps( anyNegative, anyPositive ), _mm_cmpneq_ps( determinant, zero ) );
+        valid        = _mm_and_ps( valid, _mm_cmpge_ps( magnitude, _mm_set1_ps( i_magnitudeRange.Min() ) ) );
+        valid        = _mm_and_ps( valid, _mm_cmple_ps( magnitude, _mm_set1_ps( i_magnitudeRange.Max() ) ) );
+        hitMask      = _mm_movemask_ps( valid );
+        if ( hitMask == 0 )
+        {
+            return false;
+        }
+
+        for ( int vertex = 0; vertex < 3; ++vertex )
+        {
+            _mm_storeu_ps( edges[ vertex ], edge[ vertex ] );
+        }
+        _mm_storeu_ps( determinants, determinant );
+        _mm_storeu_ps( magnitudes, magnitude );
+#else
+        for ( int lane = 0; lane < c_packetWidth; ++lane )
+        {
+            // Translate to the ray origin, permute, then shear.
+            float shearedZ[ 3 ];
+            for ( int vertex = 0; vertex < 3; ++vertex )
+            {
+                float x = i_packet.m_vertices[ vertex ][ i_ray.m_axes[ 0 ] ][ lane ] - i_ray.m_origin[ 0 ];
+                float y = i_packet.m_vertices[ vertex ][ i_ray.m_axes[ 1 ] ][ lane ] - i_ray.m_origin[ 1 ];
+                float z = i_packet.m_vertices[ vertex ][ i_ray.m_axes[ 2 ] ][ lane ] - i_ray.m_origin[ 2 ];
+                shearedX[ vertex ][ lane ] = x - i_ray.m_shear[ 0 ] * z;
+                shearedY[ vertex ][ lane ] = y - i_ray.m_shear[ 1 ] * z;
+                shearedZ[ vertex ]         = i_ray.m_shear[ 2 ] * z;
+            }
+
+            // Edge function of each edge, opposite to each vertex.  Edge functions of exactly zero are re-computed
+            // in double precision, such that a ray through an edge is consistently assigned to one of its triangles.
+            for ( int vertex = 0; vertex < 3; ++vertex )
+            {
+                int first               = ( vertex + 1 ) % 3;
+                int second              = ( vertex + 2 ) % 3;
+                edges[ vertex ][ lane ] = shearedX[ second ][ lane ] * shearedY[ first ][ lane ] -
+                                          shearedY[ second ][ lane ] * shearedX[ first ][ lane ];
+            }
+            if ( edges[ 0 ][ lane ] == 0.0f || edges[ 1 ][ lane ] == 0.0f || edges[ 2 ][ lane ] == 0.0f )
+            {
+                _ComputeEdgesDouble( shearedX, shearedY, lane, edges );
+            }
+
+            // The ray misses if the edge functions differ in sign.
+            bool anyNegative = edges[ 0 ][ lane ] < 0.0f || edges[ 1 ][ lane ] < 0.0f || edges[ 2 ][ lane ] < 0.0f;
+            bool anyPositive = edges[ 0 ][ lane ] > 0.0f || edges[ 1 ][ lane ] > 0.0f || edges[ 2 ][ lane ] > 0.0f;
+            determinants[ lane ] = edges[ 0 ][ lane ] + edges[ 1 ][ lane ] + edges[ 2 ][ lane ];
+            if ( ( anyNegative && anyPositive ) || determinants[ lane ] == 0.0f )
+            {
+                continue;
+            }
+
+            magnitudes[ lane ] = ( edges[ 0 ][ lane ] * shearedZ[ 0 ] + edges[ 1 ][ lane ] * shearedZ[ 1 ] +
+                                   edges[ 2 ][ lane ] * shearedZ[ 2 ] ) /
+                                 determinants[ lane ];
+            if ( magnitudes[ lane ] >= i_magnitudeRange.Min() && magnitudes[ lane ] <= i_magnitudeRange.Max() )
+            {
+                hitMask |= 1 << lane;
+            }
+        }
+
+        if ( hitMask == 0 )
+        {
+            return false;
+        }
+#endif
+
+        // Select the nearest lane hit.
+        int nearestLane = -1;
+        for ( int lane = 0; lane < c_packetWidth; ++lane )
+        {
+            if ( ( hitMask & ( 1 << lane ) ) && ( nearestLane < 0 || magnitudes[ lane ] < magnitudes[ nearestLane ] ) )
+            {
+                nearestLane = lane;
+            }
+        }
+
+        float inverseDeterminant = 1.0f / determinants[ nearestLane ];
+        o_hit.m_magnitude        = magnitudes[ nearestLane ];
+        o_hit.m_barycentric      = gm::Vec2f( edges[ 1 ][ nearestLane ] * inverseDeterminant,
+                                              edges[ 2 ][ nearestLane ] * inverseDeterminant );
+        o_hit.m_triangleIndex    = i_packet.m_triangleIndices[ nearestLane ];
+        return true;
+    }
+
+    // Re-compute the edge functions of lane \p i_lane in double precision.
+    static inline void _ComputeEdgesDouble( const float i_shearedX[ 3 ][ c_packetWidth ],
+                                            const float i_shearedY[ 3 ][ c_packetWidth ],
+                                            int         i_lane,
+                                            float       io_edges[ 3 ][ c_packetWidth ] )
+    {
+        for ( int vertex = 0; vertex < 3; ++vertex )
+        {
+            int first                    = ( vertex + 1 ) % 3;
+            int second                   = ( vertex + 2 ) % 3;
+            io_edges[ vertex ][ i_lane ] = ( float ) ( ( double ) i_shearedX[ second ][ i_lane ] *
+                                                           ( double ) i_shearedY[ first ][ i_lane ] -
+                                                       ( double ) i_shearedY[ second ][ i_lane ] *
+                                                           ( double ) i_shearedX[ first ][ i_lane ] );
+        }
+    }
+
+    TriangleMeshDataSharedPtr m_data;
+    MaterialSharedPtr         m_material;
+
+    // Flattened hierarchy over the triangles.  Leaves reference a range of packets.
+    std::vector< LinearBVHNode > m_nodes;
+
+    // Triangle packets, in the order of the leaves.
+    std::vector< _TrianglePacket > m_packets;
+};
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,71 @@
+#pragma once
+
+/// \file raytrace/triangleMeshData.h
+///
+/// Vertex & index buffers of a triangle mesh.
+
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec2f.h>
+#include <gm/types/vec3f.h>
+
+#include <memory>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class TriangleMeshData
+///
+/// TriangleMeshData holds the buffers describing a triangle mesh.  Each vertex attribute is stored in its own
+/// contiguous array, indexed by vertex, and each triangle is referenced by its index into the triangle list.
+///
+/// The buffers are shared, read-only, by the \ref TriangleMesh objects built from them.
+class TriangleMeshData
+{
+public:
+    /// Get the number of triangles.
+    inline int TriangleCount() const
+    {
+        return m_indices.size() / 3;
+    }
+
+    /// Check if the buffers are consistent: every attribute is either absent or specified per vertex, and every
+    /// index references a vertex.
+    inline bool IsValid() const
+    {
+        if ( m_indices.size() % 3 != 0 || ( !m_normals.empty() && m_normals.size() != m_positions.size() ) ||
+             ( !m_uvs.empty() && m_uvs.size() != m_positions.size() ) )
+        {
+            return false;
+        }
+
+        for ( int vertexIndex : m_indices )
+        {
+            if ( vertexIndex < 0 || vertexIndex >= ( int ) m_positions.size() )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// The position of each vertex.
+    std::vector< gm::Vec3f > m_positions;
+
+    /// The shading normal of each vertex.  Optional, the geometric normal is used if empty.
+    std::vector< gm::Vec3f > m_normals;
+
+    /// The texture coordinate of each vertex.  Optional, the barycentric coordinates are used if empty.
+    std::vector< gm::Vec2f > m_uvs;
+
+    /// The three vertex indices of each triangle, counter-clockwise about the outward facing normal.
+    std::vector< int > m_indices;
+};
+
+/// \typedef TriangleMeshDataSharedPtr
+///
+/// Shared pointer to read-only triangle mesh buffers.
+using TriangleMeshDataSharedPtr = std::shared_ptr< const TriangleMeshData >;
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,460 @@
+#pragma once
+
+/// \file raytrace/wideBVH.h
+///
+/// Bounding volume hierarchy with 4 or 8 children per node, traversed with SIMD box tests.
+///
+/// The SIMD kernels are selected at compile time.  8-wide nodes are tested with AVX2 instructions when
+/// available (see the ENABLE_AVX2 build option), otherwise with two SSE tests.  Without SSE, a scalar
+/// implementation is used.
+
+#include <raytrace/bvhBuildNode.h>
+#include <raytrace/bvhTraversal.h>
+#include <raytrace/hitRecord.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/base/diagnostic.h>
+
+#include <gm/types/floatRange.h>
+#include <gm/types/vec3f.h>
+#include <gm/types/vec3fRange.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#elif defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+RAYTRACE_NS_OPEN
+
+/// \class WideBVHNode
+///
+/// WideBVHNode is a single node of a \ref WideBVH, with up to \p N children.
+///
+/// The child extents are stored in structure-of-arrays form, such that the same plane of every child can be
+/// loaded into a single SIMD register.
+///
+/// Each child slot is one of:
+/// - a leaf, if its object count is greater than zero.  The child index is then the offset of the first object.
+/// - an interior node, if its child index is non-negative.  The child index is then the index of the node.
+/// - empty, otherwise.  Empty slots have an inverted extent, which can never be hit.
+template < int N >
+class WideBVHNode
+{
+public:
+    inline WideBVHNode()
+    {
+        for ( int slot = 0; slot < N; ++slot )
+        {
+            m_minX[ slot ] = m_minY[ slot ] = m_minZ[ slot ] = std::numeric_limits< float >::infinity();
+            m_maxX[ slot ] = m_maxY[ slot ] = m_maxZ[ slot ] = -std::numeric_limits< float >::infinity();
+            m_childIndex[ slot ]                             = -1;
+            m_objectCount[ slot ]                            = 0;
+        }
+    }
+
+    /// Extent minimum & maximum of each child, per axis.
+    float m_minX[ N ];
+    float m_minY[ N ];
+    float m_minZ[ N ];
+    float m_maxX[ N ];
+    float m_maxY[ N ];
+    float m_maxZ[ N ];
+
+    /// Node index, or object offset, of each child.
+    int32_t m_childIndex[ N ];
+
+    /// Number of objects in each leaf child.  Zero for interior or empty children.
+    int32_t m_objectCount[ N ];
+};
+
+/// \class WideBVH
+///
+/// WideBVH is a bounding volume hierarchy where each node has up to \p N children, collapsed from a binary
+/// \ref BVHBuildNode tree.
+///
+/// Collapsing repeatedly replaces the child with the largest surface area by its own two children, until
+/// the node is full.  A ray is tested against all the children of a node at once, and the hit children are
+/// then visited nearest first.
+///
+/// \tparam N The maximum number of children per node.  Either 4 or 8.
+template < int N >
+class WideBVH : public SceneObject
+{
+    static_assert( N == 4 || N == 8, "WideBVH supports 4 or 8 children per node." );
+
+public:
+    /// Collapse a binary build tree into a wide BVH.
+    ///
+    /// \param i_root The root node of the build tree.
+    /// \param i_orderedObjects The ordered scene objects, which leaves of the build tree reference.
+    inline explicit WideBVH( const BVHBuildNode& i_root, const SceneObjectPtrs& i_orderedObjects )
+        : m_extent( i_root.m_extent )
+        , m_objectPtrs( i_orderedObjects )
+    {
+        m_objects.reserve( m_objectPtrs.size() );
+        for ( const SceneObjectPtr& objectPtr : m_objectPtrs )
+        {
+            m_objects.push_back( objectPtr.get() );
+        }
+
+        std::vector< const BVHBuildNode* > rootChildren( 1, &i_root );
+        _Collapse( rootChildren );
+    }
+
+    virtual inline bool
+    Hit( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const override
+    {
+        bool objectHit = false;
+        _Traverse( i_ray, i_magnitudeRange, [&]( const SceneObject& i_object, gm::FloatRange& io_magnitudeRange ) {
+            if ( i_object.Hit( i_ray, io_magnitudeRange, o_record ) )
+            {
+                // Narrow the accepted range, such that only nearer hits are recorded from here on.
+                objectHit               = true;
+                io_magnitudeRange.Max() = o_record.m_magnitude;
+            }
+            return false;
+        } );
+        return objectHit;
+    }
+
+    virtual inline bool Occluded( const raytrace::Ray& i_ray, const gm::FloatRange& i_magnitudeRange ) const override
+    {
+        // Any hit will do, so the traversal stops at the first.
+        return _Traverse( i_ray,
+                          i_magnitudeRange,
+                          [&]( const SceneObject& i_object, gm::FloatRange& io_magnitudeRange ) {
+                              return i_object.Occluded( i_ray, io_magnitudeRange );
+                          } );
+    }
+
+    virtual inline gm::Vec3fRange Extent( const std::vector< float >& i_times ) const override
+    {
+        return m_extent;
+    }
+
+    /// Get the nodes.  The first node is the root.
+    inline const std::vector< WideBVHNode< N > >& Nodes() const
+    {
+        return m_nodes;
+    }
+
+private:
+    // Maximum depth of the traversal stack.  Each wide node collapses at least one interior node of the build
+    // tree, and defers all but one of its children.
+    static constexpr int c_maxStackDepth = c_bvhMaxDepth * ( N - 1 ) + 1;
+
+    // A deferred child to visit, with the distance to its extent.
+    class _StackEntry
+    {
+    public:
+        int32_t m_childIndex;
+        int32_t m_objectCount;
+        float   m_distance;
+    };
+
+    // Traverse the nodes intersected by \p i_ray within \p i_magnitudeRange, near to far, calling
+    // \p i_intersectObject with each object of the leaves reached, and the accepted magnitude range, which it may
+    // narrow.  Traversal stops as soon as \p i_intersectObject returns true.
+    //
+    // Returns whether traversal was stopped.
+    template < typename IntersectObjectFunctionT >
+    inline bool _Traverse( const raytrace::Ray&     i_ray,
+                           const gm::FloatRange&    i_magnitudeRange,
+                           IntersectObjectFunctionT i_intersectObject ) const
+    {
+        // Pre-compute the inverse direction, and the direction sign for each axis.
+        float origin[ 3 ]              = {i_ray.Origin()[ 0 ], i_ray.Origin()[ 1 ], i_ray.Origin()[ 2 ]};
+        float inverseDirection[ 3 ]    = {1.0f / i_ray.Direction()[ 0 ],
+                                       1.0f / i_ray.Direction()[ 1 ],
+                                       1.0f / i_ray.Direction()[ 2 ]};
+        bool  directionIsNegative[ 3 ] = {inverseDirection[ 0 ] < 0.0f,
+                                         inverseDirection[ 1 ] < 0.0f,
+                                         inverseDirection[ 2 ] < 0.0f};
+
+        gm::FloatRange magnitudeRange( i_magnitudeRange );
+
+        _StackEntry stack[ c_maxStackDepth ];
+        int         stackSize = 0;
+        stack[ stackSize++ ]  = _StackEntry{0, 0, i_magnitudeRange.Min()};
+        while ( stackSize > 0 )
+        {
+            const _StackEntry entry = stack[ --stackSize ];
+            if ( entry.m_distance > magnitudeRange.Max() )
+            {
+                // A nearer hit has been found since this entry was pushed.
+                continue;
+            }
+
+            if ( entry.m_objectCount > 0 )
+            {
+                for ( int objectIndex = entry.m_childIndex; objectIndex < entry.m_childIndex + entry.m_objectCount;
+                      ++objectIndex )
+                {
+                    if ( i_intersectObject( *m_objects[ objectIndex ], magnitudeRange ) )
+                    {
+                        return true;
+                    }
+                }
+                continue;
+            }
+
+            // Test all the children at once.
+            const WideBVHNode< N >& node = m_nodes[ entry.m_childIndex ];
+            float                   distances[ N ];
+            int                     hitMask = _IntersectChildren( node,
+                                                origin,
+                                                inverseDirection,
+                                                directionIsNegative,
+                                                magnitudeRange,
+                                                distances );
+
+            // Order the hit children from farthest to nearest, by insertion sort.
+            int hitSlots[ N ];
+            int hitCount = 0;
+            for ( int slot = 0; slot < N; ++slot )
+            {
+                if ( !( hitMask & ( 1 << slot ) ) )
+                {
+                    continue;
+                }
+
+                int insertIndex = hitCount++;
+                while ( insertIndex > 0 && distances[ hitSlots[ insertIndex - 1 ] ] < distances[ slot ] )
+                {
+                    hitSlots[ insertIndex ] = hitSlots[ insertIndex - 1 ];
+                    --insertIndex;
+                }
+                hitSlots[ insertIndex ] = slot;
+            }
+
+            // Push such that the nearest child is popped first.
+            GM_ASSERT( stackSize + hitCount <= c_maxStackDepth );
+            for ( int hitIndex = 0; hitIndex < hitCount; ++hitIndex )
+            {
+                int slot             = hitSlots[ hitIndex ];
+                stack[ stackSize++ ] = _StackEntry{node.m_childIndex[ slot ],
+                                                   node.m_objectCount[ slot ],
+                                                   distances[ slot ]};
+            }
+        }
+
+        return false;
+    }
+
+    // Append a node holding \p i_children, collapsing interior build nodes until the node is full.
+    //
+    // Returns the index of the appended node.
+    inline int _Collapse( std::vector< const BVHBuildNode* >& io_children )
+    {
+        while ( ( int ) io_children.size() < N )
+        {
+            // Find the interior child with the largest surface area.
+            int   expandIndex = -1;
+            float expandArea  = -1.0f;
+            for ( size_t childIndex = 0; childIndex < io_children.size(); ++childIndex )
+            {
+                float area = SurfaceArea( io_children[ childIndex ]->m_extent );
+                if ( !io_children[ childIndex ]->IsLeaf() && area > expandArea )
+                {
+                    expandIndex = childIndex;
+                    expandArea  = area;
+                }
+            }
+
+            if ( expandIndex < 0 )
+            {
+                break;
+            }
+
+            // Replace it by its own children.
+            const BVHBuildNode* expandNode = io_children[ expandIndex ];
+            io_children[ expandIndex ]     = expandNode->m_children[ 0 ].get();
+            io_children.push_back( expandNode->m_children[ 1 ].get() );
+        }
+
+        int nodeIndex = m_nodes.size();
+        m_nodes.push_back( WideBVHNode< N >() );
+        for ( size_t slot = 0; slot < io_children.size(); ++slot )
+        {
+            const BVHBuildNode* child = io_children[ slot ];
+
+            int childIndex = 0;
+            if ( child->IsLeaf() )
+            {
+                childIndex = child->m_objectOffset;
+            }
+            else
+            {
+                std::vector< const BVHBuildNode* > grandChildren = {child->m_children[ 0 ].get(),
+                                                                    child->m_children[ 1 ].get()};
+                childIndex                                       = _Collapse( grandChildren );
+            }
+
+            // The node array may have been re-allocated by the recursion above.
+            WideBVHNode< N >& node     = m_nodes[ nodeIndex ];
+            node.m_minX[ slot ]        = child->m_extent.Min()[ 0 ];
+            node.m_minY[ slot ]        = child->m_extent.Min()[ 1 ];
+            node.m_minZ[ slot ]        = child->m_extent.Min()[ 2 ];
+            node.m_maxX[ slot ]        = child->m_extent.Max()[ 0 ];
+            node.m_maxY[ slot ]        = child->m_extent.Max()[ 1 ];
+            node.m_maxZ[ slot ]        = child->m_extent.Max()[ 2 ];
+            node.m_childIndex[ slot ]  = childIndex;
+            node.m_objectCount[ slot ] = child->IsLeaf() ? child->m_objectCount : 0;
+        }
+
+        return nodeIndex;
+    }
+
+    // Slab test the ray against the extents of all children of \p i_node.
+    //
+    // The distance to each child's extent is written into \p o_distances, and a bit mask of the children
+    // which are hit within the accepted range is returned.
+    static inline int _IntersectChildren( const WideBVHNode< N >& i_node,
+                                          const float*            i_origin,
+                                          const float*            i_inverseDirection,
+                                          const bool*             i_directionIsNegative,
+                                          const gm::FloatRange&   i_magnitudeRange,
+                                          float*                  o_distances )
+    {
+        // Select the near & far planes per axis, based on the direction sign.
+        const float* nearX = i_directionIsNegative[ 0 ] ? i_node.m_maxX : i_node.m_minX;
+        const float* nearY = i_directionIsNegative[ 1 ] ? i_node.m_maxY : i_node.m_minY;
+        const float* nearZ = i_directionIsNegative[ 2 ] ? i_node.m_maxZ : i_node.m_minZ;
+        const float* farX  = i_directionIsNegative[ 0 ] ? i_node.m_minX : i_node.m_maxX;
+        const float* farY  = i_directionIsNegative[ 1 ] ? i_node.m_minY : i_node.m_maxY;
+        const float* farZ  = i_directionIsNegative[ 2 ] ? i_node.m_minZ : i_node.m_maxZ;
+
+#if defined( __AVX2__ )
+        if ( N == 8 )
+        {
+            __m256 originX  = _mm256_set1_ps( i_origin[ 0 ] );
+            __m256 originY  = _mm256_set1_ps( i_origin[ 1 ] );
+            __m256 originZ  = _mm256_set1_ps( i_origin[ 2 ] );
+            __m256 inverseX = _mm256_set1_ps( i_inverseDirection[ 0 ] );
+            __m256 inverseY = _mm256_set1_ps( i_inverseDirection[ 1 ] );
+            __m256 inverseZ = _mm256_set1_ps( i_inverseDirection[ 2 ] );
+
+            // The accumulated value is passed as the second operand of min/max, such that a NaN plane distance
+            // (from a ray origin lying on a plane parallel to the ray) leaves it unchanged.
+            __m256 nearDistance = _mm256_set1_ps( i_magnitudeRange.Min() );
+            __m256 farDistance  = _mm256_set1_ps( i_magnitudeRange.Max() );
+            nearDistance        = _mm256_max_ps( _PlaneDistances8( nearX, originX, inverseX ), nearDistance );
+            nearDistance        = _mm256_max_ps( _PlaneDistances8( nearY, originY, inverseY ), nearDistance );
+            nearDistance        = _mm256_max_ps( _PlaneDistances8( nearZ, originZ, inverseZ ), nearDistance );
+            farDistance         = _mm256_min_ps( _PlaneDistances8( farX, originX, inverseX ), farDistance );
+            farDistance         = _mm256_min_ps( _PlaneDistances8( farY, originY, inverseY ), farDistance );
+            farDistance         = _mm256_min_ps( _PlaneDistances8( farZ, originZ, inverseZ ), farDistance );
+            farDistance         = _mm256_mul_ps( farDistance, _mm256_set1_ps( c_bvhFarDistanceScale ) );
+
+            _mm256_storeu_ps( o_distances, nearDistance );
+            return _mm256_movemask_ps( _mm256_cmp_ps( nearDistance, farDistance, _CMP_LE_OQ ) );
+        }
+#endif
+
+#if defined( __SSE2__ )
+        __m128 originX  = _mm_set1_ps( i_origin[ 0 ] );
+        __m128 originY  = _mm_set1_ps( i_origin[ 1 ] );
+        __m128 originZ  = _mm_set1_ps( i_origin[ 2 ] );
+        __m128 inverseX = _mm_set1_ps( i_inverseDirection[ 0 ] );
+        __m128 inverseY = _mm_set1_ps( i_inverseDirection[ 1 ] );
+        __m128 inverseZ = _mm_set1_ps( i_inverseDirection[ 2 ] );
+
+        int hitMask = 0;
+        for ( int lane = 0; lane < N; lane += 4 )
+        {
+            // The accumulated value is passed as the second operand of min/max, such that a NaN plane distance
+            // (from a ray origin lying on a plane parallel to the ray) leaves it unchanged.
+            __m128 nearDistance = _mm_set1_ps( i_magnitudeRange.Min() );
+            __m128 farDistance  = _mm_set1_ps( i_magnitudeRange.Max() );
+            nearDistance        = _mm_max_ps( _PlaneDistances4( nearX + lane, originX, inverseX ), nearDistance );
+            nearDistance        = _mm_max_ps( _PlaneDistances4( nearY + lane, originY, inverseY ), nearDistance );
+            nearDistance        = _mm_max_ps( _PlaneDistances4( nearZ + lane, originZ, inverseZ ), nearDistance );
+            farDistance         = _mm_min_ps( _PlaneDistances4( farX + lane, originX, inverseX ), farDistance );
+            farDistance         = _mm_min_ps( _PlaneDistances4( farY + lane, originY, inverseY ), farDistance );
+            farDistance         = _mm_min_ps( _PlaneDistances4( farZ + lane, originZ, inverseZ ), farDistance );
+            farDistance         = _mm_mul_ps( farDistance, _mm_set1_ps( c_bvhFarDistanceScale ) );
+
+            _mm_storeu_ps( o_distances + lane, nearDistance );
+            hitMask |= _mm_movemask_ps( _mm_cmple_ps( nearDistance, farDistance ) ) << lane;
+        }
+        return hitMask;
+#else
+        int hitMask = 0;
+        for ( int slot = 0; slot < N; ++slot )
+        {
+            float nearDistance = i_magnitudeRange.Min();
+            float farDistance  = i_magnitudeRange.Max();
+            nearDistance       = _Max( ( nearX[ slot ] - i_origin[ 0 ] ) * i_inverseDirection[ 0 ], nearDistance );
+            nearDistance       = _Max( ( nearY[ slot ] - i_origin[ 1 ] ) * i_inverseDirection[ 1 ], nearDistance );
+            nearDistance       = _Max( ( nearZ[ slot ] - i_origin[ 2 ] ) * i_inverseDirection[ 2 ], nearDistance );
+            farDistance        = _Min( ( farX[ slot ] - i_origin[ 0 ] ) * i_inverseDirection[ 0 ], farDistance );
+            farDistance        = _Min( ( farY[ slot ] - i_origin[ 1 ] ) * i_inverseDirection[ 1 ], farDistance );
+            farDistance        = _Min( ( farZ[ slot ] - i_origin[ 2 ] ) * i_inverseDirection[ 2 ], farDistance );
+            farDistance *= c_bvhFarDistanceScale;
+
+            o_distances[ slot ] = nearDistance;
+            if ( nearDistance <= farDistance )
+            {
+                hitMask |= 1 << slot;
+            }
+        }
+        return hitMask;
+#endif
+    }
+
+#if defined( __AVX2__ )
+    // Distances along the ray to 8 planes, perpendicular to a single axis.
+    static inline __m256 _PlaneDistances8( const float* i_planes, __m256 i_origin, __m256 i_inverseDirection )
+    {
+        return _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( i_planes ), i_origin ), i_inverseDirection );
+    }
+#endif
+
+#if defined( __SSE2__ )
+    // Distances along the ray to 4 planes, perpendicular to a single axis.
+    static inline __m128 _PlaneDistances4( const float* i_planes, __m128 i_origin, __m128 i_inverseDirection )
+    {
+        return _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( i_planes ), i_origin ), i_inverseDirection );
+    }
+#endif
+
+    // Scalar min & max, matching the NaN semantics of the SIMD instructions (the second operand is returned
+    // if either is NaN).
+    static inline float _Min( float i_lhs, float i_rhs )
+    {
+        return i_lhs < i_rhs ? i_lhs : i_rhs;
+    }
+
+    static inline float _Max( float i_lhs, float i_rhs )
+    {
+        return i_lhs > i_rhs ? i_lhs : i_rhs;
+    }
+
+    // Extent of the entire hierarchy.
+    gm::Vec3fRange m_extent;
+
+    // Nodes, with the root first.
+    std::vector< WideBVHNode< N > > m_nodes;
+
+    // Ordered objects referenced by the leaf children.  Raw pointers are used during traversal, to avoid
+    // reference counting, while the shared pointers retain ownership.
+    std::vector< const SceneObject* > m_objects;
+    SceneObjectPtrs                   m_objectPtrs;
+};
+
+/// \typedef BVH4
+///
+/// Wide BVH with 4 children per node.
+using BVH4 = WideBVH< 4 >;
+
+/// \typedef BVH8
+///
+/// Wide BVH with 8 children per node.
+using BVH8 = WideBVH< 8 >;
+
+RAYTRACE_NS_CLOSE